@@ -75,6 +75,8 @@ class MiLedgerConan(ConanFile):
         'qt/6.1.1',
         'restinio/0.6.9',
         'cxxopts/2.2.1',
+        'zlib/1.2.11',
+        'brotli/1.0.9',
     )
 
     build_requires = (
@@ -46,6 +46,26 @@ public:
         // result with device state
         result_get_device_state,
 
+        // fuzzy search of coins, validators and pools by local index: value is query, payload.limit is optional
+        action_search,
+        // result with ranked matches in payload.items
+        result_search,
+
+        // lookup in local transaction log: value is tx hash (Mt...) or counterparty address (Mx...),
+        // or empty with payload.from_block and payload.to_block. payload.limit is optional
+        action_tx_lookup,
+        // result with transactions in payload.items, oldest first
+        result_tx_lookup,
+
+        // rewards from local store: value is scale (minute, hour, day), payload.from is required, payload.to is optional,
+        // both as unix time or "YYYY-MM-DD HH:MM:SS" UTC
+        action_rewards,
+        // result with points in payload.items, oldest first, and payload.total of range;
+        // at most 1440 points per answer, payload.next_from is set when range continues past them
+        result_rewards,
+        // new reward points are stored, value is the last stored minute
+        event_rewards_updated,
+
     };
 
     const static std::unordered_map<type_t, std::string> map;
@@ -70,7 +90,8 @@ public:
             }
             if (j.find("payload") != j.end()) {
                 if (j.at("payload").is_object()) {
-                    out.payload = j.at("payload").get<std::unordered_map<std::string, std::string>>();
+                    // values are read by get_payload_value: numbers and strings are both accepted
+                    out.payload = j.at("payload");
                 }
             }
 
@@ -125,6 +146,25 @@ public:
         return j.dump();
     }
 
+    /// \brief Payload field as string: string as is, number as decimal
+    /// \return empty string if field is absent or has other type
+    std::string get_payload_value(const std::string& name) const {
+        if (!payload.is_object()) {
+            return {};
+        }
+        auto it = payload.find(name);
+        if (it == payload.end()) {
+            return {};
+        }
+        if (it->is_string()) {
+            return it->get<std::string>();
+        }
+        if (it->is_number_integer()) {
+            return it->dump();
+        }
+        return {};
+    }
+
     restinio::websocket::basic::message_t to_ws_message() const {
         restinio::websocket::basic::message_t out;
         out.set_opcode(restinio::websocket::basic::opcode_t::text_frame);
@@ -151,6 +191,13 @@ NLOHMANN_JSON_SERIALIZE_ENUM(miledger::ws_message::type_t, {
     {miledger::ws_message::type_t::result_sign_tx, "result_sign_tx"},
     {miledger::ws_message::type_t::action_get_device_state, "action_get_device_state"},
     {miledger::ws_message::type_t::result_get_device_state, "result_get_device_state"},
+    {miledger::ws_message::type_t::action_search, "action_search"},
+    {miledger::ws_message::type_t::result_search, "result_search"},
+    {miledger::ws_message::type_t::action_tx_lookup, "action_tx_lookup"},
+    {miledger::ws_message::type_t::result_tx_lookup, "result_tx_lookup"},
+    {miledger::ws_message::type_t::action_rewards, "action_rewards"},
+    {miledger::ws_message::type_t::result_rewards, "result_rewards"},
+    {miledger::ws_message::type_t::event_rewards_updated, "event_rewards_updated"},
     })
 // clang-format on
 
@@ -67,6 +67,9 @@ private:
     std::unique_ptr<router_t> requestHandler();
     restinio::request_handling_status_t handleHttpRequest(ws_message::type_t type, std::shared_ptr<restinio::request_t> req, const restinio::router::route_params_t& params) const;
     void handleRequestMessage(uint64_t recipient, const miledger::ws_message& message);
+    miledger::ws_message search(const std::string& query, const std::string& limit) const;
+    miledger::ws_message lookupTx(const std::string& value, const std::string& fromBlock, const std::string& toBlock, const std::string& limit) const;
+    miledger::ws_message rewards(const std::string& scale, const std::string& from, const std::string& to) const;
 
     void sendMessage(uint64_t recipient, const miledger::ws_message& message);
     void sendStatusMessage(uint64_t recipient, ws_message::type_t type, const std::string& message = "");
@@ -0,0 +1,105 @@
+/*!
+ * miledger.
+ * coin_completion_model.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_COIN_COMPLETION_MODEL_H
+#define MILEDGER_COIN_COMPLETION_MODEL_H
+
+#include "include/coin_model.h"
+
+#include <QAbstractListModel>
+#include <QCompleter>
+#include <QLineEdit>
+#include <QListView>
+#include <functional>
+#include <vector>
+
+/// \brief Completion rows of one input: coins matching typed prefix, found by prefix index of source model.
+/// Model keeps only row numbers, strings are taken from index for rows which view asks for, so popup with uniform
+/// item sizes touches only visible rows. Completer must work in unfiltered mode: filtering is done here.
+class CoinCompletionModel : public QAbstractListModel {
+public:
+    /// \brief Ids of coins similar to text, used when nothing starts with it (typo)
+    using FuzzySearch = std::function<std::vector<std::string>(const QString& text)>;
+
+private:
+    CoinModel& source;
+    QString prefix;
+    std::vector<uint32_t> rows;
+    FuzzySearch fuzzySearch;
+
+public:
+    CoinCompletionModel(CoinModel& source, QObject* parent = nullptr)
+        : QAbstractListModel(parent),
+          source(source) {
+        // coin list reloaded: rows point to old list
+        connect(&source, &QAbstractItemModel::modelReset, this, [this]() {
+            setPrefix(prefix);
+        });
+    }
+
+    /// \brief Attach completer of input to this model: rows are updated on each edit, before completer shows popup
+    void attach(QLineEdit* input, QCompleter* completer) {
+        completer->setCompletionColumn(0);
+        completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+        if (auto* view = qobject_cast<QListView*>(completer->popup())) {
+            view->setUniformItemSizes(true);
+        }
+        connect(input, &QLineEdit::textEdited, this, &CoinCompletionModel::setPrefix);
+    }
+
+    void setFuzzySearch(FuzzySearch search) {
+        fuzzySearch = std::move(search);
+    }
+
+    void setPrefix(const QString& value) {
+        beginResetModel();
+        prefix = value;
+        const auto& index = source.getPrefixIndex();
+        rows = index.find(prefix);
+        if (rows.empty() && fuzzySearch && !prefix.trimmed().isEmpty()) {
+            for (const auto& id : fuzzySearch(prefix)) {
+                const int row = index.rowById(QString::fromStdString(id));
+                if (row >= 0) {
+                    rows.push_back((uint32_t) row);
+                }
+            }
+        }
+        endResetModel();
+    }
+
+    int rowCount(const QModelIndex& parent) const override {
+        return parent.isValid() ? 0 : (int) rows.size();
+    }
+
+    QVariant data(const QModelIndex& index, int role) const override {
+        if (!index.isValid() || index.row() < 0 || index.row() >= ((int) rows.size())) {
+            return QVariant();
+        }
+
+        const auto& entry = source.getPrefixIndex().at(rows[index.row()]);
+        switch (role) {
+        case Qt::DisplayRole:
+        case Qt::EditRole:
+        case CoinModel::SymbolRole:
+            return entry.symbol;
+        case CoinModel::IdRole:
+            return entry.id;
+        case CoinModel::NameRole:
+            return entry.name;
+        case CoinModel::TypeRole:
+            return entry.type;
+        case CoinModel::AvatarUrlRole:
+            return entry.avatarUrl;
+        default:
+            return QVariant();
+        }
+    }
+};
+
+#endif // MILEDGER_COIN_COMPLETION_MODEL_H
@@ -10,6 +10,7 @@
 #ifndef MILEDGER_COIN_MODEL_H
 #define MILEDGER_COIN_MODEL_H
 
+#include "include/coin_prefix_index.h"
 #include "include/miledger-config.h"
 
 #include <QAbstractListModel>
@@ -20,6 +21,7 @@
 class CoinModel : public QAbstractListModel {
 private:
     std::vector<minter::explorer::coin_item> items;
+    miledger::CoinPrefixIndex prefixIndex;
 
 public:
     enum datarole {
@@ -78,10 +80,15 @@ public:
     }
 
     void setItems(const std::vector<minter::explorer::coin_item>& coins) {
-        beginInsertRows(QModelIndex(), 0, coins.size());
-        //        insertRows(0, coins->size(), QModelIndex());
+        // completion models re-query index on reset
+        beginResetModel();
         items = coins;
-        endInsertRows();
+        prefixIndex.build(items);
+        endResetModel();
+    }
+
+    const miledger::CoinPrefixIndex& getPrefixIndex() const {
+        return prefixIndex;
     }
 };
 
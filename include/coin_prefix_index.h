@@ -0,0 +1,68 @@
+/*!
+ * miledger.
+ * coin_prefix_index.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_COIN_PREFIX_INDEX_H
+#define MILEDGER_COIN_PREFIX_INDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <cstdint>
+#include <minter/api/explorer/explorer_results.h>
+#include <utility>
+#include <vector>
+
+namespace miledger {
+
+/// \brief Case-folded prefix index over coin symbols, with coin names as secondary key.
+/// Keys are kept in one sorted array (a flattened trie): all keys with the same prefix are one contiguous range,
+/// found with two binary searches, so lookup doesn't depend on count of coins.
+/// Display strings of each coin are built once here, so completion models don't create them on every data() call.
+class CoinPrefixIndex {
+public:
+    struct Entry {
+        QString id;
+        QString symbol;
+        QString name;
+        QString avatarUrl;
+        QVariant type;
+    };
+
+    /// \brief Rebuild index
+    /// \param coins coins in rank order: matches are returned in this order
+    void build(const std::vector<minter::explorer::coin_item>& coins);
+
+    /// \brief Find coins by prefix: coins which symbol starts with prefix, then coins which name or any word of name starts with it
+    /// \param prefix any case
+    /// \param limit max count of rows, 0 - no limit
+    /// \return rows of matched coins
+    std::vector<uint32_t> find(const QString& prefix, size_t limit = 0) const;
+
+    /// \brief Row of coin by id
+    /// \return -1 if not found
+    int rowById(const QString& id) const;
+    const Entry& at(uint32_t row) const;
+    size_t size() const;
+
+private:
+    using key_t = std::pair<QString, uint32_t>;
+
+    /// \brief Rows of keys starting with prefix, sorted
+    static std::vector<uint32_t> findRange(const std::vector<key_t>& keys, const QString& folded);
+
+    std::vector<Entry> mEntries;
+    // sorted by folded key, then by row
+    std::vector<key_t> mSymbols;
+    std::vector<key_t> mNames;
+    QHash<QString, uint32_t> mRowsById;
+};
+
+} // namespace miledger
+
+#endif // MILEDGER_COIN_PREFIX_INDEX_H
@@ -0,0 +1,99 @@
+/*!
+ * miledger.
+ * coin_registry.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_COIN_REGISTRY_H
+#define MILEDGER_COIN_REGISTRY_H
+
+#include <QHash>
+#include <QString>
+#include <memory>
+#include <minter/api/explorer/explorer_results.h>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miledger {
+
+/// \brief Local coin catalogue keyed by coin id.
+/// New coin list is applied as a delta: only added, removed and changed coins are touched, so rank order
+/// and symbol index are kept instead of being rebuilt. Coin items never move in memory while they are in registry,
+/// so pointers from symbol index stay valid between updates.
+/// Rank: top coins first in given order, then by reserve, descending. Rank key is computed once per coin change.
+class CoinRegistry {
+public:
+    struct Delta {
+        size_t added = 0;
+        size_t removed = 0;
+        size_t changed = 0;
+        /// \brief Coins which changed place in rank order (subset of added and changed)
+        size_t moved = 0;
+        /// \brief Added and changed coins, valid until next apply
+        std::vector<const minter::explorer::coin_item*> touched;
+        /// \brief Ids of removed coins
+        std::vector<std::string> removedIds;
+
+        bool empty() const {
+            return added == 0 && removed == 0 && changed == 0;
+        }
+    };
+
+    explicit CoinRegistry(const std::vector<dev::bigint>& topIds);
+
+    /// \brief Apply full coin list: coins which are absent from it are removed
+    Delta apply(std::vector<minter::explorer::coin_item>&& coins);
+
+    /// \brief Coins in rank order
+    std::vector<minter::explorer::coin_item> toVector() const;
+    const QHash<QString, minter::explorer::coin_item*>& getIndex() const;
+    size_t size() const;
+
+private:
+    using reserve_t = decltype(minter::explorer::coin_item::reserve_valance);
+
+    struct RankKey {
+        // position in top coins list, or top list size for others
+        size_t top;
+        reserve_t reserve;
+        dev::bigint id;
+
+        bool operator<(const RankKey& other) const;
+    };
+
+    struct Entry {
+        std::unique_ptr<minter::explorer::coin_item> item;
+        RankKey key;
+    };
+
+    struct OrderLess {
+        bool operator()(const Entry* left, const Entry* right) const {
+            return left->key < right->key;
+        }
+    };
+
+    RankKey makeKey(const minter::explorer::coin_item& coin) const;
+    /// \brief Update existing entry or insert new one. Entry which rank changed is taken out of order and added to reordered.
+    void put(minter::explorer::coin_item&& coin, Delta& delta, std::vector<Entry*>& reordered);
+    /// \return false if entry is not in order (already taken out)
+    bool eraseFromOrder(Entry* entry);
+    void insertToOrder(Entry* entry);
+    static QString indexKey(const minter::explorer::coin_item& coin);
+
+    std::unordered_map<std::string, size_t> mTopRanks;
+    // id string -> entry
+    std::unordered_map<std::string, Entry> mEntries;
+    // sorted by rank key: moving one entry costs O(log n), not a shift of the whole list
+    std::set<Entry*, OrderLess> mOrder;
+    // upper case symbol -> item
+    QHash<QString, minter::explorer::coin_item*> mIndex;
+};
+
+} // namespace miledger
+
+#endif // MILEDGER_COIN_REGISTRY_H
@@ -10,16 +10,24 @@
 #ifndef MILEDGER_CONSOLE_APP_H
 #define MILEDGER_CONSOLE_APP_H
 
+#include "coin_registry.h"
 #include "device_server.h"
 #include "net/explorer_repo.h"
 #include "net/gate_repo.h"
+#include "net/pool_graph.h"
+#include "net/rewards_store.h"
+#include "net/tx_log.h"
+#include "net/tx_paginator.h"
 #include "optional.hpp"
 #include "rxqt_instance.hpp"
+#include "search_index.h"
 
 #include <QIcon>
 #include <QNetworkAccessManager>
 #include <QPixmap>
 #include <QThread>
+#include <QTimer>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -41,6 +49,8 @@ signals:
     void initDataUpdated(miledger::repo::tx_init_data initData);
     void coinListUpdated(std::vector<minter::explorer::coin_item> coins);
     void deviceExchangeError(std::exception_ptr e);
+    /// \brief New reward points are in rewardsStore
+    void rewardsUpdated();
 
 private slots:
     void onDeviceStateChanged(dev_state state);
@@ -56,8 +66,19 @@ public:
     void updateInitData();
     void updateCoinList();
     void updateBalance();
-
-    const std::vector<minter::explorer::coin_item>& getCoins() const;
+    /// \brief Min gas and commissions for display, from store first
+    void updateFees();
+    /// \brief Load validator list into search index
+    void updateValidators();
+    /// \brief Append new transactions of address to local log
+    void updateTxLog();
+    /// \brief Fetch rewards of address since the last stored minute
+    void updateRewards();
+    /// \brief Reload pool reserves for local swap estimates
+    void updatePools();
+
+    /// \brief Copy of coin list in rank order
+    std::vector<minter::explorer::coin_item> getCoins() const;
     const QHash<QString, minter::explorer::coin_item*>& getCoinsIndex() const;
     optns::optional<minter::explorer::coin_item*> findCoinBySymbol(const QString& symbol) const;
     optns::optional<minter::explorer::coin_item*> findCoinBySymbol(const std::string& symbol) const;
@@ -72,16 +93,35 @@ public:
 
     minter::explorer::balance_items balances;
     miledger::repo::tx_init_data initData;
-    std::vector<minter::explorer::coin_item> coins;
-    QHash<QString, minter::explorer::coin_item*> coinsIndex;
     rxcpp::composite_subscription subs;
+    // fuzzy search over coins and validators, for UI and WebSocket API
+    SearchIndex searchIndex;
 
     miledger::repo::explorer_repo explorerRepo;
     miledger::repo::gate_repo gateRepo;
+    // transaction history pages of address, shared by history views
+    miledger::repo::tx_paginator txPaginator{explorerRepo};
+    // local transaction log of address for lookups by hash, block and counterparty, null until address is resolved.
+    // Replaced with std::atomic_store: WebSocket API reads it from it's own thread
+    std::shared_ptr<miledger::repo::tx_log> txLog;
+    // rewards of address by minute, hour and day, null until address is resolved. Replaced with std::atomic_store as txLog
+    std::shared_ptr<miledger::repo::rewards_store> rewardsStore;
+    // all pools with reserves, exchange forms estimate swaps by it
+    miledger::repo::pool_graph poolGraph{explorerRepo};
     minter::address_t address;
 
 private:
     bool isStarted = false;
+    QTimer mPoolsTimer;
+    // the only pool refresh: ticks don't pile up subscriptions in subs
+    rxcpp::composite_subscription mPoolsSub;
+    // time to first balance after device app opened, for metrics
+    std::chrono::steady_clock::time_point mAppOpenedAt;
+    bool mBalanceTimed = true;
+    // fingerprints of shown data: store and network answers are emitted to UI only if they differ
+    uint64_t mCoinsTag = 0;
+    uint64_t mBalanceTag = 0;
+    uint64_t mFeesTag = 0;
     mutable std::mutex mCoinsLock;
     const std::vector<dev::bigint> mTopCoinsIds{
         dev::bigint("0"),    // bip
@@ -92,6 +132,8 @@ private:
         dev::bigint("1994"), // usdte
         dev::bigint("2065"), // eth
     };
+    // coin list with precomputed rank order and symbol index, updated by deltas
+    CoinRegistry mCoins{mTopCoinsIds};
 
     const std::unordered_map<QString, QString> mTopCoinsIcons{
         {QString("2024"), ":/icons/ic_logo_musd.png"}, // musd
@@ -11,6 +11,7 @@
 #define MILEDGER_EXCHANGE_CALCULATOR_H
 
 #include "include/net/explorer_repo.h"
+#include "include/net/pool_graph.h"
 #include "utils.h"
 
 #include <QObject>
@@ -29,6 +30,8 @@ struct EstimateResult {
     minter::gate::estimate_swap_from swap_from;
     minter::explorer::pool_route route;
     QString error_message;
+    // calculated by local pool graph, must be checked by remote estimate before signing
+    bool local = false;
 
     QString formatAmountToTarget(const std::string& coin) const {
         toolbox::strings::decimal_formatter fmt(minter::utils::to_string(amount));
@@ -87,14 +90,78 @@ public:
         minter::explorer::coin_item* from,
         minter::explorer::coin_item* to,
         dev::bigdec18* amount,
-        bool buyCoins)
+        bool buyCoins,
+        const miledger::repo::pool_graph* pools = nullptr)
         : fromCoin(from),
           toCoin(to),
           amount(amount),
-          buy(buyCoins) {
+          buy(buyCoins),
+          pools(pools) {
     }
 
+    /// \brief Estimate by local pool graph if it has route, by explorer otherwise
     rxcpp::observable<EstimateResult> calculate() const {
+        auto local = calculateLocal();
+        if (local) {
+            return rxcpp::observable<>::just(std::move(*local)).as_dynamic();
+        }
+        return calculateRemote();
+    }
+
+    /// \brief Check local estimate by explorer right before signing. Remote one is returned as it's what chain will do
+    /// now, error is thrown if it's noticeably worse than shown one
+    rxcpp::observable<EstimateResult> verify(const EstimateResult& estimate) const {
+        if (!estimate.local) {
+            return rxcpp::observable<>::just(estimate).as_dynamic();
+        }
+        const bool isBuy = buy;
+        return calculateRemote()
+            .map([estimate, isBuy](EstimateResult remote) {
+                const dev::bigdec18 tolerance("0.005");
+                const bool worse = isBuy
+                                       ? remote.amount > estimate.amount * (dev::bigdec18("1") + tolerance)
+                                       : remote.amount < estimate.amount * (dev::bigdec18("1") - tolerance);
+                if (worse) {
+                    throw std::runtime_error(QObject::tr("Price has changed: %1 instead of %2, please check estimate again")
+                                                 .arg(miledger::utils::humanDecimal(remote.amount), miledger::utils::humanDecimal(estimate.amount))
+                                                 .toStdString());
+                }
+                return remote;
+            })
+            .as_dynamic();
+    }
+
+private:
+    optns::optional<EstimateResult> calculateLocal() const {
+        // coins with reserve may be cheaper to convert by bancor, only explorer compares it with pools
+        const auto hasReserve = [](const minter::explorer::coin_item& coin) {
+            return coin.type == minter::explorer::coin_type::coin && coin.id != minter::def_coin_id;
+        };
+        if (!pools || hasReserve(*fromCoin) || hasReserve(*toCoin)) {
+            return {};
+        }
+
+        auto found = pools->find_route(
+            fromCoin->id,
+            toCoin->id,
+            minter::utils::normalize_value(*amount),
+            buy ? miledger::repo::pool_swap_type::buy : miledger::repo::pool_swap_type::sell);
+        if (!found) {
+            return {};
+        }
+
+        EstimateResult res;
+        res.local = true;
+        res.swap_from = minter::gate::estimate_swap_from::pool;
+        res.route.coins = found->coins;
+        res.route.amount_in = minter::utils::humanize_value(found->amount_in);
+        res.route.amount_out = minter::utils::humanize_value(found->amount_out);
+        res.route.swap_type = res.swap_from;
+        res.amount = buy ? res.route.amount_in : res.route.amount_out;
+        return res;
+    }
+
+    rxcpp::observable<EstimateResult> calculateRemote() const {
         namespace exp = minter::explorer;
         namespace gt = minter::gate;
         return explorerRepo.get_pool_estimate(*fromCoin, *toCoin, *amount, buy ? miledger::repo::pool_swap_type::buy : miledger::repo::pool_swap_type::sell)
@@ -121,14 +188,15 @@ public:
                     }
                     return res;
                 }
-            });
+            })
+            .as_dynamic();
     }
 
-private:
     minter::explorer::coin_item* fromCoin;
     minter::explorer::coin_item* toCoin;
     dev::bigdec18* amount;
     bool buy;
+    const miledger::repo::pool_graph* pools;
     miledger::repo::explorer_repo explorerRepo;
 };
 
@@ -10,6 +10,7 @@
 #ifndef MILEDGER_EXCHANGE_FORMS_H
 #define MILEDGER_EXCHANGE_FORMS_H
 
+#include "coin_completion_model.h"
 #include "coin_model.h"
 #include "console_app.h"
 #include "exchange_calculator.h"
@@ -152,16 +153,38 @@ public:
         inputCoinToBuy = new InputField("coin_to_buy", tr("Buy coin"));
         inputCoinToSell = new InputField("coin_to_sell", tr("Sell coin"));
 
+        m_coinToBuyModel = new CoinCompletionModel(coinModel, this);
+        m_coinToSellModel = new CoinCompletionModel(coinModel, this);
+        // mistyped ticker: suggest similar coins instead of empty popup
+        auto fuzzySearch = [this](const QString& text) {
+            std::vector<std::string> ids;
+            for (const auto& match : app->searchIndex.search(text, 10)) {
+                if (match.kind == miledger::SearchIndex::Kind::Coin) {
+                    ids.push_back(match.key);
+                }
+            }
+            return ids;
+        };
+        m_coinToBuyModel->setFuzzySearch(fuzzySearch);
+        m_coinToSellModel->setFuzzySearch(fuzzySearch);
+
         m_coinDelegate = new CoinItemViewDelegate(app);
         m_coinDelegate->setIconUpdatedCallback([this](const QModelIndex& index) {
-            emit coinModel.dataChanged(index, index);
+            // delegate is shared by both popups
+            if (index.model() == m_coinToBuyModel) {
+                emit m_coinToBuyModel->dataChanged(index, index);
+            } else if (index.model() == m_coinToSellModel) {
+                emit m_coinToSellModel->dataChanged(index, index);
+            }
         });
 
-        inputCoinToBuy->setCompleterModel(coinModel, 1, Qt::CaseInsensitive, m_coinDelegate);
+        inputCoinToBuy->setCompleterModel(*m_coinToBuyModel, 0, Qt::CaseInsensitive, m_coinDelegate);
         inputCoinToBuy->completer->setMaxVisibleItems(10);
+        m_coinToBuyModel->attach(inputCoinToBuy->input, inputCoinToBuy->completer);
 
-        inputCoinToSell->setCompleterModel(coinModel, 1, Qt::CaseInsensitive, m_coinDelegate);
+        inputCoinToSell->setCompleterModel(*m_coinToSellModel, 0, Qt::CaseInsensitive, m_coinDelegate);
         inputCoinToSell->completer->setMaxVisibleItems(10);
+        m_coinToSellModel->attach(inputCoinToSell->input, inputCoinToSell->completer);
 
         inputGroup.addInput(
             inputCoinToBuy,
@@ -195,6 +218,9 @@ protected:
 
 private:
     CoinItemViewDelegate* m_coinDelegate;
+    // completion rows of each coin input, owned by form
+    CoinCompletionModel* m_coinToBuyModel = nullptr;
+    CoinCompletionModel* m_coinToSellModel = nullptr;
 };
 
 class ExchangeBuyForm : public ExchangeForm {
@@ -262,7 +288,7 @@ public:
         : ExchangeForm(app, coinModel, parent),
           maxValueToSell(MAX_VALUE),
           amount("0"),
-          exchangeCalculator(&coinToSell, &coinToBuy, &amount, true) {
+          exchangeCalculator(&coinToSell, &coinToBuy, &amount, true, &app->poolGraph) {
     }
 
     void reset() override;
@@ -367,7 +393,7 @@ public:
         : ExchangeForm(app, coinModel, parent),
           minValueToBuy("0"),
           amount("0"),
-          exchangeCalculator(&coinToSell, &coinToBuy, &amount, false) {
+          exchangeCalculator(&coinToSell, &coinToBuy, &amount, false, &app->poolGraph) {
     }
 
     void reset() override;
@@ -467,7 +493,7 @@ public:
         : ExchangeForm(app, coinModel, parent),
           minValueToBuy("0"),
           amount("0"),
-          exchangeCalculator(&coinToSell, &coinToBuy, &amount, false) {
+          exchangeCalculator(&coinToSell, &coinToBuy, &amount, false, &app->poolGraph) {
     }
 
     void reset() override;
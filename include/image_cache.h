@@ -12,6 +12,8 @@
 
 #include "errors.h"
 #include "miledger-config.h"
+#include "net/transport.h"
+#include "net/metrics.h"
 #include "rxqt_instance.hpp"
 #include "utils.h"
 
@@ -25,6 +27,8 @@
 #include <QPixmap>
 #include <QString>
 #include <QTemporaryDir>
+#include <chrono>
+#include <cstdio>
 #include <memory>
 #include <minter/api/explorer/explorer_results.h>
 
@@ -56,93 +60,112 @@ private:
     }
 #endif
 
+    /// \brief Download url to file through the curl engine
+    /// \return observable with HTTP status code
+    static rxcpp::observable<long> downloadFile(const QString& url, const std::string& filePath) {
+        return rxcpp::observable<>::create<long>([url, filePath](rxcpp::subscriber<long> emitter) {
+            //            qDebug() << "Loading image " << url;
+            auto sink = std::make_shared<miledger::net::file_sink>(filePath);
+            auto call = std::make_shared<miledger::net::http_call>(miledger::net::request(url), sink);
+            call->verify_ssl = false;
+            // dozens of avatars are requested at once while list is painted
+            call->priority = miledger::net::request_priority::background;
+            const auto begin = std::chrono::steady_clock::now();
+            call->on_done = [emitter, sink, url, filePath, begin](const std::shared_ptr<miledger::net::http_call>& c) {
+                sink->close();
+
+                miledger::net::metrics_registry::call_sample sample;
+                sample.latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+                sample.bytes_in = c->resp.bytes_in;
+                sample.bytes_decoded = c->resp.bytes_decoded;
+                sample.error = c->resp.is_network_error() || c->resp.status_code >= 400;
+                sample.cancelled = c->resp.cancelled;
+                miledger::net::metrics_registry::get().record("image.download", sample);
+
+                if (c->resp.is_network_error()) {
+                    // partial file must not be taken as cached image
+                    std::remove(filePath.c_str());
+                    emitter.on_error(std::make_exception_ptr(
+                        std::runtime_error(QString("Unable to load image %1: [%2] %3")
+                                               .arg(
+                                                   url,
+                                                   QString::number(c->resp.error_code),
+                                                   QString::fromStdString(c->resp.error_message))
+                                               .toStdString())));
+                    return;
+                }
+                emitter.on_next(c->resp.status_code);
+                emitter.on_completed();
+            };
+
+            miledger::net::transport::get().submit(call);
+
+            // icon scrolled out of view or dialog closed: don't download what nobody waits for
+            emitter.add(rxcpp::make_subscription([call]() {
+                miledger::net::transport::get().cancel(call);
+            }));
+        });
+    }
+
     rxcpp::observable<bool> loadImage(const QString& url, const QString& fileKey) {
-        return rxcpp::observable<>::create<bool>([this, url, fileKey](rxcpp::subscriber<bool> emitter) {
+        return rxcpp::observable<>::defer([this, url, fileKey]() {
             const QString imageKey = fileKey;
             const std::string imageFile = Imager::get().filePathForKey(imageKey).toStdString();
 
             if (exist(imageKey)) {
                 qDebug() << "Return existent cached pixmap for " << imageKey;
-                emitter.on_next(true);
-                emitter.on_completed();
-                return;
+                return rxcpp::observable<>::just(true).as_dynamic();
             }
 
             {
                 // lock map to test and return error/continue job
                 std::lock_guard<std::mutex> lock(m_loadImageLocksMutex);
                 if (m_loadImageLocks.count(imageKey)) {
-                    try {
-                        throw image_already_in_work_error();
-                    } catch (...) {
-                        emitter.on_error(std::current_exception());
-                    }
-                    return;
+                    return rxcpp::observable<>::error<bool>(image_already_in_work_error()).as_dynamic();
                 }
 
                 m_loadImageLocks[imageKey] = true;
             }
 
-            cpr::Response resp;
-            cpr::Session session;
-            //            qDebug() << "Loading image " << url;
-            session.SetVerifySsl(cpr::VerifySsl(false));
-            session.SetUrl(cpr::Url(url.toStdString()));
-            curl_easy_setopt(session.GetCurlHolder()->handle, CURLOPT_NOSIGNAL, 1);
-
-            std::ofstream tmpFile(imageFile, std::ios::binary);
-
-            resp = session.Download(tmpFile);
-            tmpFile.close();
-
-            if (resp.status_code >= 400) {
-                qDebug() << "Unable to load image " << url << ": [" << resp.status_code << "] " << resp.error.message;
-                emitter.on_error(std::make_exception_ptr(
-                    std::runtime_error(QString("Unable to load image %1: [%2] %3")
-                                           .arg(
-                                               url,
-                                               QString::number(resp.status_code),
-                                               QString::fromStdString(resp.error.message))
-                                           .toStdString())));
-                return;
-            }
-
-            const QString targetPath = QString::fromStdString(imageFile);
-            qDebug() << "Load " << targetPath << " as pixmap or image";
-
-            QPixmap pm;
-            if (!pm.load(targetPath)) {
-                QImage img(targetPath);
-                qDebug() << "QImage size: " << img.size();
-                qDebug() << "QImage is null: " << img.isNull();
-                pm = QPixmap::fromImage(img);
-                if (pm.isNull() || pm.width() == 0 || pm.height() == 0) {
-                    {
-                        std::lock_guard<std::mutex> lock(m_loadImageLocksMutex);
-                        m_loadImageLocks.erase(imageKey);
+            return downloadFile(url, imageFile)
+                // don't decode images on the engine thread
+                .observe_on(rxcpp::observe_on_event_loop())
+                .map([url, imageKey, imageFile](long statusCode) {
+                    if (statusCode >= 400) {
+                        qDebug() << "Unable to load image " << url << ": [" << statusCode << "]";
+                        throw std::runtime_error(QString("Unable to load image %1: [%2]")
+                                                     .arg(url, QString::number(statusCode))
+                                                     .toStdString());
                     }
-                    qDebug() << "QPixmap icon is null: " << pm.isNull();
-                    qDebug() << "Unable to handle image " << imageKey << ": unknown error while loading pixmap";
-                    emitter.on_error(std::make_exception_ptr(
-                        std::runtime_error(QString("Unable to handle image %1: unknown error while loading pixmap").arg(url).toStdString())));
-                    return;
-                }
-            }
 
-            if (!Imager::get().preload(imageKey)) {
-                qDebug() << "Unable to preload " << imageKey << " to image cache";
-                emitter.on_error(std::make_exception_ptr(
-                    std::runtime_error("Unable to save image to cache")));
-                return;
-            }
+                    const QString targetPath = QString::fromStdString(imageFile);
+                    qDebug() << "Load " << targetPath << " as pixmap or image";
+
+                    QPixmap pm;
+                    if (!pm.load(targetPath)) {
+                        QImage img(targetPath);
+                        qDebug() << "QImage size: " << img.size();
+                        qDebug() << "QImage is null: " << img.isNull();
+                        pm = QPixmap::fromImage(img);
+                        if (pm.isNull() || pm.width() == 0 || pm.height() == 0) {
+                            qDebug() << "QPixmap icon is null: " << pm.isNull();
+                            qDebug() << "Unable to handle image " << imageKey << ": unknown error while loading pixmap";
+                            throw std::runtime_error(QString("Unable to handle image %1: unknown error while loading pixmap").arg(url).toStdString());
+                        }
+                    }
 
-            emitter.on_next(true);
-            emitter.on_completed();
+                    if (!Imager::get().preload(imageKey)) {
+                        qDebug() << "Unable to preload " << imageKey << " to image cache";
+                        throw std::runtime_error("Unable to save image to cache");
+                    }
 
-            {
-                std::lock_guard<std::mutex> lock(m_loadImageLocksMutex);
-                m_loadImageLocks.erase(imageKey);
-            }
+                    return true;
+                })
+                .finally([this, imageKey]() {
+                    std::lock_guard<std::mutex> lock(m_loadImageLocksMutex);
+                    m_loadImageLocks.erase(imageKey);
+                })
+                .as_dynamic();
         });
     }
 
@@ -0,0 +1,106 @@
+/*!
+ * miledger.
+ * api_store.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_API_STORE_H
+#define MILEDGER_API_STORE_H
+
+#include <QFile>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace miledger {
+namespace net {
+
+/// \brief Answer of offline-first call
+template<class T>
+struct stored_value {
+    T value;
+    /// \brief Fingerprint of answer data: equal for equal data
+    uint64_t tag = 0;
+    /// \brief Value is read from store, fresh one may follow
+    bool from_store = false;
+};
+
+/// \brief Persistent store of last known API answers, so the UI starts from them instead of empty state.
+/// Embedded append-only log: each put appends record [key len, value len, tag, checksum, key, value].
+/// On open the file is memory mapped and scanned once: the last record of key wins, torn tail after crash is cut off,
+/// and file is rewritten with live records only if most of it is garbage.
+class api_store {
+public:
+    struct entry {
+        /// \brief Raw response body
+        std::string value;
+        /// \brief Fingerprint of meaningful part of value, used to detect change
+        uint64_t tag = 0;
+    };
+
+    static api_store& get() {
+        static api_store inst;
+        return inst;
+    }
+
+    ~api_store();
+
+    /// \brief Open store file, load it and append to it after. Store is opened in application cache dir on first use,
+    /// but may be reopened at another path. Without file store still works, in memory only.
+    /// \param path store file
+    /// \return false if file can't be opened
+    bool open(const std::string& path);
+
+    /// \brief Find stored value
+    /// \param key
+    /// \param out entry copy
+    /// \return false if not found
+    bool find(const std::string& key, entry& out) const;
+
+    /// \brief Store value. Value with the same tag as stored one is not written again.
+    /// \param key
+    /// \param value raw body
+    /// \param tag fingerprint of value
+    /// \return true if key is new or tag changed
+    bool put(const std::string& key, std::string value, uint64_t tag);
+
+    size_t size() const;
+
+    /// \brief Fingerprint of json answer: hash of it's "data" member, so volatile fields around it (like latest_block_time)
+    /// don't make the same data look changed. Non-json body is hashed as is.
+    static uint64_t fingerprint(const std::string& body);
+
+    /// \brief FNV-1a
+    static uint64_t hash(const char* data, size_t len, uint64_t seed = 14695981039346656037ULL);
+
+private:
+    api_store();
+
+    struct record_header {
+        uint32_t key_len;
+        uint32_t value_len;
+        uint64_t tag;
+        uint64_t checksum;
+    };
+
+    void load();
+    void compact();
+    static std::string make_record(const std::string& key, const entry& e);
+    static uint64_t record_size(const std::string& key, const entry& e);
+
+    mutable std::mutex m_lock;
+    QFile m_file;
+    std::unordered_map<std::string, entry> m_entries;
+    // bytes of records which were overwritten by later ones
+    uint64_t m_dead_bytes = 0;
+    uint64_t m_file_size = 0;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_API_STORE_H
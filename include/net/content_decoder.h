@@ -0,0 +1,52 @@
+/*!
+ * miledger.
+ * content_decoder.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_CONTENT_DECODER_H
+#define MILEDGER_CONTENT_DECODER_H
+
+#include "http_call.h"
+
+#include <memory>
+
+namespace miledger {
+namespace net {
+
+/// \brief Streaming decompression of response body (gzip, deflate, br).
+/// Each compressed chunk is inflated into small fixed buffer and passed to the inner sink right away,
+/// so whole decompressed body never exists in memory unless inner sink collects it.
+class decoding_sink : public response_sink {
+public:
+    /// \brief Value of Accept-Encoding request header
+    static const char* accept_encoding();
+
+    /// \param inner consumer of decompressed body
+    /// \param resp response of the same call: encoding is read from it's headers on the first chunk,
+    /// decoded size and decompression time are written to it
+    decoding_sink(std::shared_ptr<response_sink> inner, miledger::net::response* resp);
+    ~decoding_sink() override;
+
+    bool write(const char* data, size_t len) override;
+
+private:
+    struct codec;
+
+    bool emit(const char* data, size_t len);
+
+    std::shared_ptr<response_sink> m_inner;
+    miledger::net::response* m_resp;
+    std::unique_ptr<codec> m_codec;
+    bool m_initialized = false;
+    // time spent by inner sink, excluded from decode time
+    std::chrono::steady_clock::duration m_inner_time{0};
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_CONTENT_DECODER_H
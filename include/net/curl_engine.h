@@ -0,0 +1,156 @@
+/*!
+ * miledger.
+ * curl_engine.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_CURL_ENGINE_H
+#define MILEDGER_CURL_ENGINE_H
+
+#include "http_call.h"
+#include "session_pool.h"
+#include "transport.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <curl/curl.h>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Single-threaded asynchronous HTTP transport on top of curl multi interface.
+/// All transfers are driven by one thread with non-blocking sockets, so any count of in-flight requests
+/// doesn't hold any other thread. Easy handles are taken from the session_pool to keep connections warm.
+/// All handles share DNS cache and TLS sessions, so a new connection to known host skips DNS lookup
+/// and resumes TLS session instead of doing full handshake.
+///
+/// Submitted calls are queued by request_priority and started while their host has free slots:
+/// interactive calls are started first and have a few reserved slots above the host limit,
+/// background calls use at most half of the limit and are paused for the host after HTTP 429.
+class curl_engine : public transport {
+public:
+    static curl_engine& get() {
+        static curl_engine inst;
+        return inst;
+    }
+
+    ~curl_engine() override;
+
+    /// \brief Slots above host limit which only interactive calls may use
+    static constexpr size_t interactive_reserve = 2;
+
+    const char* name() const override {
+        return "curl";
+    }
+
+    /// \brief Enqueue call. Call's on_done will be invoked from the engine thread.
+    /// \param call
+    void submit(std::shared_ptr<miledger::net::http_call> call) override;
+
+    /// \brief Cancel call: drop it from queue or abort running transfer and close it's connection.
+    /// Call's on_done is still invoked, with resp.cancelled set. Does nothing if call is already finished.
+    /// \param call
+    void cancel(std::shared_ptr<miledger::net::http_call> call) override;
+
+    /// \brief Run task on the engine thread after delay. Used for retries and hedging.
+    /// \param delay
+    /// \param task
+    void schedule(std::chrono::milliseconds delay, std::function<void()> task) override;
+
+    /// \brief Count of transfers currently driven by the engine
+    size_t active_size() const override;
+
+    /// \brief Count of calls waiting for free host slot
+    size_t queued_size() const;
+
+    /// \brief How long resolved addresses are kept in shared DNS cache
+    std::chrono::seconds get_dns_ttl() const {
+        return m_dns_ttl;
+    }
+
+private:
+    struct transfer {
+        explicit transfer(std::shared_ptr<miledger::net::http_call> call, session_pool::lease session)
+            : call(std::move(call))
+            , session(std::move(session)) {
+        }
+        ~transfer();
+
+        std::shared_ptr<miledger::net::http_call> call;
+        session_pool::lease session;
+        std::string host_key;
+        curl_slist* headers = nullptr;
+        std::string url;
+        /// \brief Request body shared with the call, curl reads it in place
+        body_buffer_t body;
+        /// \brief Streamed request body
+        body_reader_t body_reader;
+        /// \brief Decompresses body and passes it to the call sink
+        std::shared_ptr<response_sink> output;
+        /// \brief Record mode: copy of decompressed response body
+        bool record = false;
+        std::string recorded;
+    };
+
+    curl_engine();
+
+    void run();
+    struct host_state {
+        size_t active = 0;
+        /// \brief Background calls to host are not started until this time (after 429)
+        std::chrono::steady_clock::time_point paused_until;
+        std::chrono::milliseconds backoff{0};
+    };
+
+    void start_pending();
+    void abort(const std::shared_ptr<miledger::net::http_call>& call);
+    /// \brief Start queued calls in priority order while their hosts have free slots
+    void dispatch();
+    bool can_start(const host_state& host, request_priority priority, std::chrono::steady_clock::time_point now) const;
+    /// \brief Pause background calls to host after 429 or resume them after successful answer
+    void update_backoff(host_state& host, const miledger::net::response& resp);
+    /// \brief Run due timers
+    /// \return milliseconds until next timer, but not more than max_wait
+    int run_timers(int max_wait);
+    void start(std::shared_ptr<miledger::net::http_call> call, std::string host_key);
+    void finish(CURL* handle, CURLcode code);
+
+    static size_t write_callback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t header_callback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    static size_t read_callback(char* buffer, size_t size, size_t nitems, void* userdata);
+
+    CURLM* m_multi;
+    CURLSH* m_share;
+    std::chrono::seconds m_dns_ttl;
+    size_t m_host_limit;
+    std::thread m_thread;
+    std::atomic_bool m_running;
+
+    mutable std::mutex m_lock;
+    std::deque<std::shared_ptr<miledger::net::http_call>> m_pending;
+    std::vector<std::shared_ptr<miledger::net::http_call>> m_cancelled;
+    std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> m_timers;
+    // touched only from engine thread
+    std::unordered_map<CURL*, std::unique_ptr<transfer>> m_active;
+    std::array<std::deque<std::shared_ptr<miledger::net::http_call>>, 3> m_queued;
+    std::unordered_map<std::string, host_state> m_hosts;
+    std::atomic_size_t m_active_size;
+    std::atomic_size_t m_queued_size;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_CURL_ENGINE_H
@@ -0,0 +1,143 @@
+/*!
+ * miledger.
+ * endpoint_pool.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_ENDPOINT_POOL_H
+#define MILEDGER_ENDPOINT_POOL_H
+
+#include "request.h"
+
+#include <QString>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Groups of equivalent API base urls (mirrors) with latency and error scoring.
+/// Repositories build requests with their primary base url, http_client moves each attempt to the best endpoint
+/// of the group right before sending it, so retries and hedged attempts go to another endpoint if the first one failed or is busy.
+///
+/// The fastest endpoint by moving average of latency is chosen. Endpoint without recent samples gets a single probe request,
+/// so slower mirrors are measured again from time to time. After a few consecutive failures endpoint is ejected for a while.
+/// When that time ends, single probe request is let through: success re-admits endpoint, failure doubles ejection time.
+class endpoint_pool {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    struct options {
+        /// \brief Consecutive failures which eject endpoint
+        unsigned eject_after = 3;
+        /// \brief First ejection time, doubled on each failed probe
+        std::chrono::seconds eject_base = std::chrono::seconds(5);
+        std::chrono::seconds eject_max = std::chrono::seconds(300);
+        /// \brief Weight of new latency sample in moving average
+        double alpha = 0.3;
+        /// \brief Latency of endpoint without samples for this time is unknown again
+        std::chrono::seconds stale_after = std::chrono::seconds(60);
+        /// \brief Probe which wasn't reported (cancelled call) is forgotten after this time
+        std::chrono::seconds probe_timeout = std::chrono::seconds(30);
+    };
+
+    struct endpoint_stats {
+        std::string group;
+        std::string url;
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        double latency_ms = 0;
+        bool ejected = false;
+    };
+
+    static endpoint_pool& get() {
+        static endpoint_pool inst;
+        return inst;
+    }
+
+    void set_options(const options& opts);
+
+    /// \brief Replace urls of group. Must be called before group is registered, used by command line and with local stand-in servers.
+    /// \param group repository name: explorer, gate
+    /// \param urls base urls
+    void set_override(const std::string& group, std::vector<std::string> urls);
+
+    /// \brief Register group. Does nothing if group is already registered.
+    /// \param group repository name
+    /// \param primary base url which requests of the group are built with
+    /// \param urls all equivalent base urls, ignored if group has override. If empty, group consists of primary only.
+    void add_group(const std::string& group, const std::string& primary, const std::vector<std::string>& urls);
+
+    /// \brief Move request to the best endpoint of it's group. Request which doesn't belong to any group is left as is.
+    /// \param req request built with any base url of the group
+    /// \param busy request of still running attempt of the same call: if possible, it's endpoint is not chosen
+    void route(miledger::net::request& req, const miledger::net::request* busy = nullptr);
+
+    /// \brief Report result of routed request
+    /// \param req routed request
+    /// \param latency time of attempt
+    /// \param ok server answered, and answer is not 5xx or 429
+    void report(const miledger::net::request& req, std::chrono::microseconds latency, bool ok);
+
+    /// \brief Url of request as if it was built with primary base url of it's group
+    /// \param req request routed to any endpoint of the group, or request which doesn't belong to any group
+    std::string primary_url(const miledger::net::request& req) const;
+
+    std::vector<endpoint_stats> snapshot() const;
+    std::string dump() const;
+
+private:
+    struct endpoint {
+        std::string url;
+        QString proto;
+        QString host;
+        uint16_t port = 0;
+        // without trailing slash
+        QString path;
+
+        double latency_us = 0;
+        clock_t::time_point last_sample;
+        bool measured = false;
+        unsigned failures = 0;
+        std::chrono::seconds eject_for{0};
+        clock_t::time_point ejected_until;
+        // endpoint needed a probe and the only request let through is in flight
+        bool probing = false;
+        clock_t::time_point probe_started;
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+    };
+
+    struct group {
+        std::string name;
+        endpoint primary;
+        std::vector<endpoint> endpoints;
+    };
+
+    endpoint_pool() = default;
+
+    static endpoint make_endpoint(const std::string& url);
+    static bool matches(const endpoint& ep, const miledger::net::request& req);
+    static void rebase(miledger::net::request& req, const endpoint& from, const endpoint& to);
+    bool is_ejected(const endpoint& ep) const;
+    /// \brief Endpoint was never measured, it's latency is outdated or it's ejection time is over
+    bool needs_probe(const endpoint& ep, clock_t::time_point now) const;
+    bool is_probing(const endpoint& ep, clock_t::time_point now) const;
+    size_t select(const group& g, clock_t::time_point now, const endpoint* busy) const;
+
+    mutable std::mutex m_lock;
+    options m_opts;
+    std::unordered_map<std::string, std::vector<std::string>> m_overrides;
+    std::vector<group> m_groups;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_ENDPOINT_POOL_H
@@ -51,13 +51,19 @@ public:
     ~explorer_repo() override;
 
     QUrl get_base_url() const override;
+    QStringList get_base_urls() const override;
+    QString get_name() const override;
 
-    TASK_RES(balance_items)
+    /// \brief Offline-first: last known balance of address, then fresh one if it changed
+    TASK_STORED_RES(balance_items)
     get_balance(const minter::address_t& address, bool withSum = false) const;
     TASK_RES(tx_list_t)
     get_transactions(const minter::address_t& address, uint32_t page = 1, uint32_t limit = 10, tx_send_type send_type = tx_send_type::no_type) const;
     TASK_RES(tx_list_t)
     get_transactions(const get_transactions_opt& opts) const;
+    /// \brief Same as get_transactions, but answer is left as json: items are stored as is and paging meta is read from it
+    TASK_RES_ROOT(nlohmann::json)
+    get_transactions_json(const get_transactions_opt& opts) const;
     TASK_RES(transaction_item)
     get_transaction(const minter::address_t& address, dev::bigint block_number) const;
     TASK_RES(transaction_item)
@@ -73,6 +79,9 @@ public:
     /// \return
     TASK_RES(reward_list_t)
     get_rewards(const minter::address_t& address, reward_period period = day, const std::string& start_time = "", const std::string& end_time = "");
+    /// \brief Same as get_rewards, but answer is left as json, for local rewards store
+    TASK_RES_ROOT(nlohmann::json)
+    get_rewards_json(const minter::address_t& address, reward_period period, const std::string& start_time = "", const std::string& end_time = "");
 
     TASK_RES(validator_list_t)
     get_validators() const;
@@ -97,6 +106,9 @@ public:
 
     TASK_RES(std::vector<pool>)
     pools_list(uint32_t page = 0) const;
+    /// \brief Same as pools_list, but answer is left as json: paging meta is needed to load all pages
+    TASK_RES_ROOT(nlohmann::json)
+    pools_list_json(uint32_t page = 0) const;
 
     TASK_RES(pool)
     get_pool(const std::string& coin0, const std::string& coin1) const;
@@ -127,7 +139,8 @@ public:
     TASK_RES(pool_providers)
     get_pool_providers(const minter::address_t& address) const;
 
-    TASK_RES(std::vector<coin_item>)
+    /// \brief Offline-first: last known coin list, then fresh one if it changed
+    TASK_STORED_RES(std::vector<coin_item>)
     get_coins() const;
 
     TASK_RES(std::vector<coin_item>)
@@ -140,6 +153,12 @@ public:
     get_coin_by_id(const QString& coin_id) const;
 
 private:
+    miledger::net::request create_transactions_request(const get_transactions_opt& opts) const;
+    miledger::net::request create_rewards_request(const minter::address_t& address,
+                                                  reward_period period,
+                                                  const std::string& start_time,
+                                                  const std::string& end_time);
+
     std::unordered_map<reward_period, QString, enum_hasher> m_reward_scales = {
         {minute, "minute"},
         {hour, "hour"},
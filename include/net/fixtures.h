@@ -0,0 +1,126 @@
+/*!
+ * miledger.
+ * fixtures.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_FIXTURES_H
+#define MILEDGER_FIXTURES_H
+
+#include "http_call.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Recorded HTTP exchange
+struct fixture {
+    std::string method;
+    std::string url;
+    std::string request_body;
+
+    long status_code = 0;
+    /// \brief Response headers with lowercase names
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+};
+
+/// \brief Directory of recorded exchanges. Each exchange is stored as two files named by the request key:
+/// {key}.json with request and response metadata and {key}.body with raw response body.
+class fixture_store {
+public:
+    explicit fixture_store(std::string dir);
+
+    /// \brief Stable (between runs) key of request
+    static std::string key_for(const std::string& method, const std::string& url, const std::string& body);
+
+    bool save(const fixture& fx) const;
+    /// \brief Load recorded exchange
+    /// \return false if not found or broken
+    bool load(const std::string& method, const std::string& url, const std::string& body, fixture& out) const;
+
+    const std::string& get_dir() const {
+        return m_dir;
+    }
+
+private:
+    std::string m_dir;
+};
+
+/// \brief Record or replay mode of the net layer.
+/// In record mode every exchange which goes through the curl engine (repositories, image downloads) is saved to store.
+/// In replay mode the engine sends all requests to the in-process HTTP stand-in serving recorded exchanges,
+/// with configurable latency and bandwidth, so network paths can be measured offline with reproducible numbers.
+class fixtures {
+public:
+    enum class mode {
+        live,
+        record,
+        replay,
+    };
+
+    struct options {
+        mode net_mode = mode::live;
+        std::string dir;
+        /// \brief Replay: delay before response headers
+        std::chrono::milliseconds latency{0};
+        /// \brief Replay: body transfer speed in bytes per second, 0 - unlimited
+        uint64_t bandwidth = 0;
+        /// \brief Replay: local port of the stand-in server
+        uint16_t port = 18089;
+    };
+
+    /// \brief Header with original url of replayed request
+    static constexpr const char* url_header = "X-Fixture-Url";
+
+    static fixtures& get() {
+        static fixtures inst;
+        return inst;
+    }
+
+    ~fixtures();
+
+    /// \brief Configure mode. Call once at startup, before any request.
+    /// \return false if replay server can't be started
+    bool setup(const options& opts);
+
+    mode get_mode() const {
+        return m_opts.net_mode;
+    }
+    const options& get_options() const {
+        return m_opts;
+    }
+
+    /// \brief Record finished exchange (record mode)
+    void record(const miledger::net::request& req, const miledger::net::response& resp, std::string&& body);
+
+    /// \brief Replay mode: url of the stand-in server for request. Original url must be passed with url_header.
+    /// \param req original request
+    std::string replay_url(const miledger::net::request& req) const;
+
+    /// \brief Url which exchange is keyed by: request url moved back to primary base url of it's endpoint group,
+    /// so fixture doesn't depend on mirror which endpoint_pool routed attempt to. Passed with url_header in replay mode.
+    static std::string fixture_url(const miledger::net::request& req);
+
+private:
+    class server;
+
+    fixtures() = default;
+
+    options m_opts;
+    std::unique_ptr<fixture_store> m_store;
+    std::unique_ptr<server> m_server;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_FIXTURES_H
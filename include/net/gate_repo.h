@@ -41,6 +41,8 @@ class gate_repo : public miledger::net::repository {
 public:
     gate_repo();
     QUrl get_base_url() const override;
+    QStringList get_base_urls() const override;
+    QString get_name() const override;
 
     TASK_RES_ROOT(minter::gate::gas_value)
     get_min_gas();
@@ -49,6 +51,13 @@ public:
     TASK_RES_ROOT(minter::gate::price_commissions)
     get_price_commissions();
 
+    /// \brief Offline-first min gas and commissions: last known values, then fresh ones if they changed.
+    /// Only for display: transaction must be built from get_tx_init_data(), which emits once
+    TASK_STORED_RES_ROOT(minter::gate::gas_value)
+    get_stored_min_gas();
+    TASK_STORED_RES_ROOT(minter::gate::price_commissions)
+    get_stored_price_commissions();
+
     TASK_RES_ROOT(minter::gate::commission_value)
     get_tx_commission_value(const dev::bytes_data& tx_sign);
 
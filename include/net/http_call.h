@@ -0,0 +1,193 @@
+/*!
+ * miledger.
+ * http_call.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_HTTP_CALL_H
+#define MILEDGER_HTTP_CALL_H
+
+#include "request.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Scheduling class of call. Engine starts queued calls in this order.
+enum class request_priority {
+    /// \brief User is waiting for answer right now: typing estimate, sending transaction
+    interactive = 0,
+    normal,
+    /// \brief Bulk work: coin list, avatars. Backs off when server answers 429.
+    background,
+};
+
+/// \brief Consumer of response body. Transport pushes body chunks into sink as soon as they arrive from socket.
+class response_sink {
+public:
+    virtual ~response_sink() = default;
+
+    /// \brief Handle next body chunk
+    /// \param data chunk bytes
+    /// \param len chunk length
+    /// \return false to abort transfer
+    virtual bool write(const char* data, size_t len) = 0;
+};
+
+/// \brief Collects whole body into string
+class string_sink : public response_sink {
+public:
+    bool write(const char* data, size_t len) override {
+        m_data.append(data, len);
+        return true;
+    }
+
+    const std::string& data() const {
+        return m_data;
+    }
+
+    std::string& data() {
+        return m_data;
+    }
+
+private:
+    std::string m_data;
+};
+
+/// \brief Last stage of transfer output: keeps copy of body in record mode and passes it to call sink
+class recording_sink : public response_sink {
+public:
+    /// \param sink call sink, may be null
+    /// \param recorded where to append copy of body, null if not recording
+    recording_sink(std::shared_ptr<response_sink> sink, std::string* recorded)
+        : m_sink(std::move(sink))
+        , m_recorded(recorded) {
+    }
+
+    bool write(const char* data, size_t len) override {
+        if (m_recorded) {
+            m_recorded->append(data, len);
+        }
+        return !m_sink || m_sink->write(data, len);
+    }
+
+private:
+    std::shared_ptr<response_sink> m_sink;
+    std::string* m_recorded;
+};
+
+/// \brief Writes body directly to file
+class file_sink : public response_sink {
+public:
+    explicit file_sink(const std::string& path)
+        : m_out(path, std::ios::binary) {
+    }
+
+    bool write(const char* data, size_t len) override {
+        m_out.write(data, (std::streamsize) len);
+        return m_out.good();
+    }
+
+    void close() {
+        m_out.close();
+    }
+
+private:
+    std::ofstream m_out;
+};
+
+struct response {
+    /// \brief HTTP status code, 0 if server didn't answer
+    long status_code = 0;
+    /// \brief Response headers with lowercase names
+    std::vector<std::pair<std::string, std::string>> headers;
+    /// \brief Transport error code as CURLcode (all transports map their errors to it), 0 on success
+    int error_code = 0;
+    std::string error_message;
+    /// \brief Received body bytes as transferred, compressed if server used content encoding
+    uint64_t bytes_in = 0;
+    /// \brief Content encoding of body: gzip, deflate, br, empty if identity
+    std::string content_encoding;
+    /// \brief Body bytes after decompression
+    uint64_t bytes_decoded = 0;
+    /// \brief Time spent in decompression
+    std::chrono::microseconds decode_time{0};
+    /// \brief Call was cancelled by caller: dropped from queue or transfer aborted
+    bool cancelled = false;
+
+    bool is_network_error() const {
+        return error_code != 0;
+    }
+
+    /// \brief Find header by lowercase name
+    /// \param name lowercase header name
+    /// \return empty string if not found
+    std::string get_header(const std::string& name) const {
+        for (const auto& h : headers) {
+            if (h.first == name) {
+                return h.second;
+            }
+        }
+        return {};
+    }
+};
+
+/// \brief Single HTTP exchange: request, it's body consumer and result
+class http_call {
+public:
+    using done_callback_t = std::function<void(const std::shared_ptr<http_call>&)>;
+
+    http_call(miledger::net::request req, std::shared_ptr<response_sink> sink)
+        : req(std::move(req))
+        , sink(std::move(sink)) {
+    }
+
+    miledger::net::request req;
+    std::shared_ptr<response_sink> sink;
+    miledger::net::response resp;
+    /// \brief Called once from transport thread when call finished, successfully or not
+    done_callback_t on_done;
+    bool verify_ssl = true;
+    request_priority priority = request_priority::normal;
+    /// \brief Connect timeout, 0 - transport default
+    std::chrono::milliseconds connect_timeout{0};
+    /// \brief Whole transfer timeout, 0 - no timeout
+    std::chrono::milliseconds total_timeout{0};
+    /// \brief End of caller budget, default - none. Time spent in transport queue is taken from it.
+    std::chrono::steady_clock::time_point deadline{};
+    /// \brief When transport actually started transfer, default if it didn't
+    std::chrono::steady_clock::time_point started_at{};
+
+    /// \brief Called by transport when call leaves it's queue: clamps timeouts to budget left at this moment
+    /// \return false if budget was spent while call was queued, transfer must not start then
+    bool begin(std::chrono::steady_clock::time_point now) {
+        if (deadline != std::chrono::steady_clock::time_point{}) {
+            if (now >= deadline) {
+                return false;
+            }
+            const auto left = std::max(
+                std::chrono::milliseconds(1),
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+            connect_timeout = connect_timeout.count() > 0 ? std::min(connect_timeout, left) : left;
+            total_timeout = total_timeout.count() > 0 ? std::min(total_timeout, left) : left;
+        }
+        started_at = now;
+        return true;
+    }
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_HTTP_CALL_H
@@ -0,0 +1,86 @@
+/*!
+ * miledger.
+ * http_client.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_HTTP_CLIENT_H
+#define MILEDGER_HTTP_CLIENT_H
+
+#include "http_call.h"
+#include "request_policy.h"
+#include "response_cache.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace miledger {
+namespace net {
+
+/// \brief Outcome of logical call: the winning attempt
+struct http_result {
+    /// \brief Sink of the winning attempt, created by sink factory
+    std::shared_ptr<response_sink> sink;
+    miledger::net::response resp;
+    /// \brief Cached body confirmed by server (304) or still fresh: it should be consumed instead of network one
+    miledger::net::response_cache::entry_ptr replay;
+    /// \brief Started attempts, including hedged
+    unsigned attempts = 0;
+};
+
+/// \brief Runs logical calls over the transport: response cache, timeouts, jittered retries and hedging
+/// according to endpoint request_policy within call latency budget.
+class http_client {
+public:
+    using sink_factory_t = std::function<std::shared_ptr<response_sink>()>;
+    using done_callback_t = std::function<void(http_result&&)>;
+    using cancel_t = std::function<void()>;
+
+    static http_client& get() {
+        static http_client inst;
+        return inst;
+    }
+
+    /// \brief Execute request
+    /// \param req request, it's endpoint name selects policy
+    /// \param make_sink creates new body consumer for each attempt
+    /// \param on_done called once, from transport thread or from the caller thread if response was fresh in cache.
+    /// Not called if call was cancelled.
+    /// \return function which cancels call: queued attempts are dropped and running transfers are aborted.
+    /// Safe to call any time, from any thread, after call is finished it does nothing.
+    cancel_t execute(miledger::net::request req, sink_factory_t make_sink, done_callback_t on_done);
+
+    /// \brief p95 of endpoint latency from metrics_registry
+    /// \return 0 if there is no enough samples yet
+    std::chrono::milliseconds get_p95(const std::string& endpoint) const;
+
+private:
+    struct exchange;
+    struct attempt;
+
+    http_client() = default;
+
+    void start_attempt(const std::shared_ptr<exchange>& ex);
+    void on_attempt_done(const std::shared_ptr<exchange>& ex, const std::shared_ptr<attempt>& at);
+    void cancel(const std::shared_ptr<exchange>& ex);
+    void complete(std::unique_lock<std::mutex>& lock, const std::shared_ptr<exchange>& ex, const std::shared_ptr<attempt>& at);
+    std::chrono::milliseconds backoff(const request_policy& policy, unsigned retry);
+
+    static bool is_idempotent(const miledger::net::request& req);
+    static bool is_retriable(const miledger::net::response& resp);
+
+    mutable std::mutex m_lock;
+    std::mt19937 m_rnd{std::random_device{}()};
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_HTTP_CLIENT_H
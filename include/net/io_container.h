@@ -12,10 +12,12 @@
 
 #include "include/optional.hpp"
 
-#include <QCryptographicHash>
-#include <QDataStream>
 #include <QPair>
 #include <QString>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -30,12 +32,18 @@ using kvf = QPair<QString, double>;
 /// \brief Simple vector of pairs wss::web::KeyValue
 using kv_vector = std::vector<kv>;
 
+/// \brief Immutable body bytes. Shared by copies of request (retries, hedged attempts) and transport without copying
+using body_buffer_t = std::shared_ptr<const std::string>;
+
+/// \brief Source of streamed body: fills buffer with at most size bytes and returns written count, 0 - end of data
+using body_reader_t = std::function<size_t(char* buffer, size_t size)>;
+
 inline QString to_string(size_t n) {
     return QString::number(n);
 }
 
 inline bool case_insensitive_equal(const QString& str1, const QString& str2) noexcept {
-    return str1.size() == str2.size() && QString::compare(str1, str2, Qt::CaseInsensitive);
+    return str1.size() == str2.size() && QString::compare(str1, str2, Qt::CaseInsensitive) == 0;
 }
 class icase_equal_t {
 public:
@@ -44,19 +52,16 @@ public:
     }
 };
 
-// Based on https://stackoverflow.com/questions/2590677/how-do-i-combine-hash-values-in-c0x/2595226#2595226
+/// \brief FNV-1a of case-folded UTF-16 units: equal for keys which are equal by icase_equal_t
 class icase_hash_t {
 public:
     std::size_t operator()(const QString& str) const noexcept {
-        QByteArray hash = QCryptographicHash::hash(
-            QByteArray::fromRawData((const char*) str.utf16(), str.length() * 2),
-            QCryptographicHash::Md5);
-        Q_ASSERT(hash.size() == 16);
-
-        QDataStream stream(&hash, QIODeviceBase::OpenModeFlag::ReadOnly);
-        qint64 a, b;
-        stream >> a >> b;
-        return a ^ b;
+        uint64_t hash = 14695981039346656037ULL;
+        for (const QChar c : str) {
+            hash ^= c.toCaseFolded().unicode();
+            hash *= 1099511628211ULL;
+        }
+        return (std::size_t) hash;
     }
 };
 
@@ -70,6 +75,75 @@ using icase_map_t = std::unordered_map<QString,
                                        icase_hash_t,
                                        icase_equal_t>;
 
+/// \brief Flat store of UTF-8 key-value pairs: headers and query parameters.
+/// Each key is ASCII case-folded and hashed once when added, so lookup compares 32-bit hashes
+/// and only on match the folded bytes. Insertion order is kept and repeated keys are allowed (query arrays).
+/// Keys and values are kept in UTF-8, so they go to transport as is.
+class kv_store {
+public:
+    struct entry {
+        uint32_t hash;
+        /// \brief Key in lowercase
+        std::string folded;
+        /// \brief Key as it was added
+        std::string key;
+        std::string value;
+    };
+
+    using container_t = std::vector<entry>;
+    using const_iterator = container_t::const_iterator;
+
+    /// \brief ASCII lowercase: header names and query keys are ASCII, other bytes are kept as is
+    static std::string fold(const std::string& key);
+    /// \brief FNV-1a of folded key
+    static uint32_t hash_of(const std::string& folded);
+
+    /// \brief Add entry, even if key exists
+    void add(std::string key, std::string value);
+
+    /// \brief Replace value of all entries with key
+    /// \return count of replaced entries
+    size_t replace(const std::string& key, const std::string& value, bool icase = true);
+
+    /// \brief First entry with key
+    /// \return nullptr if not found
+    const entry* find(const std::string& key, bool icase = true) const;
+
+    /// \brief Remove all entries with key
+    /// \return count of removed entries
+    size_t remove(const std::string& key, bool icase = true);
+
+    /// \brief Remove index-th entry of key (for query arrays)
+    /// \return true if removed
+    bool remove_nth(const std::string& key, size_t index, bool icase = true);
+
+    void reserve(size_t size) {
+        m_entries.reserve(size);
+    }
+    void clear() {
+        m_entries.clear();
+    }
+    size_t size() const {
+        return m_entries.size();
+    }
+    bool empty() const {
+        return m_entries.empty();
+    }
+    const_iterator begin() const {
+        return m_entries.begin();
+    }
+    const_iterator end() const {
+        return m_entries.end();
+    }
+
+private:
+    bool matches(const entry& e, uint32_t hash, const std::string& folded, const std::string& key, bool icase) const {
+        return e.hash == hash && (icase ? e.folded == folded : e.key == key);
+    }
+
+    container_t m_entries;
+};
+
 class io_container {
 public:
     io_container();
@@ -82,6 +156,20 @@ public:
     /// \param data string data for request/response
     virtual void set_body(QString&& data);
 
+    /// \brief Set body as raw bytes (UTF-8 text or binary). Bytes are moved into shared buffer without copying
+    /// \param data body bytes
+    void set_body_bytes(std::string&& data);
+
+    /// \brief Set body as already shared buffer
+    /// \param data body bytes, nullptr clears body
+    void set_body_bytes(miledger::net::body_buffer_t data);
+
+    /// \brief Set body which will be read by transport while uploading, not kept in memory.
+    /// Such body can be sent only once, so request with it is never retried or hedged.
+    /// \param reader source of data
+    /// \param size total size in bytes or -1 if unknown: then body is sent with chunked transfer encoding
+    void set_body_stream(miledger::net::body_reader_t reader, int64_t size = -1);
+
     /// \brief Set header. Overwrites if already contains
     /// \param key_value std::pair<QString, QString>
     void set_header(miledger::net::kv&& key_value);
@@ -151,15 +239,33 @@ public:
     size_t headers_size() const;
 
     /// \brief Get copy of request/response body
-    /// \return Copy of body
+    /// \return Copy of body, decoded from UTF-8
     virtual QString get_body() const;
 
+    /// \brief Body bytes as is
+    /// \return empty string if body is not set or streamed
+    const std::string& get_body_bytes() const;
+
+    /// \brief Shared body buffer for transport: keeps bytes alive while transfer is running
+    /// \return nullptr if body is not set or streamed
+    miledger::net::body_buffer_t share_body() const;
+
+    /// \brief Check for body is streamed
+    bool has_body_stream() const;
+
+    /// \brief Streamed body source
+    const miledger::net::body_reader_t& get_body_stream() const;
+
+    /// \brief Declared size of streamed body
+    /// \return -1 if unknown
+    int64_t get_body_stream_size() const;
+
     /// \brief Check for body is not empty
-    /// \return true if !body.empty()
+    /// \return true if !body.empty() or body is streamed
     virtual bool has_body() const;
 
     /// \brief
-    /// \return Return body length in bytes
+    /// \return Return body length in bytes, for streamed body - declared size or 0 if unknown
     virtual std::size_t get_body_size() const;
 
     virtual void clear_body();
@@ -168,11 +274,8 @@ public:
     /// \return true if map not empty
     bool has_headers() const;
 
-    /// \brief Return copy of header map
-    /// \see wss::web::KeyValueVector
-    /// \see wss::web::keyValue
-    /// \return simple vector of pairs std::vector<KeyValue>
-    const miledger::net::kv_vector& get_headers() const;
+    /// \brief Headers in UTF-8, with names as they were added
+    const miledger::net::kv_store& get_headers() const;
 
     /// \brief Glue headers and return list of its.
     /// \return vector of strings:
@@ -184,8 +287,10 @@ public:
     std::vector<QString> get_headers_glued() const;
 
 protected:
-    miledger::net::kv_vector m_headers;
-    QString m_body;
+    miledger::net::kv_store m_headers;
+    miledger::net::body_buffer_t m_body;
+    miledger::net::body_reader_t m_body_stream;
+    int64_t m_body_stream_size = -1;
 };
 
 } // namespace net
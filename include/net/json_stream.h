@@ -0,0 +1,241 @@
+/*!
+ * miledger.
+ * json_stream.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_JSON_STREAM_H
+#define MILEDGER_JSON_STREAM_H
+
+#include "http_call.h"
+
+#include <exception>
+#include <functional>
+#include <minter/api/explorer/explorer_results.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Incremental (push) JSON parser. Unlike nlohmann::json::sax_parse, it doesn't need the whole input:
+/// bytes can be fed in chunks of any size, as they come from socket. Events are passed to nlohmann SAX handler.
+class json_push_parser {
+public:
+    using json = nlohmann::json;
+    using sax_t = nlohmann::json_sax<json>;
+
+    explicit json_push_parser(sax_t* handler);
+
+    /// \brief Parse next chunk
+    /// \return false on syntax error or if handler requested stop
+    bool feed(const char* data, size_t len);
+
+    /// \brief Signal end of input. Completes trailing top-level number or literal.
+    /// \return false if document is incomplete or invalid
+    bool finish();
+
+    bool failed() const {
+        return m_failed;
+    }
+    bool completed() const {
+        return m_expect == expect::eof && m_mode == mode::none;
+    }
+    const std::string& get_error() const {
+        return m_error;
+    }
+    /// \brief Count of consumed bytes
+    uint64_t position() const {
+        return m_pos;
+    }
+
+    /// \brief Microbenchmark: converts the same explorer coin list to result<vector<coin_item>> through
+    /// nlohmann::json::parse DOM and through json_stream_sink fed by socket-sized chunks, prints time and peak heap of both
+    /// \param iterations parses of each kind
+    static std::string benchmark(size_t iterations);
+
+private:
+    enum class mode {
+        none,
+        string,
+        string_escape,
+        string_unicode,
+        number,
+        literal,
+    };
+
+    enum class expect {
+        value,
+        first_value_or_end,
+        key,
+        first_key_or_end,
+        colon,
+        comma_or_end,
+        eof,
+    };
+
+    bool process(char c);
+    bool begin_value(char c);
+    bool end_container(bool object);
+    bool finish_string();
+    bool finish_number();
+    bool finish_literal();
+    bool on_unicode_escape();
+    void value_done();
+    bool fail(const std::string& message);
+    bool check(bool handler_result);
+    static void append_utf8(std::string& out, uint32_t cp);
+
+    sax_t* m_handler;
+    mode m_mode = mode::none;
+    expect m_expect = expect::value;
+    // true - object, false - array
+    std::vector<bool> m_stack;
+    std::string m_token;
+    std::string m_unicode;
+    uint32_t m_high_surrogate = 0;
+    bool m_string_is_key = false;
+    bool m_failed = false;
+    std::string m_error;
+    uint64_t m_pos = 0;
+};
+
+/// \brief SAX handler building nlohmann::json DOM.
+/// Optionally it can hand over elements of root array field (for example "data" of explorer result) one by one
+/// as soon as each element is parsed, so whole array is never kept as DOM.
+class json_dom_sax : public nlohmann::json_sax<nlohmann::json> {
+public:
+    using json = nlohmann::json;
+    using item_callback_t = std::function<void(json&& item)>;
+
+    /// \brief Stream elements of root object array field instead of keeping them in DOM
+    /// \param field root field name, like "data"
+    /// \param cb receives each parsed element. Exceptions thrown from callback stop parsing.
+    void stream_items(std::string field, item_callback_t cb);
+
+    json& root() {
+        return m_root;
+    }
+    std::exception_ptr get_exception() const {
+        return m_exception;
+    }
+
+    bool null() override;
+    bool boolean(bool val) override;
+    bool number_integer(number_integer_t val) override;
+    bool number_unsigned(number_unsigned_t val) override;
+    bool number_float(number_float_t val, const string_t& s) override;
+    bool string(string_t& val) override;
+    bool binary(binary_t& val) override;
+    bool start_object(std::size_t elements) override;
+    bool key(string_t& val) override;
+    bool end_object() override;
+    bool start_array(std::size_t elements) override;
+    bool end_array() override;
+    bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) override;
+
+private:
+    json* handle_value(json&& val);
+    bool item_completed();
+
+    json m_root;
+    std::vector<json*> m_ref_stack;
+    json* m_object_element = nullptr;
+
+    std::string m_items_field;
+    std::string m_root_key;
+    json* m_items_array = nullptr;
+    item_callback_t m_item_cb;
+    std::exception_ptr m_exception;
+};
+
+/// \brief Conversion of streamed DOM to target type. By default just json::get<T>()
+template<class T>
+struct json_stream_target {
+    void attach(json_dom_sax&) {
+    }
+
+    T take(nlohmann::json& root) {
+        return root.get<T>();
+    }
+};
+
+/// \brief Explorer lists: each element of "data" converted to item type right after it parsed
+template<class U>
+struct json_stream_target<minter::explorer::result<std::vector<U>>> {
+    std::vector<U> items;
+
+    void attach(json_dom_sax& builder) {
+        builder.stream_items("data", [this](nlohmann::json&& item) {
+            items.push_back(item.get<U>());
+        });
+    }
+
+    minter::explorer::result<std::vector<U>> take(nlohmann::json& root) {
+        auto out = root.get<minter::explorer::result<std::vector<U>>>();
+        out.data = std::move(items);
+        return out;
+    }
+};
+
+/// \brief Response sink deserializing body to T while it's downloading
+template<class T>
+class json_stream_sink : public response_sink {
+public:
+    json_stream_sink()
+        : m_parser(&m_builder) {
+        m_target.attach(m_builder);
+    }
+
+    bool write(const char* data, size_t len) override {
+        return m_parser.feed(data, len);
+    }
+
+    /// \brief Whether at least one byte has been received
+    bool has_data() const {
+        return m_parser.position() > 0;
+    }
+
+    /// \brief Complete parsing and return result
+    /// \throws std::runtime_error if document is invalid or conversion failed
+    T take() {
+        if (m_builder.get_exception()) {
+            std::rethrow_exception(m_builder.get_exception());
+        }
+        if (!m_parser.finish()) {
+            throw std::runtime_error(m_parser.get_error());
+        }
+        return m_target.take(m_builder.root());
+    }
+
+private:
+    json_dom_sax m_builder;
+    json_push_parser m_parser;
+    json_stream_target<T> m_target;
+};
+
+/// \brief Parses body like json_stream_sink and keeps it's raw copy, to persist it
+template<class T>
+class json_keeping_sink : public json_stream_sink<T> {
+public:
+    bool write(const char* data, size_t len) override {
+        m_raw.append(data, len);
+        return json_stream_sink<T>::write(data, len);
+    }
+
+    std::string& raw() {
+        return m_raw;
+    }
+
+private:
+    std::string m_raw;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_JSON_STREAM_H
@@ -0,0 +1,153 @@
+/*!
+ * miledger.
+ * metrics.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_METRICS_H
+#define MILEDGER_METRICS_H
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Log-linear latency histogram: 8 buckets per power of two, so relative error is below 12.5%
+class latency_histogram {
+public:
+    static constexpr size_t sub_buckets = 8;
+    static constexpr size_t buckets_count = 40 * sub_buckets;
+
+    void add(uint64_t micros);
+    /// \brief Approximate quantile
+    /// \param q 0..1
+    /// \return microseconds, 0 if empty
+    uint64_t quantile(double q) const;
+    uint64_t count() const {
+        return m_count;
+    }
+
+private:
+    static size_t index_of(uint64_t value);
+    static uint64_t lower_of(size_t index);
+    static uint64_t upper_of(size_t index);
+
+    std::array<uint64_t, buckets_count> m_buckets{};
+    uint64_t m_count = 0;
+};
+
+/// \brief Per-endpoint counters and latency of the net layer.
+/// Endpoint is a logical name like explorer.get_balance, gate.send_tx.
+class metrics_registry {
+public:
+    /// \brief Finished logical call
+    struct call_sample {
+        /// \brief Whole call time, including retries
+        std::chrono::microseconds latency{0};
+        /// \brief Received body bytes as transferred (compressed)
+        uint64_t bytes_in = 0;
+        /// \brief Sent body bytes
+        uint64_t bytes_out = 0;
+        /// \brief Received body bytes after decompression
+        uint64_t bytes_decoded = 0;
+        std::chrono::microseconds decode_time{0};
+        /// \brief Network error or HTTP error status
+        bool error = false;
+        /// \brief Caller gave up on call, latency is not counted
+        bool cancelled = false;
+        /// \brief Answered from fresh cache without network, latency is not counted
+        bool cache_hit = false;
+    };
+
+    struct endpoint_stats {
+        std::string name;
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        uint64_t cancelled = 0;
+        uint64_t cache_hits = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t bytes_decoded = 0;
+        uint64_t decode_us = 0;
+        /// \brief Sum of all latencies: which endpoint dominates waiting time
+        uint64_t total_us = 0;
+        uint64_t max_us = 0;
+        uint64_t p50_us = 0;
+        uint64_t p95_us = 0;
+        uint64_t p99_us = 0;
+        /// \brief Transfer attempts, including retries and hedges
+        uint64_t attempts = 0;
+        uint64_t attempt_p95_us = 0;
+    };
+
+    static metrics_registry& get() {
+        static metrics_registry inst;
+        return inst;
+    }
+
+    /// \brief Record finished logical call
+    /// \param endpoint endpoint name
+    /// \param sample call values
+    void record(const std::string& endpoint, const call_sample& sample);
+
+    /// \brief Record single transfer attempt: from the moment transport started it till it's end, without queue and backoff
+    /// \param endpoint endpoint name
+    /// \param latency attempt time
+    void record_attempt(const std::string& endpoint, std::chrono::microseconds latency);
+
+    /// \brief Record any custom duration, like time from start to balance on screen
+    void record_timing(const std::string& name, std::chrono::microseconds latency);
+
+    /// \brief Stats of endpoint
+    /// \return zero stats if nothing recorded
+    endpoint_stats get_stats(const std::string& endpoint) const;
+
+    /// \brief Latency quantile of endpoint
+    /// \param endpoint
+    /// \param q 0..1
+    /// \param min_samples return 0 if there is less samples
+    std::chrono::milliseconds get_quantile(const std::string& endpoint, double q, uint64_t min_samples = 1) const;
+
+    /// \brief Latency quantile of single transfer attempt of endpoint, see record_attempt
+    /// \param endpoint
+    /// \param q 0..1
+    /// \param min_samples return 0 if there is less samples
+    std::chrono::milliseconds get_attempt_quantile(const std::string& endpoint, double q, uint64_t min_samples = 1) const;
+
+    /// \brief All endpoints sorted by total time desc
+    std::vector<endpoint_stats> snapshot() const;
+
+    /// \brief Human-readable table
+    std::string dump() const;
+    nlohmann::json dump_json() const;
+
+    void reset();
+
+private:
+    struct entry {
+        endpoint_stats stats;
+        latency_histogram histogram;
+        latency_histogram attempts;
+    };
+
+    metrics_registry() = default;
+    static endpoint_stats make_stats(const entry& e);
+
+    mutable std::mutex m_lock;
+    std::map<std::string, entry> m_entries;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_METRICS_H
@@ -0,0 +1,125 @@
+/*!
+ * miledger.
+ * pool_graph.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_POOL_GRAPH_H
+#define MILEDGER_POOL_GRAPH_H
+
+#include "explorer_repo.h"
+#include "include/optional.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <rxcpp/rx.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miledger {
+namespace repo {
+
+/// \brief Local copy of all liquidity pools as graph of coins, to estimate swaps without network.
+///
+/// Reserves are kept in pips and swap amounts are calculated with the same integer constant product formula
+/// as the chain does, including commission and rounding. Best route is searched hop by hop up to the chain limit
+/// of coins in route: each hop keeps the best amount per coin, and path never visits the same coin twice.
+///
+/// Graph is immutable once loaded: refresh builds new one and swaps it, so estimates don't wait for network.
+class pool_graph {
+public:
+    /// \brief Max coins in swap route, including source and target
+    static const size_t max_route_coins = 5;
+    /// \brief Pool commission, per mille
+    static const unsigned commission = 2;
+
+    struct route {
+        std::vector<minter::explorer::coin_item_base> coins;
+        /// \brief Pips of the first coin
+        dev::bigint amount_in;
+        /// \brief Pips of the last coin
+        dev::bigint amount_out;
+    };
+
+    struct pool_info {
+        minter::explorer::coin_item_base coin0;
+        minter::explorer::coin_item_base coin1;
+        /// \brief Liquidity token symbol, like LP-12, empty if explorer didn't give it
+        std::string token;
+    };
+
+    explicit pool_graph(const explorer_repo& repo);
+
+    /// \brief Load all pages of pool list and replace graph
+    /// \return count of pools
+    rxcpp::observable<size_t> refresh();
+
+    /// \brief Best route between two coins
+    /// \param amount pips of coin_from to sell, or pips of coin_to to buy
+    /// \return empty if there is no route or pools are too small for amount
+    optns::optional<route> find_route(const dev::bigint& coin_from, const dev::bigint& coin_to, const dev::bigint& amount, pool_swap_type type) const;
+
+    /// \brief Pools of the current graph, in explorer order
+    std::vector<pool_info> pools() const;
+
+    bool empty() const;
+    size_t size() const;
+    /// \brief Time since graph was loaded, max if it's not loaded yet
+    std::chrono::steady_clock::duration age() const;
+
+    /// \brief Amount out of pool for amount in, 0 if amount is too small
+    static dev::bigint get_amount_out(const dev::bigint& amount_in, const dev::bigint& reserve_in, const dev::bigint& reserve_out);
+    /// \brief Amount in to pool for amount out, 0 if pool doesn't have enough reserve
+    static dev::bigint get_amount_in(const dev::bigint& amount_out, const dev::bigint& reserve_in, const dev::bigint& reserve_out);
+
+private:
+    struct edge {
+        uint32_t coin;
+        uint32_t pool;
+    };
+    struct pool_entry {
+        uint32_t coin0;
+        uint32_t coin1;
+        dev::bigint reserve0;
+        dev::bigint reserve1;
+        std::string token;
+    };
+    struct graph {
+        std::vector<minter::explorer::coin_item_base> coins;
+        std::unordered_map<uint64_t, uint32_t> nodes;
+        std::vector<std::vector<edge>> adjacent;
+        std::vector<pool_entry> pools;
+        std::chrono::steady_clock::time_point loaded_at;
+
+        uint32_t node_of(const nlohmann::json& coin);
+        /// \brief Reserves of pool ordered from coin to another one
+        std::pair<const dev::bigint&, const dev::bigint&> reserves(const edge& e, uint32_t from) const;
+    };
+    /// \brief Path of coin nodes and amount at the end of it
+    struct step {
+        dev::bigint amount;
+        std::vector<uint32_t> path;
+    };
+
+    static optns::optional<step> find_sell(const graph& g, uint32_t from, uint32_t to, const dev::bigint& amount);
+    static optns::optional<step> find_buy(const graph& g, uint32_t from, uint32_t to, const dev::bigint& amount);
+    static void add_page(graph& g, const nlohmann::json& answer);
+    static uint64_t to_id(const dev::bigint& id);
+
+    rxcpp::observable<nlohmann::json> fetch_page(uint32_t page) const;
+
+    const explorer_repo& m_repo;
+    mutable std::mutex m_lock;
+    std::shared_ptr<const graph> m_graph;
+};
+
+} // namespace repo
+} // namespace miledger
+
+#endif // MILEDGER_POOL_GRAPH_H
@@ -0,0 +1,72 @@
+/*!
+ * miledger.
+ * qt_transport.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_QT_TRANSPORT_H
+#define MILEDGER_QT_TRANSPORT_H
+
+#include "transport.h"
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+class QObject;
+class QThread;
+class QNetworkAccessManager;
+
+namespace miledger {
+namespace net {
+
+/// \brief Asynchronous HTTP transport on top of QNetworkAccessManager.
+/// Manager lives in it's own thread with event loop. Qt negotiates HTTP/2 with ALPN and multiplexes all calls to the host
+/// over one connection, HTTP/1.1 calls reuse keep-alive connections (up to 6 per host).
+/// Call priority is passed as QNetworkRequest priority, per-host limits and connection reuse are left to Qt.
+class qt_transport : public transport {
+public:
+    static qt_transport& get() {
+        static qt_transport inst;
+        return inst;
+    }
+
+    ~qt_transport() override;
+
+    const char* name() const override {
+        return "qt";
+    }
+
+    void submit(std::shared_ptr<miledger::net::http_call> call) override;
+    void cancel(std::shared_ptr<miledger::net::http_call> call) override;
+    void schedule(std::chrono::milliseconds delay, std::function<void()> task) override;
+    size_t active_size() const override;
+
+private:
+    struct transfer;
+
+    qt_transport();
+
+    void start(std::shared_ptr<miledger::net::http_call> call);
+    void abort(const std::shared_ptr<miledger::net::http_call>& call);
+    void finish(transfer* t);
+    /// \brief Pass available body bytes to call sink, abort transfer if sink refused them
+    static void read_body(transfer* t);
+    static void read_headers(transfer* t);
+
+    QThread* m_thread;
+    // parent of manager, lives in m_thread: all transport work is queued to it
+    QObject* m_context;
+    QNetworkAccessManager* m_manager;
+    // touched only from transport thread
+    std::unordered_map<miledger::net::http_call*, std::unique_ptr<transfer>> m_active;
+    std::atomic_size_t m_active_size;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_QT_TRANSPORT_H
@@ -10,21 +10,28 @@
 #ifndef MILEDGER_REPOSITORY_H
 #define MILEDGER_REPOSITORY_H
 
+#include "api_store.h"
+#include "endpoint_pool.h"
+#include "http_client.h"
+#include "json_stream.h"
+#include "single_flight.h"
 #include "request.h"
+#include "route.h"
 
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QObject>
+#include <QStringList>
 #include <QThread>
-#include <cpr/callback.h>
-#include <cpr/cpr.h>
 #include <fmt/format.h>
+#include <initializer_list>
 #include <map>
+#include <mutex>
 #include <minter/api/explorer/explorer_results.h>
 #include <minter/api/gate/gate_results.h>
-#include <rxcpp/rx-observable.hpp>
-#include <rxcpp/rx-subscriber.hpp>
+#include <rxcpp/rx.hpp>
+#include <tuple>
 #include <utility>
 
 namespace miledger {
@@ -33,70 +40,193 @@ namespace net {
 class repository : public QObject {
 public:
     virtual QUrl get_base_url() const = 0;
+    /// \brief Equivalent base urls (mirrors) of the api, requests are sent to the fastest healthy one.
+    /// By default the only url is get_base_url()
+    virtual QStringList get_base_urls() const {
+        return {get_base_url().toString()};
+    }
+    /// \brief Repository name, prefix of it's endpoint names: explorer, gate
+    virtual QString get_name() const = 0;
+
+    /// \brief Create request to base url. Base url is parsed once, then copied.
+    /// Request is moved to the best mirror by http_client, see endpoint_pool.
     miledger::net::request create_request() const {
-        return miledger::net::request(get_base_url());
+        std::call_once(m_base_once, [this]() {
+            m_base = miledger::net::request(get_base_url());
+
+            std::vector<std::string> urls;
+            for (const auto& url : get_base_urls()) {
+                urls.push_back(url.trimmed().toStdString());
+            }
+            miledger::net::endpoint_pool::get().add_group(get_name().toStdString(), get_base_url().toString().toStdString(), urls);
+        });
+        return m_base;
     }
 
-    template<class T>
-    rxcpp::observable<T> defer_task(miledger::net::request&& req) const {
-        return rxcpp::observable<>::create<T>([req](rxcpp::subscriber<T> emitter) {
-            cpr::Response resp;
-            cpr::Session session;
-            session.SetUrl(cpr::Url(req.get_url_string().toStdString()));
-            cpr::Header headers;
+    /// \brief Create request of named endpoint
+    /// \param endpoint method name, like get_balance. Full endpoint name will be prefixed with repository name.
+    miledger::net::request create_request(const QString& endpoint) const {
+        auto req = create_request();
+        req.set_endpoint(get_name() + "." + endpoint);
+        return req;
+    }
 
-            //            qDebug() << "Request url: " << req.get_url_string();
+    /// \brief Create request of compiled route
+    /// \param r endpoint route, it's name is the endpoint name
+    /// \param args route placeholder values
+    miledger::net::request create_request(const miledger::net::route& r, std::initializer_list<QString> args = {}) const {
+        auto req = create_request(r.get_name());
+        r.apply(req, args);
+        return req;
+    }
 
-#ifdef _MSC_VER
-            //@todo: use force winssl
-            session.SetVerifySsl(cpr::VerifySsl(false));
-#endif
+    /// \brief Set timeouts, retries and hedging of repository endpoint
+    /// \param endpoint method name or empty string for all repository endpoints
+    void set_policy(const QString& endpoint, const miledger::net::request_policy& policy) const {
+        QString name = endpoint.isEmpty() ? get_name() : get_name() + "." + endpoint;
+        miledger::net::policy_registry::get().set(name.toStdString(), policy);
+    }
 
-            for (const auto& h : req.get_headers()) {
-                headers.insert(std::pair<std::string, std::string>(h.first.toStdString(), h.second.toStdString()));
-            }
+    /// \brief Create task of request. Identical requests which are already in flight are not repeated,
+    /// subscriber just receives result of the running one.
+    template<class T>
+    rxcpp::observable<T> defer_task(miledger::net::request&& req) const {
+        std::string key = miledger::net::single_flight::key_for<T>(req);
+        return miledger::net::single_flight::get().run<T>(std::move(key), [req]() {
+            return make_call<T>(req);
+        });
+    }
 
-            switch (req.get_method()) {
-            case miledger::net::request::method::get: {
-                curl_easy_setopt(session.GetCurlHolder()->handle, CURLOPT_NOSIGNAL, 1);
-                resp = session.Get();
-            } break;
-            case miledger::net::request::method::post:
-                session.SetBody(cpr::Body(req.get_body().toStdString()));
-                curl_easy_setopt(session.GetCurlHolder()->handle, CURLOPT_NOSIGNAL, 1);
-                resp = session.Post();
-                break;
-            default:
-                emitter.on_error(
-                    std::make_exception_ptr(
-                        std::runtime_error("Unsupported HTTP method")));
-                // nothing yet
-                break;
-            }
+    /// \brief Create offline-first task: emits the last stored answer right away, then revalidates it over network.
+    /// Network answer is emitted only if it's data differs from the stored one, successful answers are persisted in api_store.
+    template<class T>
+    rxcpp::observable<miledger::net::stored_value<T>> defer_stored_task(miledger::net::request&& req) const {
+        using value_t = miledger::net::stored_value<T>;
+        std::string store_key = miledger::net::single_flight::key_for<T>(req);
+        auto network = miledger::net::single_flight::get().run<value_t>(
+            miledger::net::single_flight::key_for<value_t>(req),
+            [req, store_key]() {
+                return make_stored_call<T>(req, store_key);
+            });
+
+        return rxcpp::observable<>::defer([store_key, network]() {
+                   miledger::net::api_store::entry stored;
+                   if (!miledger::net::api_store::get().find(store_key, stored)) {
+                       return network.as_dynamic();
+                   }
+
+                   value_t cached;
+                   cached.tag = stored.tag;
+                   cached.from_store = true;
+                   try {
+                       miledger::net::json_stream_sink<T> sink;
+                       sink.write(stored.value.data(), stored.value.size());
+                       cached.value = sink.take();
+                   } catch (const std::exception&) {
+                       // written by another version of the app
+                       return network.as_dynamic();
+                   }
+
+                   const uint64_t stored_tag = stored.tag;
+                   return rxcpp::observable<>::just(cached)
+                       .concat(network.filter([stored_tag](const value_t& fresh) {
+                           return fresh.tag != stored_tag;
+                       }))
+                       .as_dynamic();
+               })
+            .as_dynamic();
+    }
 
-            if (resp.error && resp.text.empty()) {
-                emitter.on_error(std::make_exception_ptr(
-                    std::runtime_error(fmt::format("Unable to proceed request {0}: [{1}] {2}", req.get_url_string().toStdString(), resp.error.code, resp.error.message))));
-                return;
-            }
+private:
+    mutable std::once_flag m_base_once;
+    mutable miledger::net::request m_base;
 
-            nlohmann::json val;
+    /// \brief Sink filled with whole body (from network or cache) and HTTP status
+    template<class Sink>
+    using fetched_t = std::pair<std::shared_ptr<Sink>, long>;
 
-            try {
-                val = nlohmann::json::parse(resp.text);
-            } catch (const std::exception& e) {
-                emitter.on_error(std::make_exception_ptr(std::runtime_error(e.what())));
-                return;
-            } catch (...) {
-                emitter.on_error(std::current_exception());
-                return;
-            }
+    template<class T>
+    static rxcpp::observable<T> make_call(const miledger::net::request& req) {
+        return fetch<miledger::net::json_stream_sink<T>>(req)
+            .map([](const fetched_t<miledger::net::json_stream_sink<T>>& fetched) {
+                try {
+                    return fetched.first->take();
+                } catch (const std::exception& e) {
+                    throw std::runtime_error(e.what());
+                }
+            })
+            .as_dynamic();
+    }
 
-            T res = val.get<T>();
+    template<class T>
+    static rxcpp::observable<miledger::net::stored_value<T>> make_stored_call(const miledger::net::request& req, const std::string& store_key) {
+        using sink_t = miledger::net::json_keeping_sink<T>;
+        return fetch<sink_t>(req)
+            .map([store_key](const fetched_t<sink_t>& fetched) {
+                miledger::net::stored_value<T> answer;
+                try {
+                    answer.value = fetched.first->take();
+                } catch (const std::exception& e) {
+                    throw std::runtime_error(e.what());
+                }
+                answer.tag = miledger::net::api_store::fingerprint(fetched.first->raw());
+                // error answers are not worth showing on the next start
+                if (fetched.second < 300 || fetched.second == 304) {
+                    miledger::net::api_store::get().put(store_key, std::move(fetched.first->raw()), answer.tag);
+                }
+                return answer;
+            })
+            .as_dynamic();
+    }
 
-            emitter.on_next(res);
-            emitter.on_completed();
-        });
+    template<class Sink>
+    static rxcpp::observable<fetched_t<Sink>> fetch(const miledger::net::request& req) {
+        // parsing sink and cached body, which should be parsed instead of network one if server confirmed it's valid
+        using done_t = std::tuple<std::shared_ptr<Sink>, miledger::net::response_cache::entry_ptr, long>;
+
+        return rxcpp::observable<>::create<done_t>([req](rxcpp::subscriber<done_t> emitter) {
+                   //            qDebug() << "Request url: " << req.get_url_string();
+                   // body is parsed while it's downloading, so the raw text is never kept in memory
+                   auto make_sink = []() -> std::shared_ptr<miledger::net::response_sink> {
+                       return std::make_shared<Sink>();
+                   };
+
+                   // invoked from curl engine thread, don't do anything heavy here
+                   auto cancel = miledger::net::http_client::get().execute(req, make_sink, [emitter, req](miledger::net::http_result&& res) {
+                       auto sink = std::static_pointer_cast<Sink>(res.sink);
+                       if (res.resp.is_network_error() && !sink->has_data()) {
+                           emitter.on_error(std::make_exception_ptr(
+                               std::runtime_error(fmt::format("Unable to proceed request {0}: [{1}] {2}", req.get_url_utf8(), res.resp.error_code, res.resp.error_message))));
+                           return;
+                       }
+                       if (res.resp.status_code >= 500 && !res.replay && !sink->has_data()) {
+                           // body of server error is not passed to sink, see http_client
+                           emitter.on_error(std::make_exception_ptr(
+                               std::runtime_error(fmt::format("Unable to proceed request {0}: server answered HTTP {1}", req.get_url_utf8(), res.resp.status_code))));
+                           return;
+                       }
+
+                       emitter.on_next(done_t(sink, std::move(res.replay), res.resp.status_code));
+                       emitter.on_completed();
+                   });
+
+                   // last subscriber is gone (shared call included): stop the transfer, nobody needs the answer
+                   emitter.add(rxcpp::make_subscription([cancel]() {
+                       cancel();
+                   }));
+               })
+            // leave engine thread: final conversion and all downstream operators work on rx workers
+            .observe_on(rxcpp::observe_on_event_loop())
+            .map([](const done_t& done) {
+                const auto& sink = std::get<0>(done);
+                const auto& cached = std::get<1>(done);
+                if (cached) {
+                    const std::string& body = *cached->body;
+                    sink->write(body.data(), body.size());
+                }
+                return fetched_t<Sink>(sink, std::get<2>(done));
+            })
+            .as_dynamic();
     }
 };
 
@@ -105,10 +235,15 @@ public:
 /// \param req Request object
 #define MAKE_TASK(type, req) defer_task<result<type>>(std::move(req))
 #define MAKE_TASK_ROOT(type, req) defer_task<type>(std::move(req))
+/// \brief Same as MAKE_TASK, but offline-first: see defer_stored_task
+#define MAKE_STORED_TASK(type, req) defer_stored_task<result<type>>(std::move(req))
+#define MAKE_STORED_TASK_ROOT(type, req) defer_stored_task<type>(std::move(req))
 
 /// \brief Wrapper for result shared pointer
 #define TASK_RES(type) rxcpp::observable<result<type>>
 #define TASK_RES_ROOT(type) rxcpp::observable<type>
+#define TASK_STORED_RES(type) rxcpp::observable<miledger::net::stored_value<result<type>>>
+#define TASK_STORED_RES_ROOT(type) rxcpp::observable<miledger::net::stored_value<type>>
 
 } // namespace net
 } // namespace miledger
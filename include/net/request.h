@@ -18,6 +18,7 @@
 #include <memory>
 #include <queue>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 
 namespace miledger {
@@ -138,6 +139,9 @@ public:
     /// \return url string or empty string if did not set
     QString get_url_string() const;
 
+    /// \brief Url as UTF-8 bytes, what transport needs: built in one buffer without QString round trip
+    std::string get_url_utf8() const;
+
     /// \brief Return existed url
     /// \return url string or empty string if did not set
     QUrl get_url() const;
@@ -286,17 +290,41 @@ public:
     std::vector<QString> get_query_array(const QString& key, bool icase = true) const;
 
     /// \brief Build passed url with query parameters
-    /// \return url with parameters. if url did not set, will return empty string without parameters
+    /// \return percent-encoded query string starting with '?', or empty string if there are no parameters
     QString get_query_string() const;
 
-    /// \brief Return vector of passed parameters
-    /// \return simple vector with pairs of strings
-    const kv_vector& get_query_list() const;
+    /// \brief Preallocate query parameters, when count is known up front
+    /// \param size
+    void reserve_query(size_t size);
+
+    /// \brief Append percent-encoded (RFC 3986) value to string
+    /// \param out target
+    /// \param value any unicode text, it's utf-8 bytes are encoded
+    /// \param keep ascii chars which should not be encoded besides unreserved ones, may be nullptr
+    static void append_encoded(QString& out, const QString& value, const char* keep = nullptr);
+    static void append_encoded(std::string& out, const std::string& value, const char* keep = nullptr);
+
+    /// \brief Decode percent-encoded bytes, '+' is decoded as space
+    static std::string decode_percent(const char* data, size_t len);
+
+    /// \brief Query parameters in UTF-8, not encoded
+    const kv_store& get_query_list() const;
 
-    // Use with carefully
+    /// \brief Parse url into parts: scheme://host[:port][/path][?query]. Query values are decoded.
+    /// Use with carefully: it's not a validating parser.
     void parse_url(const QString& url);
 
+    /// \brief Set logical endpoint name, used for policies and metrics
+    /// \param endpoint for example: explorer.get_balance
+    void set_endpoint(const QString& endpoint);
+
+    /// \brief Logical endpoint name
+    /// \return empty string if did not set
+    const QString& get_endpoint() const;
+
 private:
+    void append_query(std::string& out) const;
+
     bool m_ssl;
     http_method m_method;
     QString m_proto;
@@ -304,7 +332,8 @@ private:
     QString m_port;
     QString m_path;
     /// \brief like multimap but vector of pairs
-    kv_vector m_params;
+    kv_store m_params;
+    QString m_endpoint;
 };
 
 class request : public miledger::net::base_request {
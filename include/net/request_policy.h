@@ -0,0 +1,92 @@
+/*!
+ * miledger.
+ * request_policy.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_REQUEST_POLICY_H
+#define MILEDGER_REQUEST_POLICY_H
+
+#include "http_call.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace miledger {
+namespace net {
+
+/// \brief Timeouts, retries and hedging of a single logical call
+struct request_policy {
+    /// \brief TCP+TLS connect timeout of each attempt
+    std::chrono::milliseconds connect_timeout{5000};
+    /// \brief Total time of each attempt
+    std::chrono::milliseconds attempt_timeout{15000};
+    /// \brief Latency budget of the whole call including all retries and hedges.
+    /// No attempt is started or lasts after it exhausted.
+    std::chrono::milliseconds budget{30000};
+    /// \brief Retries of idempotent (GET, HEAD) requests on network errors and 5xx
+    unsigned max_retries = 2;
+    /// \brief Retry delay is random in [0, min(backoff_max, backoff_base * 2^attempt)] (full jitter)
+    std::chrono::milliseconds backoff_base{250};
+    std::chrono::milliseconds backoff_max{4000};
+    /// \brief Start second identical idempotent request if first one didn't answer for hedge_after
+    bool hedge = false;
+    /// \brief Hedge delay, 0 - use p95 of endpoint latency
+    std::chrono::milliseconds hedge_after{0};
+    /// \brief Scheduling class of all attempts
+    request_priority priority = request_priority::normal;
+};
+
+/// \brief Policies by logical endpoint name. Lookup falls back to the endpoint group (part before the first dot),
+/// then to default policy: "gate.send_tx" -> "gate" -> default.
+class policy_registry {
+public:
+    static policy_registry& get() {
+        static policy_registry inst;
+        return inst;
+    }
+
+    void set(const std::string& endpoint, const request_policy& policy) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_policies[endpoint] = policy;
+    }
+
+    void set_default(const request_policy& policy) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_default = policy;
+    }
+
+    request_policy find(const std::string& endpoint) const {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_policies.find(endpoint);
+        if (it != m_policies.end()) {
+            return it->second;
+        }
+
+        auto dot = endpoint.find('.');
+        if (dot != std::string::npos) {
+            it = m_policies.find(endpoint.substr(0, dot));
+            if (it != m_policies.end()) {
+                return it->second;
+            }
+        }
+        return m_default;
+    }
+
+private:
+    policy_registry() = default;
+
+    mutable std::mutex m_lock;
+    std::unordered_map<std::string, request_policy> m_policies;
+    request_policy m_default;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_REQUEST_POLICY_H
@@ -0,0 +1,141 @@
+/*!
+ * miledger.
+ * response_cache.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_RESPONSE_CACHE_H
+#define MILEDGER_RESPONSE_CACHE_H
+
+#include "http_call.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace miledger {
+namespace net {
+
+/// \brief In-memory HTTP cache of GET responses with validators (ETag, Last-Modified) and Cache-Control freshness.
+/// Size is limited by byte budget, least recently used responses are evicted first.
+class response_cache {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    struct entry {
+        // shared between revalidated copies of the entry
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+        std::string last_modified;
+        clock_t::time_point stored;
+        std::chrono::seconds max_age{0};
+
+        bool is_fresh(clock_t::time_point now) const {
+            return max_age.count() > 0 && (now - stored) < max_age;
+        }
+    };
+    using entry_ptr = std::shared_ptr<const entry>;
+
+    struct stats {
+        /// \brief Served from memory without network
+        uint64_t fresh_hits = 0;
+        /// \brief Server answered 304 Not Modified
+        uint64_t revalidated = 0;
+        uint64_t misses = 0;
+        /// \brief Body bytes which were not downloaded thanks to cache
+        uint64_t bytes_saved = 0;
+    };
+
+    static response_cache& get() {
+        static response_cache inst;
+        return inst;
+    }
+
+    /// \brief Find cached response and mark it as recently used
+    /// \param url full request url
+    /// \return nullptr if not cached
+    entry_ptr find(const std::string& url);
+
+    /// \brief Add conditional headers (If-None-Match, If-Modified-Since) from cached entry
+    static void add_validators(miledger::net::request& req, const entry& cached);
+
+    /// \brief Whether response can be stored according to it's headers
+    static bool is_cacheable(const miledger::net::response& resp);
+
+    /// \brief Store 200 response. Does nothing if response can't be cached or it's larger than budget.
+    void store(const std::string& url, const miledger::net::response& resp, std::string&& body);
+
+    /// \brief Server confirmed cached entry is still valid (304): refresh it's freshness info
+    /// \return entry to replay
+    entry_ptr revalidate(const std::string& url, const entry_ptr& cached, const miledger::net::response& resp);
+
+    /// \brief Count fresh hit, served without network
+    void hit(const entry_ptr& cached);
+    void miss();
+
+    void set_budget(size_t bytes);
+    size_t get_budget() const;
+    size_t get_size() const;
+    stats get_stats() const;
+    void clear();
+
+private:
+    struct node {
+        entry_ptr value;
+        size_t cost;
+        std::list<std::string>::iterator lru;
+    };
+
+    response_cache();
+
+    static size_t cost_of(const std::string& url, const entry& e);
+    static std::chrono::seconds parse_max_age(const miledger::net::response& resp);
+    void put(const std::string& url, entry_ptr value);
+    void evict();
+
+    mutable std::mutex m_lock;
+    size_t m_budget;
+    size_t m_size = 0;
+    // front - most recently used
+    std::list<std::string> m_lru;
+    std::unordered_map<std::string, node> m_entries;
+    stats m_stats;
+};
+
+/// \brief Sink which passes body to the inner sink and keeps a copy of cacheable 200 responses
+class cache_sink : public response_sink {
+public:
+    /// \param inner actual body consumer
+    /// \param resp response of the same call, headers must be available before the first body chunk
+    /// \param limit max body size to keep copy of
+    cache_sink(std::shared_ptr<response_sink> inner, const miledger::net::response* resp, size_t limit);
+
+    bool write(const char* data, size_t len) override;
+
+    /// \brief Body copy, empty if response is not cacheable
+    std::string& data() {
+        return m_data;
+    }
+    bool is_complete() const {
+        return m_keep;
+    }
+
+private:
+    std::shared_ptr<response_sink> m_inner;
+    const miledger::net::response* m_resp;
+    size_t m_limit;
+    bool m_checked = false;
+    bool m_keep = false;
+    std::string m_data;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_RESPONSE_CACHE_H
@@ -0,0 +1,101 @@
+/*!
+ * miledger.
+ * rewards_store.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_REWARDS_STORE_H
+#define MILEDGER_REWARDS_STORE_H
+
+#include "explorer_repo.h"
+
+#include <QFile>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <rxcpp/rx.hpp>
+#include <string>
+#include <vector>
+
+namespace miledger {
+namespace repo {
+
+/// \brief Local time series of rewards of one address. Minute points are kept as they come from explorer,
+/// hour and day rollups are updated on each ingested point, so any range of any scale is answered locally.
+///
+/// Points are appended to address.rewards file as [time, checksum, amount]; point of the same minute overrides
+/// previous one (the last minute may be incomplete when it's fetched). File is compacted on open
+/// if it has more overridden points than live ones.
+///
+/// Sync fetches only the tail since the last stored minute, including that minute itself.
+class rewards_store {
+public:
+    struct point {
+        /// \brief Bucket start, unix time UTC
+        int64_t time;
+        dev::bigdec18 amount;
+    };
+
+    rewards_store(explorer_repo& repo, const minter::address_t& address, const std::string& dir);
+    ~rewards_store();
+
+    /// \brief Open or create file and load points
+    /// \return false if file can't be opened
+    bool open();
+
+    /// \brief Fetch minute points after the last stored one
+    /// \return count of ingested points
+    rxcpp::observable<size_t> sync();
+
+    /// \brief Points of buckets which start in [from, to], oldest first. Empty buckets are skipped
+    /// \param scale minute, hour or day; none is treated as day
+    /// \param limit max count of points, the oldest are returned; 0 - no limit
+    std::vector<point> query(int64_t from, int64_t to, explorer_repo::reward_period scale, size_t limit = 0) const;
+    /// \brief Sum of rewards in [from, to], by the coarsest buckets which fit in range
+    dev::bigdec18 total(int64_t from, int64_t to) const;
+
+    const minter::address_t& address() const;
+    /// \brief Start of the last stored minute, 0 if store is empty
+    int64_t last_time() const;
+
+    /// \brief Parse explorer time: "YYYY-MM-DD HH:MM:SS", ISO 8601 with or without offset
+    /// \return unix time or -1 if it's unparseable
+    static int64_t parse_time(const std::string& value);
+    /// \brief Format unix time as explorer startTime/endTime: "YYYY-MM-DD HH:MM:SS" UTC
+    static std::string format_time(int64_t time);
+
+private:
+    struct record_header {
+        int64_t time;
+        uint32_t length;
+        uint32_t reserved;
+        uint64_t checksum;
+    };
+    using series_t = std::map<int64_t, dev::bigdec18>;
+
+    /// \brief Put minute point and update rollups by difference with previous value
+    void ingest(int64_t time, const dev::bigdec18& amount);
+    size_t append_page(const nlohmann::json& answer);
+    bool write_record(int64_t time, const std::string& amount);
+    bool compact();
+    const series_t& series_of(explorer_repo::reward_period scale) const;
+
+    explorer_repo& m_repo;
+    minter::address_t m_address;
+    QFile m_file;
+    mutable std::mutex m_lock;
+
+    series_t m_minutes;
+    series_t m_hours;
+    series_t m_days;
+    // records in file, including overridden
+    size_t m_records = 0;
+};
+
+} // namespace repo
+} // namespace miledger
+
+#endif // MILEDGER_REWARDS_STORE_H
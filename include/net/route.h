@@ -0,0 +1,75 @@
+/*!
+ * miledger.
+ * route.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_ROUTE_H
+#define MILEDGER_ROUTE_H
+
+#include "request.h"
+
+#include <QString>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Compiled endpoint route: path template relative to repository base url with {name} placeholders
+/// and query parameters which endpoint may have. Template is split into literal parts once,
+/// so rendering is just appending literals and percent-encoded arguments to one preallocated buffer.
+///
+/// Example: route("get_balance", "addresses/{address}", {"withSum"})
+class route {
+public:
+    /// \param name endpoint method name, like get_balance
+    /// \param path_template relative path with placeholders: "pools/coins/{coin0}/{coin1}/route"
+    /// \param query_keys query parameters endpoint may have, used to preallocate them
+    route(QString name, const QString& path_template, std::initializer_list<QString> query_keys = {});
+
+    const QString& get_name() const {
+        return m_name;
+    }
+
+    /// \brief Placeholder names in order
+    const std::vector<QString>& get_params() const {
+        return m_params;
+    }
+
+    const std::vector<QString>& get_query_keys() const {
+        return m_query_keys;
+    }
+
+    /// \brief Render path to request: base path + template with substituted arguments
+    /// \param req request created from base url
+    /// \param args placeholder values in the same order as in template, each is percent-encoded as a path segment
+    void apply(miledger::net::base_request& req, std::initializer_list<QString> args) const;
+
+    /// \brief Render path only
+    /// \param base_path path of base url, like /api/v2/
+    /// \param args placeholder values
+    QString render_path(const QString& base_path, std::initializer_list<QString> args) const;
+
+    /// \brief Microbenchmark: builds the same url with legacy request building (parse base url, add_path, add_query)
+    /// and with compiled route, prints cost per request of both
+    /// \param iterations requests of each kind
+    static std::string benchmark(size_t iterations);
+
+private:
+    QString m_name;
+    /// \brief Literal before each placeholder and trailing literal: size is params + 1
+    std::vector<QString> m_literals;
+    std::vector<QString> m_params;
+    std::vector<QString> m_query_keys;
+    int m_literals_size = 0;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_ROUTE_H
@@ -0,0 +1,113 @@
+/*!
+ * miledger.
+ * session_pool.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_SESSION_POOL_H
+#define MILEDGER_SESSION_POOL_H
+
+#include "request.h"
+
+#include <chrono>
+#include <cpr/cpr.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace miledger {
+namespace net {
+
+/// \brief Per-host pool of keep-alive cpr sessions.
+/// Each cpr::Session owns a curl easy handle, and curl keeps the connection (and TLS state) of the handle open
+/// between transfers, so returning sessions to the pool lets the next request to the same host skip TCP and TLS handshakes.
+class session_pool {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    struct options {
+        /// \brief Max idle sessions kept for one host (scheme + host + port)
+        size_t max_per_host = 4;
+        /// \brief Idle sessions (and their connections) older than this are dropped
+        std::chrono::seconds idle_timeout = std::chrono::seconds(60);
+    };
+
+    /// \brief RAII handle to pooled session. Session returns to the pool when lease destroyed.
+    class lease {
+        friend class session_pool;
+
+    public:
+        lease(lease&& other) noexcept;
+        lease& operator=(lease&& other) noexcept;
+        lease(const lease&) = delete;
+        lease& operator=(const lease&) = delete;
+        ~lease();
+
+        cpr::Session* operator->() const {
+            return m_session.get();
+        }
+        cpr::Session& operator*() const {
+            return *m_session;
+        }
+        CURL* handle() const {
+            return m_session->GetCurlHolder()->handle;
+        }
+
+        /// \brief Do not return session to the pool, it will be destroyed with the lease (for example, after the broken transfer)
+        void discard();
+
+    private:
+        lease(session_pool* pool, std::string key, std::unique_ptr<cpr::Session> session);
+
+        session_pool* m_pool;
+        std::string m_key;
+        std::unique_ptr<cpr::Session> m_session;
+    };
+
+    static session_pool& get() {
+        static session_pool inst;
+        return inst;
+    }
+
+    /// \brief Build pool key for request: scheme://host:port
+    static std::string key_for(const miledger::net::base_request& req);
+
+    void set_options(const options& opts);
+    options get_options() const;
+
+    /// \brief Take warm session for request host or create new one
+    lease acquire(const miledger::net::base_request& req);
+    lease acquire(const std::string& key);
+
+    /// \brief Count of idle sessions in the pool
+    size_t idle_size() const;
+
+    /// \brief Drop all idle sessions
+    void clear();
+
+private:
+    session_pool();
+
+    struct idle_entry {
+        std::unique_ptr<cpr::Session> session;
+        clock_t::time_point since;
+    };
+
+    std::unique_ptr<cpr::Session> create_session() const;
+    void release(const std::string& key, std::unique_ptr<cpr::Session> session);
+    void evict_expired(clock_t::time_point now);
+
+    options m_opts;
+    std::unordered_map<std::string, std::deque<idle_entry>> m_idle;
+    mutable std::mutex m_lock;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_SESSION_POOL_H
@@ -0,0 +1,138 @@
+/*!
+ * miledger.
+ * single_flight.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_SINGLE_FLIGHT_H
+#define MILEDGER_SINGLE_FLIGHT_H
+
+#include "request.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <rxcpp/rx.hpp>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace miledger {
+namespace net {
+
+/// \brief Coalesces identical in-flight calls: while one call with the same key is running,
+/// new subscribers are attached to it instead of starting a duplicate.
+class single_flight {
+public:
+    struct stats {
+        /// \brief Calls actually started
+        uint64_t started = 0;
+        /// \brief Subscriptions attached to already running call
+        uint64_t coalesced = 0;
+        /// \brief Calls running right now
+        size_t in_flight = 0;
+    };
+
+    static single_flight& get() {
+        static single_flight inst;
+        return inst;
+    }
+
+    /// \brief Key of the request: method, url and body. Result type is a part of the key,
+    /// because the same response can be deserialized into different types.
+    template<class T>
+    static std::string key_for(const miledger::net::request& req) {
+        std::string key = req.get_method_str().toStdString();
+        key += ' ';
+        key += req.get_url_utf8();
+        key += '\n';
+        if (req.has_body_stream()) {
+            // streamed body can't be compared, such calls are never joined
+            static std::atomic<uint64_t> stream_id{0};
+            key += "stream#" + std::to_string(stream_id++);
+        } else {
+            key += req.get_body_bytes();
+        }
+        key += '\n';
+        key += typeid(T).name();
+        return key;
+    }
+
+    /// \brief Run observable created by factory or join already running one with the same key.
+    /// Call is forgotten as soon as it emits anything or all it's subscribers unsubscribed,
+    /// so late subscribers never join completed call.
+    /// \param key call identity, see key_for()
+    /// \param factory returns cold observable to share
+    template<class T, class Factory>
+    rxcpp::observable<T> run(std::string key, Factory factory) {
+        return rxcpp::observable<>::create<T>([this, key, factory](rxcpp::subscriber<T> s) {
+            // subscribing under the lock: call can't land between lookup and subscription
+            std::lock_guard<std::recursive_mutex> lock(m_lock);
+            auto it = m_flights.find(key);
+            if (it != m_flights.end()) {
+                m_stats.coalesced++;
+                std::static_pointer_cast<rxcpp::observable<T>>(it->second.source)->subscribe(s);
+                return;
+            }
+
+            m_stats.started++;
+            const uint64_t id = ++m_last_id;
+            auto land = [this, key, id]() {
+                forget(key, id);
+            };
+
+            auto source = std::make_shared<rxcpp::observable<T>>(
+                factory()
+                    .tap(
+                        [land](const T&) { land(); },
+                        [land](std::exception_ptr) { land(); },
+                        [land]() { land(); })
+                    .finally(land)
+                    .publish()
+                    .ref_count()
+                    .as_dynamic());
+
+            m_flights[key] = flight{id, source};
+            source->subscribe(s);
+        });
+    }
+
+    stats get_stats() const {
+        std::lock_guard<std::recursive_mutex> lock(m_lock);
+        stats out = m_stats;
+        out.in_flight = m_flights.size();
+        return out;
+    }
+
+private:
+    struct flight {
+        uint64_t id;
+        // type-erased rxcpp::observable<T>
+        std::shared_ptr<void> source;
+    };
+
+    single_flight() = default;
+
+    void forget(const std::string& key, uint64_t id) {
+        std::lock_guard<std::recursive_mutex> lock(m_lock);
+        auto it = m_flights.find(key);
+        // newer call with the same key may be already registered
+        if (it != m_flights.end() && it->second.id == id) {
+            m_flights.erase(it);
+        }
+    }
+
+    // recursive: cold source may emit synchronously while subscribing under the lock
+    mutable std::recursive_mutex m_lock;
+    std::unordered_map<std::string, flight> m_flights;
+    uint64_t m_last_id = 0;
+    stats m_stats;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_SINGLE_FLIGHT_H
@@ -0,0 +1,70 @@
+/*!
+ * miledger.
+ * transport.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_TRANSPORT_H
+#define MILEDGER_TRANSPORT_H
+
+#include "http_call.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace miledger {
+namespace net {
+
+/// \brief Asynchronous HTTP backend which executes http_call.
+/// Backend is chosen once at startup (--net-transport or net_transport setting) and used by all clients,
+/// so backends can be compared on the same network with --net-metrics.
+/// Every backend streams body into call sink, sets response headers and status before the first body chunk,
+/// and reports transport errors as CURLcode values, so retry and cancel logic doesn't depend on backend.
+class transport {
+public:
+    enum class kind {
+        /// \brief curl multi interface with own per-host scheduler, see curl_engine
+        curl,
+        /// \brief QNetworkAccessManager, see qt_transport
+        qt,
+    };
+
+    virtual ~transport() = default;
+
+    /// \brief Selected backend. Created on first use.
+    static transport& get();
+
+    /// \brief Select backend. Must be called before first get(), later calls are ignored.
+    /// \param name "curl" or "qt"
+    /// \return false if name is unknown
+    static bool select(const std::string& name);
+
+    /// \brief Selected backend kind
+    static kind get_kind();
+
+    /// \brief Backend name
+    virtual const char* name() const = 0;
+
+    /// \brief Enqueue call. Call's on_done will be invoked from the transport thread.
+    virtual void submit(std::shared_ptr<miledger::net::http_call> call) = 0;
+
+    /// \brief Cancel call: drop it from queue or abort running transfer.
+    /// Call's on_done is still invoked, with resp.cancelled set. Does nothing if call is already finished.
+    virtual void cancel(std::shared_ptr<miledger::net::http_call> call) = 0;
+
+    /// \brief Run task on the transport thread after delay. Used for retries and hedging.
+    virtual void schedule(std::chrono::milliseconds delay, std::function<void()> task) = 0;
+
+    /// \brief Count of transfers currently running
+    virtual size_t active_size() const = 0;
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_TRANSPORT_H
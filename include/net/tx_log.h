@@ -0,0 +1,137 @@
+/*!
+ * miledger.
+ * tx_log.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_TX_LOG_H
+#define MILEDGER_TX_LOG_H
+
+#include "explorer_repo.h"
+#include "include/optional.hpp"
+
+#include <QFile>
+#include <cstdint>
+#include <mutex>
+#include <rxcpp/rx.hpp>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace miledger {
+namespace repo {
+
+/// \brief Local copy of transaction history of one address: append-only log of transactions and memory mapped index,
+/// so lookups by hash, block range and counterparty don't go to network.
+///
+/// Log (address.txlog) keeps raw json of each transaction: [length, height, checksum, json]. It's only appended to,
+/// torn tail after crash is cut off on open.
+/// Index (address.txidx) is three sorted arrays of offsets into log: by height, by hash and by counterparty.
+/// Lookups are binary searches right in the mapped file. Index is rewritten aside and renamed after each sync,
+/// if it doesn't cover whole log (crash between them), the rest of log is indexed on open.
+///
+/// Sync fetches only blocks after the last synced one, page by page, and appends each page as it comes,
+/// so interrupted sync keeps it's progress: transactions which are already in log are skipped.
+class tx_log {
+public:
+    tx_log(const explorer_repo& repo, const minter::address_t& address, const std::string& dir);
+    ~tx_log();
+
+    /// \brief Open or create log and index files
+    /// \return false if log file can't be opened
+    bool open();
+
+    /// \brief Fetch transactions of blocks after the last synced one and append them to log
+    /// \return count of new transactions
+    rxcpp::observable<size_t> sync();
+
+    optns::optional<minter::explorer::transaction_item> find_by_hash(const std::string& hash) const;
+    /// \brief Transactions of blocks [from, to], oldest first
+    std::vector<minter::explorer::transaction_item> find_by_blocks(uint64_t from, uint64_t to, size_t limit = 0) const;
+    /// \brief Transactions between address of log and another one, oldest first
+    std::vector<minter::explorer::transaction_item> find_by_counterparty(const std::string& address, size_t limit = 0) const;
+
+    const minter::address_t& address() const;
+    /// \brief All blocks up to this height are in log
+    uint64_t synced_height() const;
+    size_t size() const;
+
+private:
+    struct record_header {
+        uint32_t length;
+        uint32_t reserved;
+        uint64_t height;
+        uint64_t checksum;
+    };
+    struct index_header {
+        char magic[8];
+        uint64_t count;
+        uint64_t party_count;
+        uint64_t synced_height;
+        // log bytes covered by index
+        uint64_t log_size;
+    };
+    struct block_entry {
+        uint64_t height;
+        uint64_t offset;
+    };
+    struct hash_entry {
+        uint64_t hash;
+        uint64_t offset;
+    };
+    struct party_entry {
+        uint64_t party;
+        uint64_t height;
+        uint64_t offset;
+    };
+    /// \brief Index in memory, while it's being extended
+    struct index_data {
+        std::vector<block_entry> blocks;
+        std::vector<hash_entry> hashes;
+        std::vector<party_entry> parties;
+    };
+
+    /// \brief Append page of explorer answer
+    /// \return count of new transactions
+    size_t append_page(const nlohmann::json& page);
+    /// \brief Index entries of transaction json
+    void add_entries(index_data& out, const nlohmann::json& tx, uint64_t height, uint64_t offset) const;
+    bool write_index(index_data&& data, uint64_t synced_height);
+    index_data read_index() const;
+    void map_files();
+    void unmap_files();
+    /// \brief Index log records after position, cut off torn tail
+    void recover(index_data& data, uint64_t from);
+    nlohmann::json read_json(uint64_t offset) const;
+    bool has_hash(uint64_t hash) const;
+    static uint64_t fingerprint(const std::string& value);
+
+    rxcpp::observable<nlohmann::json> fetch_page(uint64_t start_block, uint64_t end_block, uint32_t page) const;
+
+    const explorer_repo& m_repo;
+    minter::address_t m_address;
+    std::string m_address_str;
+    QFile m_log;
+    QFile m_index;
+    mutable std::mutex m_lock;
+
+    const uchar* m_log_map = nullptr;
+    uint64_t m_log_size = 0;
+    const uchar* m_index_map = nullptr;
+    const index_header* m_header = nullptr;
+    const block_entry* m_blocks = nullptr;
+    const hash_entry* m_hashes = nullptr;
+    const party_entry* m_parties = nullptr;
+    // entries appended during sync, not in mapped index yet
+    index_data m_pending;
+    std::unordered_set<uint64_t> m_pending_hashes;
+    uint64_t m_synced_height = 0;
+};
+
+} // namespace repo
+} // namespace miledger
+
+#endif // MILEDGER_TX_LOG_H
@@ -0,0 +1,97 @@
+/*!
+ * miledger.
+ * tx_paginator.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_TX_PAGINATOR_H
+#define MILEDGER_TX_PAGINATOR_H
+
+#include "explorer_repo.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <rxcpp/rx.hpp>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace miledger {
+namespace repo {
+
+/// \brief Transaction history of address, page by page, with local page cache and prefetch.
+/// Each requested page triggers background fetch of next pages, so scrolling finds them in cache.
+/// Pages are numbered from the newest transaction, so new transaction shifts all of them:
+/// when first page is fetched and it's newest transaction (height and hash) differs from known one, cached pages of address are dropped.
+/// Prefetch and foreground request of the same page are merged into one transfer by http client.
+class tx_paginator {
+public:
+    struct options {
+        uint32_t page_size = 50;
+        /// \brief Pages fetched ahead of requested one
+        uint32_t prefetch = 3;
+        /// \brief Cached pages per address, the farthest from requested one are dropped first
+        size_t max_pages = 200;
+    };
+
+    struct page {
+        uint32_t number = 0;
+        tx_list_t items;
+        /// \brief There are no pages after this one
+        bool last = false;
+    };
+
+    explicit tx_paginator(const explorer_repo& repo);
+    tx_paginator(const explorer_repo& repo, const options& opts);
+    ~tx_paginator();
+
+    /// \brief Page from cache or network. Next pages are prefetched in background.
+    /// \param address
+    /// \param number page number, from 1
+    rxcpp::observable<page> get_page(const minter::address_t& address, uint32_t number);
+
+    /// \brief Fetch first page again to check whether history has changed
+    /// \return true if newest transaction changed and cached pages were dropped
+    rxcpp::observable<bool> refresh(const minter::address_t& address);
+
+    void clear();
+
+private:
+    struct address_cache {
+        std::map<uint32_t, tx_list_t> pages;
+        // prefetches in flight
+        std::set<uint32_t> loading;
+        // newest transaction: several transactions may share height, so hash is compared too
+        dev::bigint head;
+        std::string head_hash;
+        bool head_known = false;
+        // increased when pages are dropped: late answers of previous generation are not cached
+        uint64_t generation = 0;
+        // 0 - unknown
+        uint32_t last_page = 0;
+    };
+
+    rxcpp::observable<tx_list_t> fetch(const minter::address_t& address, uint32_t number) const;
+    /// \brief Put fetched page to cache
+    /// \return true if it's the first page and history changed
+    bool store(const std::string& key, uint64_t generation, uint32_t number, const tx_list_t& items);
+    void prefetch(const minter::address_t& address, uint32_t after);
+    /// \return height and hash of the newest transaction, 0 and empty if there are no transactions
+    static std::pair<dev::bigint, std::string> head_of(const tx_list_t& items);
+
+    const explorer_repo& m_repo;
+    options m_opts;
+    std::mutex m_lock;
+    std::unordered_map<std::string, address_cache> m_cache;
+    rxcpp::composite_subscription m_subs;
+};
+
+} // namespace repo
+} // namespace miledger
+
+#endif // MILEDGER_TX_PAGINATOR_H
@@ -0,0 +1,51 @@
+/*!
+ * miledger.
+ * warmup.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_WARMUP_H
+#define MILEDGER_WARMUP_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace miledger {
+namespace net {
+
+/// \brief Startup connection warm-up.
+/// Resolves and connects to known hosts in parallel while device is still connecting, so the first real requests
+/// find DNS result in the engine cache, TLS session ticket to resume and open keep-alive connection.
+/// Each host connection time is recorded to metrics_registry as warmup.{host}.
+class warmup {
+public:
+    static warmup& get() {
+        static warmup inst;
+        return inst;
+    }
+
+    /// \brief Start warm-up of hosts of given urls. Doesn't block. Does nothing if already started or in fixtures replay mode.
+    /// \param urls any urls, only scheme, host and port are used
+    void start(const std::vector<std::string>& urls);
+
+    /// \brief Count of hosts which are still warming up
+    size_t pending_size() const {
+        return m_pending.load(std::memory_order_relaxed);
+    }
+
+private:
+    warmup() = default;
+
+    std::atomic_bool m_started{false};
+    std::atomic_size_t m_pending{0};
+};
+
+} // namespace net
+} // namespace miledger
+
+#endif // MILEDGER_WARMUP_H
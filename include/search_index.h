@@ -0,0 +1,100 @@
+/*!
+ * miledger.
+ * search_index.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_SEARCH_INDEX_H
+#define MILEDGER_SEARCH_INDEX_H
+
+#include <QString>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace miledger {
+
+/// \brief In-memory fuzzy search over coins, validators and pools, tolerant to typos.
+/// Each document has title (coin symbol, validator name, pool pair) and subtitle (coin name, validator public key, liquidity token).
+/// Every word of them is split to case-folded trigrams, padded like "  word ", and each trigram keeps list of documents having it.
+/// Query is split the same way, documents are scored by trigram similarity (shared / union), with bonus for exact and prefix match.
+/// Documents are added, changed and removed one by one, so index follows coin registry deltas.
+/// Thread-safe: used from UI thread and from WebSocket server thread.
+class SearchIndex {
+public:
+    enum class Kind : uint8_t {
+        Coin,
+        Validator,
+        Pool,
+    };
+
+    struct Match {
+        Kind kind;
+        std::string key;
+        QString title;
+        QString subtitle;
+        double score;
+    };
+
+    /// \brief Add or update document
+    /// \param kind
+    /// \param key coin id, validator public key or pool coin ids
+    void upsert(Kind kind, const std::string& key, const QString& title, const QString& subtitle);
+    void remove(Kind kind, const std::string& key);
+    /// \brief Remove documents of kind which keys are not in keep
+    void retain(Kind kind, const std::unordered_set<std::string>& keep);
+
+    /// \brief Ranked fuzzy matches
+    /// \param query any case, may have typos
+    /// \param limit max count of matches
+    std::vector<Match> search(const QString& query, size_t limit = 10) const;
+
+    size_t size() const;
+
+    static std::string kindToString(Kind kind);
+
+private:
+    using gram_t = uint64_t;
+
+    enum Field : uint32_t {
+        Title = 0,
+        Subtitle = 1,
+        FieldsCount = 2,
+    };
+
+    struct Doc {
+        Kind kind;
+        std::string key;
+        QString title;
+        QString subtitle;
+        QString folded[FieldsCount];
+        std::vector<gram_t> grams[FieldsCount];
+        bool alive = false;
+    };
+
+    /// \brief Unique trigrams of folded text
+    static std::vector<gram_t> makeGrams(const QString& folded);
+    static std::string docKey(Kind kind, const std::string& key);
+    void index(uint32_t id);
+    void unindex(uint32_t id);
+    void removeLocked(Kind kind, const std::string& key);
+
+    mutable std::mutex mLock;
+    std::vector<Doc> mDocs;
+    // slots of removed documents
+    std::vector<uint32_t> mFree;
+    // kind + key -> doc id
+    std::unordered_map<std::string, uint32_t> mKeys;
+    // trigram -> postings: doc id << 1 | field
+    std::unordered_map<gram_t, std::vector<uint32_t>> mPostings;
+};
+
+} // namespace miledger
+
+#endif // MILEDGER_SEARCH_INDEX_H
@@ -47,6 +47,14 @@ public:
     const static QString KEY_SERVER_PORT;
     const static QString KEY_SERVER_ADDRESS;
     const static QString KEY_SERVER_CLOSE_TRAY;
+    const static QString KEY_NET_POOL_SIZE;
+    const static QString KEY_NET_POOL_IDLE_TIMEOUT;
+    const static QString KEY_NET_CACHE_SIZE;
+    const static QString KEY_NET_DNS_TTL;
+    const static QString KEY_NET_HOST_CONCURRENCY;
+    const static QString KEY_NET_TRANSPORT;
+    const static QString KEY_NET_EXPLORER_URLS;
+    const static QString KEY_NET_GATE_URLS;
 
     static Settings& get() {
         static Settings inst;
@@ -61,10 +61,26 @@ private:
     ExchangeSellAllForm* sellAllForm;
     CoinModel coinsModel;
 
+    /// \brief Form values transaction is built from. Taken on UI thread when sender is created,
+    /// so edits of form during verification and signing don't change signed transaction
+    struct TxParams {
+        miledger::EstimateResult estimate;
+        dev::bigint gasCoin;
+        dev::bigint coinToBuy;
+        dev::bigint coinToSell;
+        /// \brief Value to buy or to sell, unused by sell all
+        dev::bigdec18 amount;
+        /// \brief Max value to sell for buy, min value to buy for sell
+        dev::bigdec18 limit;
+    };
+
     rxcpp::observable<minter::gate::tx_send_result> createTxSender(ExchangeFormBy exchangeBy);
-    std::shared_ptr<minter::tx> createBuyTx(miledger::repo::tx_init_data initData);
-    std::shared_ptr<minter::tx> createSellTx(miledger::repo::tx_init_data initData);
-    std::shared_ptr<minter::tx> createSellAllTx(miledger::repo::tx_init_data initData);
+    TxParams captureTxParams(ExchangeFormBy exchangeBy) const;
+    std::shared_ptr<minter::tx> createBuyTx(miledger::repo::tx_init_data initData, const TxParams& params);
+    std::shared_ptr<minter::tx> createSellTx(miledger::repo::tx_init_data initData, const TxParams& params);
+    std::shared_ptr<minter::tx> createSellAllTx(miledger::repo::tx_init_data initData, const TxParams& params);
+    /// \brief Check estimate by explorer, if it was calculated locally. Verified one is only passed down the chain
+    rxcpp::observable<miledger::EstimateResult> verifyEstimate(ExchangeFormBy exchangeBy, const miledger::EstimateResult& estimate);
 
     void buyDialogConfigure(miledger::TxSendDialog* dialog);
     void buyDialogSubmit();
@@ -0,0 +1,39 @@
+/*!
+ * miledger.
+ * tab_history.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_TAB_HISTORY_H
+#define MILEDGER_TAB_HISTORY_H
+
+#include "tab_base.h"
+#include "tx_history_model.h"
+
+#include <QTableView>
+
+namespace Ui {
+
+class TabHistory : public TabBase {
+    Q_OBJECT
+public:
+    TabHistory(miledger::ConsoleApp* app, QWidget* parent);
+    ~TabHistory();
+    void setDeviceAvailable(bool available) override;
+
+private slots:
+    void onAddressResolved(const minter::address_t& address);
+    void onBalanceUpdated(minter::explorer::balance_items);
+    void onLoadFailed(QString error);
+
+private:
+    QTableView* table;
+    TxHistoryModel* model;
+};
+
+} // namespace Ui
+
+#endif // MILEDGER_TAB_HISTORY_H
@@ -0,0 +1,71 @@
+/*!
+ * miledger.
+ * tx_history_model.h
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#ifndef MILEDGER_TX_HISTORY_MODEL_H
+#define MILEDGER_TX_HISTORY_MODEL_H
+
+#include "include/net/tx_paginator.h"
+
+#include <QAbstractTableModel>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/// \brief Transaction history of address, populated lazily: view asks for next page with fetchMore when it's scrolled
+/// to the end, and page comes from paginator cache or network. Strings are made in data() for visible rows only.
+class TxHistoryModel : public QAbstractTableModel {
+    Q_OBJECT
+
+signals:
+    void loadFailed(QString error);
+
+public:
+    enum Column {
+        ColumnHash = 0,
+        ColumnHeight,
+        ColumnTime,
+        ColumnType,
+        ColumnFrom,
+        ColumnsCount,
+    };
+
+    TxHistoryModel(miledger::repo::tx_paginator& paginator, QObject* parent = nullptr);
+    ~TxHistoryModel() override;
+
+    /// \brief Show history of address, from the first page
+    void setAddress(const minter::address_t& address);
+    /// \brief Check for new transactions, reload from the first page if there are any
+    void refresh();
+
+    int rowCount(const QModelIndex& parent) const override;
+    int columnCount(const QModelIndex& parent) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private:
+    void reset();
+    void appendPage(miledger::repo::tx_paginator::page&& page);
+
+    miledger::repo::tx_paginator& mPaginator;
+    minter::address_t mAddress;
+    bool mHasAddress = false;
+    std::vector<minter::explorer::transaction_item> mRows;
+    // page borders move when new transactions come in while scrolling: the same transaction may come twice
+    std::unordered_set<std::string> mHashes;
+    uint32_t mNextPage = 1;
+    bool mLoading = false;
+    bool mEnd = false;
+    // answers for previous address or before reset are ignored
+    uint64_t mGeneration = 0;
+    rxcpp::composite_subscription mSubs;
+};
+
+#endif // MILEDGER_TX_HISTORY_MODEL_H
@@ -1,5 +1,12 @@
 #include "include/app.h"
 #include "include/miledger-config.h"
+#include "include/net/endpoint_pool.h"
+#include "include/net/fixtures.h"
+#include "include/net/json_stream.h"
+#include "include/net/metrics.h"
+#include "include/net/route.h"
+#include "include/net/transport.h"
+#include "include/settings.h"
 #include "include/style_helper.h"
 #include "include/ui/mainwindow.h"
 
@@ -76,8 +83,100 @@ int main(int argc, char* argv[]) {
                                                     << "mnemonic",
                                       "Use mnemonic to emulate ledger", "mnemonic");
         parser.addOption(enableMock);
+
+        QCommandLineOption dumpNetMetrics(QStringList() << "net-metrics",
+                                          "Print network calls metrics on exit");
+        parser.addOption(dumpNetMetrics);
+
+        QCommandLineOption netRecord(QStringList() << "net-record",
+                                     "Record all network exchanges to directory", "dir");
+        QCommandLineOption netReplay(QStringList() << "net-replay",
+                                     "Replay recorded network exchanges from directory instead of network", "dir");
+        QCommandLineOption netReplayLatency(QStringList() << "net-replay-latency",
+                                            "Replay: response latency in milliseconds", "ms", "0");
+        QCommandLineOption netReplayBandwidth(QStringList() << "net-replay-bandwidth",
+                                              "Replay: bandwidth in KiB/s, 0 - unlimited", "kib", "0");
+        QCommandLineOption netReplayPort(QStringList() << "net-replay-port",
+                                         "Replay: local port of stand-in server", "port", "18089");
+        parser.addOption(netRecord);
+        parser.addOption(netReplay);
+        parser.addOption(netReplayLatency);
+        parser.addOption(netReplayBandwidth);
+        parser.addOption(netReplayPort);
+
+        QCommandLineOption netTransport(QStringList() << "net-transport",
+                                        "Network backend: curl or qt", "name",
+                                        Settings::get().getString(Settings::KEY_NET_TRANSPORT, "curl"));
+        parser.addOption(netTransport);
+
+        QCommandLineOption netEndpoints(QStringList() << "net-endpoints",
+                                        "Equivalent base urls of api, comma separated, e.g. explorer=http://127.0.0.1:8081/api/v2,https://... "
+                                        "Overrides net_explorer_urls and net_gate_urls settings. May be repeated.",
+                                        "api=urls");
+        parser.addOption(netEndpoints);
+
+        QCommandLineOption benchRoutes(QStringList() << "net-bench-routes",
+                                       "Print url building cost per request and exit", "iterations", "100000");
+        parser.addOption(benchRoutes);
+        QCommandLineOption benchJson(QStringList() << "net-bench-json",
+                                     "Print coin list parsing time and peak heap, DOM against streaming, and exit", "iterations", "100");
+        parser.addOption(benchJson);
         parser.process(a);
 
+        if (parser.isSet(benchRoutes)) {
+            std::cout << miledger::net::route::benchmark(parser.value(benchRoutes).toULongLong()) << std::endl;
+            return 0;
+        }
+        if (parser.isSet(benchJson)) {
+            std::cout << miledger::net::json_push_parser::benchmark(parser.value(benchJson).toULongLong()) << std::endl;
+            return 0;
+        }
+
+        if (!miledger::net::transport::select(parser.value(netTransport).toStdString())) {
+            std::cerr << "Unknown network transport: " << parser.value(netTransport).toStdString() << std::endl;
+            return 1;
+        }
+
+        for (const auto& value : parser.values(netEndpoints)) {
+            const int sep = value.indexOf('=');
+            if (sep <= 0) {
+                std::cerr << "Invalid --net-endpoints value: " << value.toStdString() << std::endl;
+                return 1;
+            }
+            std::vector<std::string> urls;
+            for (const auto& url : value.mid(sep + 1).split(',', Qt::SkipEmptyParts)) {
+                urls.push_back(url.trimmed().toStdString());
+            }
+            miledger::net::endpoint_pool::get().set_override(value.left(sep).toStdString(), std::move(urls));
+        }
+
+        if (parser.isSet(netRecord) || parser.isSet(netReplay)) {
+            miledger::net::fixtures::options opts;
+            if (parser.isSet(netReplay)) {
+                opts.net_mode = miledger::net::fixtures::mode::replay;
+                opts.dir = parser.value(netReplay).toStdString();
+            } else {
+                opts.net_mode = miledger::net::fixtures::mode::record;
+                opts.dir = parser.value(netRecord).toStdString();
+            }
+            opts.latency = std::chrono::milliseconds(parser.value(netReplayLatency).toUInt());
+            opts.bandwidth = (uint64_t) parser.value(netReplayBandwidth).toUInt() * 1024;
+            opts.port = (uint16_t) parser.value(netReplayPort).toUInt();
+
+            if (!miledger::net::fixtures::get().setup(opts)) {
+                std::cerr << "Unable to start network replay server" << std::endl;
+                return 1;
+            }
+        }
+
+        if (parser.isSet(dumpNetMetrics)) {
+            QObject::connect(&a, &QApplication::aboutToQuit, []() {
+                qDebug().noquote() << "Network transport:" << miledger::net::transport::get().name();
+                qDebug().noquote() << QString::fromStdString(miledger::net::metrics_registry::get().dump());
+                qDebug().noquote() << QString::fromStdString(miledger::net::endpoint_pool::get().dump());
+            });
+        }
+
         if (parser.isSet(enableMock)) {
             QString mockMnemonic = parser.value(enableMock);
             if (mockMnemonic.isEmpty()) {
@@ -22,12 +22,22 @@ const std::unordered_map<miledger::ws_message::type_t, std::string> miledger::ws
     {miledger::ws_message::result_sign_tx, "result_sign_tx"},
     {miledger::ws_message::action_get_device_state, "action_get_device_state"},
     {miledger::ws_message::result_get_device_state, "result_get_device_state"},
+    {miledger::ws_message::action_search, "action_search"},
+    {miledger::ws_message::result_search, "result_search"},
+    {miledger::ws_message::action_tx_lookup, "action_tx_lookup"},
+    {miledger::ws_message::result_tx_lookup, "result_tx_lookup"},
+    {miledger::ws_message::action_rewards, "action_rewards"},
+    {miledger::ws_message::result_rewards, "result_rewards"},
+    {miledger::ws_message::event_rewards_updated, "event_rewards_updated"},
 };
 
 const std::vector<miledger::ws_message::type_t> miledger::ws_message::action_types = {
     miledger::ws_message::action_get_address,
     miledger::ws_message::action_sign_tx,
-    miledger::ws_message::action_get_device_state};
+    miledger::ws_message::action_get_device_state,
+    miledger::ws_message::action_search,
+    miledger::ws_message::action_tx_lookup,
+    miledger::ws_message::action_rewards};
 
 miledger::ws_message::type_t miledger::ws_message::type_from_string(const std::string& type) {
     auto res = std::find_if(map.begin(), map.end(), [&type](std::pair<ws_message::type_t, std::string> it) {
@@ -12,6 +12,7 @@
 #include "include/api/ws_messages.h"
 #include "include/settings.h"
 
+#include <QDateTime>
 #include <chrono>
 #include <minter/ledger/errors.h>
 #include <restinio/router/easy_parser_router.hpp>
@@ -60,6 +61,19 @@ void miledger::WsServer::run() {
         m_server->open_sync();
         qDebug() << "Starting server... [DONE]";
     });
+    connect(m_app, &ConsoleApp::rewardsUpdated, [this]() {
+        const auto store = std::atomic_load(&m_app->rewardsStore);
+        if (!store) {
+            return;
+        }
+        miledger::ws_message res(ws_message::type_t::event_rewards_updated, miledger::repo::rewards_store::format_time(store->last_time()));
+        // registry belongs to server thread
+        restinio::asio_ns::post(m_ctx, [this, res] {
+            for (const auto& it : m_registry) {
+                sendMessage(it.first, res);
+            }
+        });
+    });
     connect(m_app, &ConsoleApp::deviceStateChanged, [this](dev_state state) {
         std::for_each(m_registry.begin(), m_registry.end(), [this, state](std::pair<uint64_t, rws::ws_handle_t> it) {
             miledger::ws_message res(ws_message::type_t::event_device_state_changed, DeviceServer::stateToString(state));
@@ -144,6 +158,33 @@ restinio::request_handling_status_t miledger::WsServer::handleHttpRequest(
     case ws_message::action_get_device_state:
         res = miledger::ws_message(ws_message::type_t::result_get_device_state, m_app->dev.getStateString());
         break;
+    case ws_message::action_search: {
+        miledger::net::request tmp("http://localhost");
+        tmp.parse_query(QString::fromStdString(std::string(req->header().query())));
+        if (!tmp.has_query("q")) {
+            res.value = "GET parameter q is required";
+            break;
+        }
+        res = search(
+            tmp.get_query_value("q").toStdString(),
+            tmp.has_query("limit") ? tmp.get_query_value("limit").toStdString() : "");
+    } break;
+    case ws_message::action_tx_lookup: {
+        miledger::net::request tmp("http://localhost");
+        tmp.parse_query(QString::fromStdString(std::string(req->header().query())));
+        auto param = [&tmp](const QString& name) {
+            return tmp.has_query(name) ? tmp.get_query_value(name).toStdString() : std::string();
+        };
+        res = lookupTx(param("value"), param("from_block"), param("to_block"), param("limit"));
+    } break;
+    case ws_message::action_rewards: {
+        miledger::net::request tmp("http://localhost");
+        tmp.parse_query(QString::fromStdString(std::string(req->header().query())));
+        auto param = [&tmp](const QString& name) {
+            return tmp.has_query(name) ? tmp.get_query_value(name).toStdString() : std::string();
+        };
+        res = rewards(param("scale"), param("from"), param("to"));
+    } break;
     case ws_message::action_get_address: {
         if (!m_app->dev.canInteract()) {
             nlohmann::json pl;
@@ -252,6 +293,22 @@ void miledger::WsServer::handleRequestMessage(uint64_t recipient, const miledger
         sendMessage(recipient, res);
         return;
     }
+    case ws_message::type_t::action_search: {
+        sendMessage(recipient, search(message.value, message.get_payload_value("limit")));
+        return;
+    }
+    case ws_message::type_t::action_tx_lookup: {
+        sendMessage(recipient, lookupTx(
+                                   message.value,
+                                   message.get_payload_value("from_block"),
+                                   message.get_payload_value("to_block"),
+                                   message.get_payload_value("limit")));
+        return;
+    }
+    case ws_message::type_t::action_rewards: {
+        sendMessage(recipient, rewards(message.value, message.get_payload_value("from"), message.get_payload_value("to")));
+        return;
+    }
 
     case ws_message::type_t::action_sign_tx: {
         if (!m_app->dev.canInteract()) {
@@ -305,6 +362,149 @@ void miledger::WsServer::handleRequestMessage(uint64_t recipient, const miledger
     }
 }
 
+miledger::ws_message miledger::WsServer::search(const std::string& query, const std::string& limit) const {
+    miledger::ws_message res;
+    if (query.empty()) {
+        res.value = "Search query is empty";
+        return res;
+    }
+    size_t max = 10;
+    if (!limit.empty()) {
+        bool ok = false;
+        const uint value = QString::fromStdString(limit).toUInt(&ok);
+        if (!ok || value == 0 || value > 100) {
+            res.value = "Search limit must be a number from 1 to 100";
+            return res;
+        }
+        max = value;
+    }
+
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& match : m_app->searchIndex.search(QString::fromStdString(query), max)) {
+        nlohmann::json item;
+        item["kind"] = SearchIndex::kindToString(match.kind);
+        item["key"] = match.key;
+        item["title"] = match.title.toStdString();
+        item["subtitle"] = match.subtitle.toStdString();
+        item["score"] = match.score;
+        items.push_back(std::move(item));
+    }
+
+    res = miledger::ws_message(ws_message::type_t::result_search, query);
+    res.payload["items"] = std::move(items);
+    return res;
+}
+
+miledger::ws_message miledger::WsServer::lookupTx(const std::string& value, const std::string& fromBlock, const std::string& toBlock, const std::string& limit) const {
+    miledger::ws_message res;
+    // replaced from UI thread when address changes
+    const auto log = std::atomic_load(&m_app->txLog);
+    if (!log) {
+        res.value = "Transaction log is not ready: device address is not resolved yet";
+        return res;
+    }
+    size_t max = 50;
+    if (!limit.empty()) {
+        bool ok = false;
+        const uint count = QString::fromStdString(limit).toUInt(&ok);
+        if (!ok || count == 0 || count > 1000) {
+            res.value = "Lookup limit must be a number from 1 to 1000";
+            return res;
+        }
+        max = count;
+    }
+
+    std::vector<minter::explorer::transaction_item> found;
+    if (value.rfind("Mt", 0) == 0) {
+        if (auto tx = log->find_by_hash(value)) {
+            found.push_back(std::move(*tx));
+        }
+    } else if (value.rfind("Mx", 0) == 0) {
+        found = log->find_by_counterparty(value, max);
+    } else if (value.empty()) {
+        bool fromOk = false, toOk = false;
+        const uint64_t from = QString::fromStdString(fromBlock).toULongLong(&fromOk);
+        const uint64_t to = QString::fromStdString(toBlock).toULongLong(&toOk);
+        if (!fromOk || !toOk || from > to) {
+            res.value = "Block range must be set as from_block and to_block, from_block <= to_block";
+            return res;
+        }
+        found = log->find_by_blocks(from, to, max);
+    } else {
+        res.value = "Lookup value must be transaction hash (Mt...) or address (Mx...)";
+        return res;
+    }
+
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& tx : found) {
+        nlohmann::json item;
+        item["hash"] = tx.hash.to_string();
+        item["height"] = minter::utils::to_string(tx.height);
+        item["timestamp"] = tx.timestamp;
+        item["type"] = (int) tx.type;
+        item["from"] = tx.from.to_string();
+        items.push_back(std::move(item));
+    }
+
+    res = miledger::ws_message(ws_message::type_t::result_tx_lookup, value);
+    res.payload["items"] = std::move(items);
+    res.payload["synced_height"] = log->synced_height();
+    return res;
+}
+
+miledger::ws_message miledger::WsServer::rewards(const std::string& scale, const std::string& from, const std::string& to) const {
+    miledger::ws_message res;
+    // replaced from UI thread when address changes
+    const auto store = std::atomic_load(&m_app->rewardsStore);
+    if (!store) {
+        res.value = "Rewards are not ready: device address is not resolved yet";
+        return res;
+    }
+
+    miledger::repo::explorer_repo::reward_period period;
+    if (scale == "minute") {
+        period = miledger::repo::explorer_repo::minute;
+    } else if (scale == "hour") {
+        period = miledger::repo::explorer_repo::hour;
+    } else if (scale == "day" || scale.empty()) {
+        period = miledger::repo::explorer_repo::day;
+    } else {
+        res.value = "Rewards scale must be minute, hour or day";
+        return res;
+    }
+
+    auto parseTime = [](const std::string& value) -> int64_t {
+        bool ok = false;
+        const qlonglong seconds = QString::fromStdString(value).toLongLong(&ok);
+        return ok ? (int64_t) seconds : miledger::repo::rewards_store::parse_time(value);
+    };
+    const int64_t begin = parseTime(from);
+    const int64_t end = to.empty() ? QDateTime::currentSecsSinceEpoch() : parseTime(to);
+    if (from.empty() || begin < 0 || end < 0 || begin > end) {
+        res.value = "Rewards range must be set as from and optional to, from <= to";
+        return res;
+    }
+
+    // a month of minutes would be 43200 points: range is answered by pages, client continues from next_from
+    const size_t maxPoints = 1440;
+    const auto points = store->query(begin, end, period, maxPoints + 1);
+    nlohmann::json items = nlohmann::json::array();
+    for (size_t i = 0; i < points.size() && i < maxPoints; i++) {
+        nlohmann::json item;
+        item["time"] = miledger::repo::rewards_store::format_time(points[i].time);
+        item["amount"] = minter::utils::to_string(points[i].amount);
+        items.push_back(std::move(item));
+    }
+
+    res = miledger::ws_message(ws_message::type_t::result_rewards, scale.empty() ? "day" : scale);
+    res.payload["items"] = std::move(items);
+    if (points.size() > maxPoints) {
+        res.payload["next_from"] = points[maxPoints].time;
+    }
+    res.payload["total"] = minter::utils::to_string(store->total(begin, end));
+    return res;
+}
+
 std::unique_ptr<router_t> miledger::WsServer::requestHandler() {
     auto router = std::make_unique<router_t>();
 
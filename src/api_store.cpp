@@ -0,0 +1,217 @@
+/*!
+ * miledger.
+ * api_store.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/api_store.h"
+
+#include "include/miledger-config.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+namespace {
+const char store_magic[8] = {'M', 'L', 'A', 'S', 0, 0, 0, 1};
+// garbage less than this is not worth rewriting the file
+constexpr uint64_t compact_min_dead = 256 * 1024;
+} // namespace
+
+miledger::net::api_store::api_store() {
+#ifdef MILEDGER_APPLE
+    const QString dir = QCoreApplication::applicationDirPath() + "/../Resources/cache";
+#else
+    const QString dir = QCoreApplication::applicationDirPath() + "/cache";
+#endif
+    QDir().mkpath(dir);
+    open(QDir::toNativeSeparators(dir + "/api.store").toStdString());
+}
+
+miledger::net::api_store::~api_store() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_file.close();
+}
+
+bool miledger::net::api_store::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_file.close();
+    m_entries.clear();
+    m_dead_bytes = 0;
+    m_file_size = 0;
+    m_file.setFileName(QString::fromStdString(path));
+
+    load();
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Unable to open api store" << m_file.fileName() << ":" << m_file.errorString();
+        return false;
+    }
+    if (m_file_size == 0) {
+        m_file.write(store_magic, sizeof(store_magic));
+        m_file.flush();
+        m_file_size = sizeof(store_magic);
+    }
+    return true;
+}
+
+bool miledger::net::api_store::find(const std::string& key, entry& out) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    out = it->second;
+    return true;
+}
+
+bool miledger::net::api_store::put(const std::string& key, std::string value, uint64_t tag) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->second.tag == tag) {
+        return false;
+    }
+
+    entry e;
+    e.value = std::move(value);
+    e.tag = tag;
+    if (m_file.isOpen()) {
+        const std::string rec = make_record(key, e);
+        if (m_file.write(rec.data(), (qint64) rec.size()) == (qint64) rec.size() && m_file.flush()) {
+            m_file_size += rec.size();
+            if (it != m_entries.end()) {
+                m_dead_bytes += record_size(key, it->second);
+            }
+        }
+    }
+
+    if (it != m_entries.end()) {
+        it->second = std::move(e);
+    } else {
+        m_entries.emplace(key, std::move(e));
+    }
+    return true;
+}
+
+size_t miledger::net::api_store::size() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_entries.size();
+}
+
+uint64_t miledger::net::api_store::hash(const char* data, size_t len, uint64_t seed) {
+    uint64_t h = seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t miledger::net::api_store::fingerprint(const std::string& body) {
+    const auto j = nlohmann::json::parse(body, nullptr, false);
+    if (j.is_discarded()) {
+        return hash(body.data(), body.size());
+    }
+    const std::string canonical = j.contains("data") ? j.at("data").dump() : j.dump();
+    return hash(canonical.data(), canonical.size());
+}
+
+void miledger::net::api_store::load() {
+    if (!m_file.exists() || !m_file.open(QIODevice::ReadWrite)) {
+        return;
+    }
+
+    const qint64 size = m_file.size();
+    uint64_t good_end = 0;
+    if (size >= (qint64) sizeof(store_magic)) {
+        // one pass over the mapped file, values are copied out of it
+        const uchar* data = m_file.map(0, size);
+        if (data && std::memcmp(data, store_magic, sizeof(store_magic)) == 0) {
+            uint64_t pos = sizeof(store_magic);
+            while (pos + sizeof(record_header) <= (uint64_t) size) {
+                record_header hdr;
+                std::memcpy(&hdr, data + pos, sizeof(hdr));
+                const uint64_t end = pos + sizeof(hdr) + hdr.key_len + hdr.value_len;
+                if (end > (uint64_t) size) {
+                    break;
+                }
+                const char* key = (const char*) data + pos + sizeof(hdr);
+                const char* value = key + hdr.key_len;
+                if (hash(value, hdr.value_len, hash(key, hdr.key_len)) != hdr.checksum) {
+                    // torn write: everything after it is unreliable
+                    break;
+                }
+
+                entry e;
+                e.value.assign(value, hdr.value_len);
+                e.tag = hdr.tag;
+                std::string k(key, hdr.key_len);
+                auto it = m_entries.find(k);
+                if (it != m_entries.end()) {
+                    m_dead_bytes += record_size(k, it->second);
+                    it->second = std::move(e);
+                } else {
+                    m_entries.emplace(std::move(k), std::move(e));
+                }
+                pos = end;
+            }
+            good_end = pos;
+        }
+        if (data) {
+            m_file.unmap(const_cast<uchar*>(data));
+        }
+    }
+
+    if (good_end < (uint64_t) size) {
+        // unknown format or torn tail
+        m_file.resize((qint64) good_end);
+    }
+    m_file.close();
+    m_file_size = good_end;
+
+    if (m_dead_bytes >= compact_min_dead && m_dead_bytes * 2 > m_file_size) {
+        compact();
+    }
+}
+
+void miledger::net::api_store::compact() {
+    // written aside and renamed over the store: crash in the middle leaves the old file
+    QSaveFile out(m_file.fileName());
+    if (!out.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    uint64_t written = out.write(store_magic, sizeof(store_magic));
+    for (const auto& it : m_entries) {
+        const std::string rec = make_record(it.first, it.second);
+        written += out.write(rec.data(), (qint64) rec.size());
+    }
+    if (out.commit()) {
+        m_file_size = written;
+        m_dead_bytes = 0;
+    }
+}
+
+std::string miledger::net::api_store::make_record(const std::string& key, const entry& e) {
+    record_header hdr;
+    hdr.key_len = (uint32_t) key.size();
+    hdr.value_len = (uint32_t) e.value.size();
+    hdr.tag = e.tag;
+    hdr.checksum = hash(e.value.data(), e.value.size(), hash(key.data(), key.size()));
+
+    std::string out;
+    out.reserve(sizeof(hdr) + key.size() + e.value.size());
+    out.append((const char*) &hdr, sizeof(hdr));
+    out += key;
+    out += e.value;
+    return out;
+}
+
+uint64_t miledger::net::api_store::record_size(const std::string& key, const entry& e) {
+    return sizeof(record_header) + key.size() + e.value.size();
+}
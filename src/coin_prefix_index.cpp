@@ -0,0 +1,109 @@
+/*!
+ * miledger.
+ * coin_prefix_index.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/coin_prefix_index.h"
+
+#include "include/miledger-config.h"
+
+#include <algorithm>
+
+void miledger::CoinPrefixIndex::build(const std::vector<minter::explorer::coin_item>& coins) {
+    mEntries.clear();
+    mSymbols.clear();
+    mNames.clear();
+    mRowsById.clear();
+    mEntries.reserve(coins.size());
+    mSymbols.reserve(coins.size());
+    mNames.reserve(coins.size() * 2);
+
+    for (const auto& coin : coins) {
+        const uint32_t row = (uint32_t) mEntries.size();
+        Entry entry;
+        entry.id = QString::fromStdString(minter::utils::to_string(coin.id));
+        entry.symbol = QString::fromStdString(coin.symbol);
+        entry.name = QString::fromStdString(coin.name);
+        entry.avatarUrl = QString("%1%2").arg(QString(MINTER_COIN_AVATAR_URL), entry.symbol);
+        entry.type = coin.type;
+
+        mSymbols.emplace_back(entry.symbol.toCaseFolded(), row);
+        mRowsById.insert(entry.id, row);
+
+        // whole name and each next word of it, so "Bitcoin Cash" is found by "cash" too
+        const QString name = entry.name.toCaseFolded();
+        for (int i = 0; i < name.size(); i++) {
+            if (name.at(i).isSpace()) {
+                continue;
+            }
+            if (i == 0 || name.at(i - 1).isSpace()) {
+                mNames.emplace_back(name.mid(i), row);
+            }
+        }
+
+        mEntries.push_back(std::move(entry));
+    }
+
+    std::sort(mSymbols.begin(), mSymbols.end());
+    std::sort(mNames.begin(), mNames.end());
+}
+
+std::vector<uint32_t> miledger::CoinPrefixIndex::find(const QString& prefix, size_t limit) const {
+    const QString folded = prefix.trimmed().toCaseFolded();
+    if (folded.isEmpty()) {
+        return {};
+    }
+
+    std::vector<uint32_t> out = findRange(mSymbols, folded);
+    if (limit > 0 && out.size() >= limit) {
+        out.resize(limit);
+        return out;
+    }
+
+    std::vector<uint32_t> byName = findRange(mNames, folded);
+    if (!byName.empty()) {
+        std::vector<uint32_t> bySymbol = out;
+        for (uint32_t row : byName) {
+            if (!std::binary_search(bySymbol.begin(), bySymbol.end(), row)) {
+                out.push_back(row);
+            }
+        }
+    }
+    if (limit > 0 && out.size() > limit) {
+        out.resize(limit);
+    }
+    return out;
+}
+
+int miledger::CoinPrefixIndex::rowById(const QString& id) const {
+    auto it = mRowsById.find(id);
+    return it == mRowsById.end() ? -1 : (int) it.value();
+}
+
+const miledger::CoinPrefixIndex::Entry& miledger::CoinPrefixIndex::at(uint32_t row) const {
+    return mEntries.at(row);
+}
+
+size_t miledger::CoinPrefixIndex::size() const {
+    return mEntries.size();
+}
+
+std::vector<uint32_t> miledger::CoinPrefixIndex::findRange(const std::vector<key_t>& keys, const QString& folded) {
+    // first key which is not less than prefix starts the range
+    auto it = std::lower_bound(keys.begin(), keys.end(), folded, [](const key_t& key, const QString& value) {
+        return key.first < value;
+    });
+
+    std::vector<uint32_t> rows;
+    for (; it != keys.end() && it->first.startsWith(folded); ++it) {
+        rows.push_back(it->second);
+    }
+    // row is rank: lower row - higher rank
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
@@ -0,0 +1,154 @@
+/*!
+ * miledger.
+ * coin_registry.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/coin_registry.h"
+
+#include <unordered_set>
+
+bool miledger::CoinRegistry::RankKey::operator<(const RankKey& other) const {
+    if (top != other.top) {
+        return top < other.top;
+    }
+    if (!(reserve == other.reserve)) {
+        return reserve > other.reserve;
+    }
+    // makes order total, so each entry has exactly one place
+    return id < other.id;
+}
+
+miledger::CoinRegistry::CoinRegistry(const std::vector<dev::bigint>& topIds) {
+    for (size_t i = 0; i < topIds.size(); i++) {
+        mTopRanks.emplace(minter::utils::to_string(topIds[i]), i);
+    }
+}
+
+miledger::CoinRegistry::Delta miledger::CoinRegistry::apply(std::vector<minter::explorer::coin_item>&& coins) {
+    Delta delta;
+    std::vector<Entry*> reordered;
+    std::unordered_set<std::string> seen;
+    seen.reserve(coins.size());
+
+    for (auto& coin : coins) {
+        seen.insert(minter::utils::to_string(coin.id));
+        put(std::move(coin), delta, reordered);
+    }
+
+    if (seen.size() != mEntries.size()) {
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            if (seen.count(it->first)) {
+                ++it;
+                continue;
+            }
+            eraseFromOrder(&it->second);
+            const QString key = indexKey(*it->second.item);
+            if (mIndex.value(key) == it->second.item.get()) {
+                mIndex.remove(key);
+            }
+            delta.removedIds.push_back(it->first);
+            it = mEntries.erase(it);
+            delta.removed++;
+        }
+    }
+
+    for (Entry* entry : reordered) {
+        insertToOrder(entry);
+    }
+    delta.moved = reordered.size();
+    return delta;
+}
+
+std::vector<minter::explorer::coin_item> miledger::CoinRegistry::toVector() const {
+    std::vector<minter::explorer::coin_item> out;
+    out.reserve(mOrder.size());
+    for (const Entry* entry : mOrder) {
+        out.push_back(*entry->item);
+    }
+    return out;
+}
+
+const QHash<QString, minter::explorer::coin_item*>& miledger::CoinRegistry::getIndex() const {
+    return mIndex;
+}
+
+size_t miledger::CoinRegistry::size() const {
+    return mEntries.size();
+}
+
+miledger::CoinRegistry::RankKey miledger::CoinRegistry::makeKey(const minter::explorer::coin_item& coin) const {
+    RankKey key;
+    auto top = mTopRanks.find(minter::utils::to_string(coin.id));
+    key.top = top == mTopRanks.end() ? mTopRanks.size() : top->second;
+    key.reserve = coin.reserve_valance;
+    key.id = coin.id;
+    return key;
+}
+
+void miledger::CoinRegistry::put(minter::explorer::coin_item&& coin, Delta& delta, std::vector<Entry*>& reordered) {
+    const std::string id = minter::utils::to_string(coin.id);
+    auto it = mEntries.find(id);
+    if (it == mEntries.end()) {
+        Entry entry;
+        entry.item = std::make_unique<minter::explorer::coin_item>(std::move(coin));
+        entry.key = makeKey(*entry.item);
+        // map nodes don't move on rehash, so entry pointer is stable
+        Entry* added = &mEntries.emplace(id, std::move(entry)).first->second;
+        mIndex.insert(indexKey(*added->item), added->item.get());
+        reordered.push_back(added);
+        delta.touched.push_back(added->item.get());
+        delta.added++;
+        return;
+    }
+
+    Entry& entry = it->second;
+    minter::explorer::coin_item& current = *entry.item;
+    const bool symbolChanged = current.symbol != coin.symbol;
+    const bool rankChanged = !(current.reserve_valance == coin.reserve_valance);
+    const bool changed = symbolChanged || rankChanged || current.name != coin.name || current.type != coin.type;
+
+    if (symbolChanged) {
+        mIndex.remove(indexKey(current));
+    }
+    // must be found by old key
+    const bool wasInOrder = rankChanged && eraseFromOrder(&entry);
+
+    // other fields are not shown in lists, they are updated in place without counting as change
+    current = std::move(coin);
+
+    if (symbolChanged) {
+        mIndex.insert(indexKey(current), &current);
+    }
+    if (rankChanged) {
+        entry.key = makeKey(current);
+        // duplicate of coin in the same list: entry is already waiting for insert
+        if (wasInOrder) {
+            reordered.push_back(&entry);
+        }
+    }
+    if (changed) {
+        delta.touched.push_back(&current);
+        delta.changed++;
+    }
+}
+
+bool miledger::CoinRegistry::eraseFromOrder(Entry* entry) {
+    auto it = mOrder.find(entry);
+    if (it == mOrder.end() || *it != entry) {
+        return false;
+    }
+    mOrder.erase(it);
+    return true;
+}
+
+void miledger::CoinRegistry::insertToOrder(Entry* entry) {
+    mOrder.insert(entry);
+}
+
+QString miledger::CoinRegistry::indexKey(const minter::explorer::coin_item& coin) {
+    return QString::fromStdString(coin.symbol).toUpper();
+}
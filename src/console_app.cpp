@@ -12,14 +12,29 @@
 #include "include/app.h"
 #include "include/errors.h"
 #include "include/image_cache.h"
+#include "include/miledger-config.h"
+#include "include/net/metrics.h"
+#include "include/net/warmup.h"
 #include "include/utils.h"
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QIcon>
 #include <QSize>
 #include <cpr/cpr.h>
 #include <fstream>
 
+namespace {
+std::string cacheDir(const QString& name) {
+#ifdef MILEDGER_APPLE
+    const QString dir = QCoreApplication::applicationDirPath() + "/../Resources/cache/" + name;
+#else
+    const QString dir = QCoreApplication::applicationDirPath() + "/cache/" + name;
+#endif
+    return QDir::toNativeSeparators(dir).toStdString();
+}
+} // namespace
+
 miledger::ConsoleApp::ConsoleApp(QObject* parent)
     : QObject(parent)
     , devThread()
@@ -29,10 +44,15 @@ miledger::ConsoleApp::ConsoleApp(QObject* parent)
 
     dev.moveToThread(&devThread);
 
+    // reserves move with every swap in network, estimates are made locally between refreshes
+    mPoolsTimer.setInterval(30000);
+    connect(&mPoolsTimer, &QTimer::timeout, this, &ConsoleApp::updatePools);
+
     connect(this, &ConsoleApp::addressResolved, [this](const minter::address_t&) {
         updateBalance();
         updateInitData();
-        updateCoinList();
+        updateTxLog();
+        updateRewards();
     });
 }
 
@@ -49,6 +69,19 @@ miledger::ConsoleApp::~ConsoleApp() {
     std::cout << "exited from miledger" << std::endl;
 }
 void miledger::ConsoleApp::start() {
+    // while device is connecting, resolve and connect to hosts which will be needed right after address is resolved
+    miledger::net::warmup::get().start({
+        MINTER_EXPLORER_API,
+        MINTER_GATE_API,
+        MINTER_COIN_AVATAR_URL,
+    });
+    // last known data is shown right away, network answers replace it if they differ
+    updateCoinList();
+    updateFees();
+    updateValidators();
+    updatePools();
+    mPoolsTimer.start();
+
     // receive handler signals
     connect(&dev, SIGNAL(deviceStateChanged(dev_state)), this, SLOT(onDeviceStateChanged(dev_state)));
     // run handler after thread started
@@ -63,6 +96,8 @@ void miledger::ConsoleApp::start() {
 
 void miledger::ConsoleApp::onDeviceStateChanged(dev_state state) {
     if (state == dev_state::APP_OPENED) {
+        mAppOpenedAt = std::chrono::steady_clock::now();
+        mBalanceTimed = false;
         dev.getAddress()
             .subscribe_on(RxQt::get().ioThread())
             .observe_on(RxQt::get().uiThread())
@@ -105,30 +140,33 @@ void miledger::ConsoleApp::updateCoinList() {
                    .subscribe_on(RxQt::get().ioThread())
                    .observe_on(RxQt::get().uiThread())
                    .subscribe(
-                       [this](minter::explorer::result<std::vector<minter::explorer::coin_item>> result) {
+                       [this](miledger::net::stored_value<minter::explorer::result<std::vector<minter::explorer::coin_item>>> stored) {
+                           auto& result = stored.value;
                            if (result.error.message.empty()) {
+                               if (stored.tag == mCoinsTag) {
+                                   return;
+                               }
+                               mCoinsTag = stored.tag;
+                               CoinRegistry::Delta delta;
                                {
                                    std::lock_guard<std::mutex> lock(mCoinsLock);
-
-                                   auto tmp = std::move(result.data);
-                                   std::sort(tmp.begin(), tmp.end(), [this](const minter::explorer::coin_item& left, const minter::explorer::coin_item& right) {
-                                       for (const auto& top_id : mTopCoinsIds) {
-                                           if (left.id == top_id) {
-                                               return true;
-                                           }
-                                           if (right.id == top_id) {
-                                               return false;
-                                           }
-                                       }
-
-                                       return left.reserve_valance > right.reserve_valance;
-                                   });
-                                   coins = tmp;
-                                   for (size_t i = 0; i < coins.size(); i++) {
-                                       coinsIndex.insert(QString::fromStdString(coins.at(i).symbol).toUpper(), &coins.at(i));
+                                   delta = mCoins.apply(std::move(result.data));
+                                   // touched items are valid under the lock only
+                                   for (const auto* coin : delta.touched) {
+                                       searchIndex.upsert(
+                                           SearchIndex::Kind::Coin,
+                                           minter::utils::to_string(coin->id),
+                                           QString::fromStdString(coin->symbol),
+                                           QString::fromStdString(coin->name));
                                    }
+                                   for (const auto& id : delta.removedIds) {
+                                       searchIndex.remove(SearchIndex::Kind::Coin, id);
+                                   }
+                               }
+                               if (delta.empty()) {
+                                   return;
                                }
-                               emit coinListUpdated(coins);
+                               emit coinListUpdated(getCoins());
                            } else {
                                qDebug() << "[" << result.error.code << "] " << QString::fromStdString(result.error.message);
                            }
@@ -138,6 +176,116 @@ void miledger::ConsoleApp::updateCoinList() {
                        });
     subs.add(sub);
 }
+void miledger::ConsoleApp::updateValidators() {
+    auto sub = explorerRepo.get_validators()
+                   .subscribe_on(RxQt::get().ioThread())
+                   .subscribe(
+                       [this](minter::explorer::result<miledger::repo::validator_list_t> result) {
+                           if (!result.error.message.empty()) {
+                               qDebug() << "[" << result.error.code << "] " << QString::fromStdString(result.error.message);
+                               return;
+                           }
+                           std::unordered_set<std::string> keys;
+                           for (const auto& validator : result.data) {
+                               const std::string pubkey = validator.pub_key.to_string();
+                               keys.insert(pubkey);
+                               searchIndex.upsert(
+                                   SearchIndex::Kind::Validator,
+                                   pubkey,
+                                   QString::fromStdString(validator.name),
+                                   QString::fromStdString(pubkey));
+                           }
+                           searchIndex.retain(SearchIndex::Kind::Validator, keys);
+                       },
+                       [](const std::exception_ptr& e) {
+                           qDebug() << miledger::utils::getError(e);
+                       });
+    subs.add(sub);
+}
+void miledger::ConsoleApp::updateTxLog() {
+    if (!address) {
+        return;
+    }
+    if (!txLog || txLog->address() != address) {
+        auto log = std::make_shared<miledger::repo::tx_log>(explorerRepo, address, cacheDir("txlog"));
+        if (!log->open()) {
+            return;
+        }
+        // read from WebSocket server thread
+        std::atomic_store(&txLog, log);
+    }
+
+    // log is kept alive by subscription, even if address changes meanwhile
+    auto log = txLog;
+    auto sub = log->sync()
+                   .subscribe_on(RxQt::get().ioThread())
+                   .subscribe(
+                       [log](size_t added) {
+                           qDebug() << "Transaction log synced:" << added << "new, up to block" << log->synced_height();
+                       },
+                       [](const std::exception_ptr& e) {
+                           qDebug() << miledger::utils::getError(e);
+                       });
+    subs.add(sub);
+}
+void miledger::ConsoleApp::updateRewards() {
+    if (!address) {
+        return;
+    }
+    if (!rewardsStore || rewardsStore->address() != address) {
+        auto store = std::make_shared<miledger::repo::rewards_store>(explorerRepo, address, cacheDir("rewards"));
+        if (!store->open()) {
+            return;
+        }
+        // read from WebSocket server thread
+        std::atomic_store(&rewardsStore, store);
+    }
+
+    auto store = rewardsStore;
+    auto sub = store->sync()
+                   .subscribe_on(RxQt::get().ioThread())
+                   .observe_on(RxQt::get().uiThread())
+                   .subscribe(
+                       [this, store](size_t added) {
+                           if (added > 0 && store == rewardsStore) {
+                               emit rewardsUpdated();
+                           }
+                       },
+                       [](const std::exception_ptr& e) {
+                           qDebug() << miledger::utils::getError(e);
+                       });
+    subs.add(sub);
+}
+void miledger::ConsoleApp::updatePools() {
+    if (mPoolsSub.is_subscribed()) {
+        // previous refresh is still loading pages
+        return;
+    }
+    subs.remove(mPoolsSub);
+    auto sub = poolGraph.refresh()
+                   .subscribe_on(RxQt::get().ioThread())
+                   .subscribe(
+                       [this](size_t count) {
+                           qDebug() << "Pools loaded:" << count;
+                           std::unordered_set<std::string> keys;
+                           for (const auto& pool : poolGraph.pools()) {
+                               const std::string key = minter::utils::to_string(pool.coin0.id) + "-" + minter::utils::to_string(pool.coin1.id);
+                               keys.insert(key);
+                               searchIndex.upsert(
+                                   SearchIndex::Kind::Pool,
+                                   key,
+                                   QString::fromStdString(pool.coin0.symbol + "/" + pool.coin1.symbol),
+                                   QString::fromStdString(pool.token));
+                           }
+                           searchIndex.retain(SearchIndex::Kind::Pool, keys);
+                       },
+                       [](const std::exception_ptr& e) {
+                           // previous graph is kept
+                           qDebug() << miledger::utils::getError(e);
+                       });
+    mPoolsSub = sub;
+    subs.add(sub);
+}
 void miledger::ConsoleApp::updateBalance() {
     if (!address) {
         return;
@@ -147,10 +295,21 @@ void miledger::ConsoleApp::updateBalance() {
                    .subscribe_on(RxQt::get().ioThread())
                    .observe_on(RxQt::get().uiThread())
                    .subscribe(
-                       [this](minter::explorer::result<minter::explorer::balance_items> result) {
+                       [this](miledger::net::stored_value<minter::explorer::result<minter::explorer::balance_items>> stored) {
+                           const auto& result = stored.value;
                            if (result.error.message.empty()) {
+                               if (stored.tag == mBalanceTag) {
+                                   return;
+                               }
+                               mBalanceTag = stored.tag;
                                balances = result.data;
                                qDebug() << "Update balance";
+                               if (!mBalanceTimed) {
+                                   mBalanceTimed = true;
+                                   miledger::net::metrics_registry::get().record_timing(
+                                       "app.opened_to_balance",
+                                       std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mAppOpenedAt));
+                               }
                                emit balanceUpdated(balances);
                            } else {
                                qDebug() << "[" << result.error.code << "] " << QString::fromStdString(result.error.message);
@@ -161,18 +320,44 @@ void miledger::ConsoleApp::updateBalance() {
                        });
     subs.add(sub);
 }
-const std::vector<minter::explorer::coin_item>& miledger::ConsoleApp::getCoins() const {
+void miledger::ConsoleApp::updateFees() {
+    auto sub = gateRepo.get_stored_min_gas()
+                   .combine_latest(gateRepo.get_stored_price_commissions())
+                   .subscribe_on(RxQt::get().ioThread())
+                   .observe_on(RxQt::get().uiThread())
+                   .subscribe(
+                       [this](std::tuple<miledger::net::stored_value<minter::gate::gas_value>, miledger::net::stored_value<minter::gate::price_commissions>> result) {
+                           const auto& gas = std::get<0>(result);
+                           const auto& fees = std::get<1>(result);
+                           const uint64_t tag = gas.tag * 31 + fees.tag;
+                           if (tag == mFeesTag) {
+                               return;
+                           }
+                           mFeesTag = tag;
+                           // nonce is left as is: it comes only from network with updateInitData()
+                           initData.gas = gas.value.gas;
+                           initData.tx_fees = fees.value;
+                           initData.gas_representing_coin = fees.value.coin;
+                           emit initDataUpdated(initData);
+                       },
+                       [](const std::exception_ptr& e) {
+                           qDebug() << miledger::utils::getError(e);
+                       });
+    subs.add(sub);
+}
+std::vector<minter::explorer::coin_item> miledger::ConsoleApp::getCoins() const {
     std::lock_guard<std::mutex> lock(mCoinsLock);
-    return coins;
+    return mCoins.toVector();
 }
 const QHash<QString, minter::explorer::coin_item*>& miledger::ConsoleApp::getCoinsIndex() const {
     std::lock_guard<std::mutex> lock(mCoinsLock);
-    return coinsIndex;
+    return mCoins.getIndex();
 }
 optns::optional<minter::explorer::coin_item*> miledger::ConsoleApp::findCoinBySymbol(const QString& symbol) const {
     std::lock_guard<std::mutex> lock(mCoinsLock);
-    if (coinsIndex.contains(symbol.toUpper())) {
-        return coinsIndex.value(symbol.toUpper());
+    const auto& index = mCoins.getIndex();
+    if (index.contains(symbol.toUpper())) {
+        return index.value(symbol.toUpper());
     }
     return {};
 }
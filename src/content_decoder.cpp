@@ -0,0 +1,185 @@
+/*!
+ * miledger.
+ * content_decoder.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/content_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <brotli/decode.h>
+#include <cctype>
+#include <string>
+#include <zlib.h>
+
+struct miledger::net::decoding_sink::codec {
+    enum class kind {
+        identity,
+        zlib,
+        brotli,
+    };
+
+    explicit codec(kind type)
+        : type(type) {
+        if (type == kind::zlib) {
+            zs.zalloc = Z_NULL;
+            zs.zfree = Z_NULL;
+            zs.opaque = Z_NULL;
+            // 32: detect gzip or zlib header automatically
+            zlib_ready = inflateInit2(&zs, 15 + 32) == Z_OK;
+        } else if (type == kind::brotli) {
+            br = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        }
+    }
+
+    /// \brief Restart inflate for raw deflate stream without zlib header
+    bool reset_raw() {
+        if (zlib_ready) {
+            inflateEnd(&zs);
+        }
+        zs = z_stream{};
+        zs.zalloc = Z_NULL;
+        zs.zfree = Z_NULL;
+        zs.opaque = Z_NULL;
+        raw = true;
+        zlib_ready = inflateInit2(&zs, -15) == Z_OK;
+        return zlib_ready;
+    }
+
+    ~codec() {
+        if (zlib_ready) {
+            inflateEnd(&zs);
+        }
+        if (br) {
+            BrotliDecoderDestroyInstance(br);
+        }
+    }
+
+    kind type;
+    z_stream zs{};
+    bool zlib_ready = false;
+    // "deflate" is zlib stream by spec, but some servers send raw deflate: retry as raw on header error
+    bool raw_fallback = false;
+    bool raw = false;
+    // input given before the first output byte, to replay it as raw deflate
+    std::string head;
+    bool done = false;
+    BrotliDecoderState* br = nullptr;
+    std::array<char, 16384> out{};
+};
+
+const char* miledger::net::decoding_sink::accept_encoding() {
+    return "gzip, deflate, br";
+}
+
+miledger::net::decoding_sink::decoding_sink(std::shared_ptr<response_sink> inner, miledger::net::response* resp)
+    : m_inner(std::move(inner))
+    , m_resp(resp) {
+}
+
+miledger::net::decoding_sink::~decoding_sink() = default;
+
+bool miledger::net::decoding_sink::write(const char* data, size_t len) {
+    if (!m_initialized) {
+        m_initialized = true;
+        std::string encoding = m_resp->get_header("content-encoding");
+        std::transform(encoding.begin(), encoding.end(), encoding.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+        m_resp->content_encoding = encoding;
+
+        if (encoding == "gzip" || encoding == "x-gzip" || encoding == "deflate") {
+            m_codec = std::make_unique<codec>(codec::kind::zlib);
+            m_codec->raw_fallback = encoding == "deflate";
+        } else if (encoding == "br") {
+            m_codec = std::make_unique<codec>(codec::kind::brotli);
+        } else {
+            m_codec = std::make_unique<codec>(codec::kind::identity);
+        }
+    }
+
+    if (m_codec->type == codec::kind::identity) {
+        m_resp->bytes_decoded += len;
+        return m_inner->write(data, len);
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto inner_before = m_inner_time;
+    bool ok = true;
+
+    if (m_codec->type == codec::kind::zlib) {
+        auto& zs = m_codec->zs;
+        if (!m_codec->zlib_ready) {
+            return false;
+        }
+        if (m_codec->raw_fallback && !m_codec->raw && zs.total_out == 0) {
+            m_codec->head.append(data, len);
+        } else if (!m_codec->head.empty()) {
+            std::string().swap(m_codec->head);
+        }
+        zs.next_in = (Bytef*) data;
+        zs.avail_in = (uInt) len;
+        while (ok && zs.avail_in > 0 && !m_codec->done) {
+            zs.next_out = (Bytef*) m_codec->out.data();
+            zs.avail_out = (uInt) m_codec->out.size();
+            int res = inflate(&zs, Z_NO_FLUSH);
+            if (res == Z_DATA_ERROR && m_codec->raw_fallback && !m_codec->raw && zs.total_out == 0) {
+                if (!m_codec->reset_raw()) {
+                    ok = false;
+                    break;
+                }
+                zs.next_in = (Bytef*) m_codec->head.data();
+                zs.avail_in = (uInt) m_codec->head.size();
+                continue;
+            }
+            if (res != Z_OK && res != Z_STREAM_END) {
+                ok = false;
+                break;
+            }
+            const size_t produced = m_codec->out.size() - zs.avail_out;
+            if (produced > 0) {
+                ok = emit(m_codec->out.data(), produced);
+            }
+            if (res == Z_STREAM_END) {
+                m_codec->done = true;
+            } else if (produced == 0 && zs.avail_in > 0) {
+                // no progress with input left: corrupted stream
+                ok = false;
+            }
+        }
+    } else {
+        if (!m_codec->br) {
+            return false;
+        }
+        size_t avail_in = len;
+        auto* next_in = (const uint8_t*) data;
+        BrotliDecoderResult res;
+        do {
+            size_t avail_out = m_codec->out.size();
+            auto* next_out = (uint8_t*) m_codec->out.data();
+            res = BrotliDecoderDecompressStream(m_codec->br, &avail_in, &next_in, &avail_out, &next_out, nullptr);
+            if (res == BROTLI_DECODER_RESULT_ERROR) {
+                ok = false;
+                break;
+            }
+            const size_t produced = m_codec->out.size() - avail_out;
+            if (produced > 0) {
+                ok = emit(m_codec->out.data(), produced);
+            }
+        } while (ok && res == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+    }
+
+    const auto spent = (std::chrono::steady_clock::now() - started) - (m_inner_time - inner_before);
+    m_resp->decode_time += std::chrono::duration_cast<std::chrono::microseconds>(spent);
+    return ok;
+}
+
+bool miledger::net::decoding_sink::emit(const char* data, size_t len) {
+    const auto started = std::chrono::steady_clock::now();
+    m_resp->bytes_decoded += len;
+    bool ok = m_inner->write(data, len);
+    m_inner_time += std::chrono::steady_clock::now() - started;
+    return ok;
+}
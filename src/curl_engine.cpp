@@ -0,0 +1,464 @@
+/*!
+ * miledger.
+ * curl_engine.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/curl_engine.h"
+
+#include "include/net/content_decoder.h"
+#include "include/net/fixtures.h"
+#include "include/settings.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <vector>
+
+miledger::net::curl_engine::transfer::~transfer() {
+    if (headers) {
+        curl_slist_free_all(headers);
+        headers = nullptr;
+    }
+}
+
+miledger::net::curl_engine::curl_engine()
+    : m_multi(nullptr)
+    , m_share(nullptr)
+    , m_dns_ttl(std::chrono::seconds(Settings::get().getUint16(Settings::KEY_NET_DNS_TTL, 600)))
+    , m_host_limit(std::max<size_t>(1, Settings::get().getUint16(Settings::KEY_NET_HOST_CONCURRENCY, 6)))
+    , m_running(true)
+    , m_active_size(0)
+    , m_queued_size(0) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    m_multi = curl_multi_init();
+    // use HTTP/2 multiplexing where server supports it
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    // no lock functions: handles which use share are driven by the engine thread only
+    m_share = curl_share_init();
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    m_thread = std::thread(&curl_engine::run, this);
+}
+
+miledger::net::curl_engine::~curl_engine() {
+    m_running = false;
+    curl_multi_wakeup(m_multi);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (auto& it : m_active) {
+        curl_multi_remove_handle(m_multi, it.first);
+    }
+    m_active.clear();
+    curl_multi_cleanup(m_multi);
+    // fails with CURLSHE_IN_USE while pooled handles still refer to share, then it's left to process exit
+    curl_share_cleanup(m_share);
+}
+
+void miledger::net::curl_engine::submit(std::shared_ptr<miledger::net::http_call> call) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_pending.push_back(std::move(call));
+    }
+    curl_multi_wakeup(m_multi);
+}
+
+void miledger::net::curl_engine::cancel(std::shared_ptr<miledger::net::http_call> call) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_cancelled.push_back(std::move(call));
+    }
+    curl_multi_wakeup(m_multi);
+}
+
+void miledger::net::curl_engine::schedule(std::chrono::milliseconds delay, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_timers.emplace(std::chrono::steady_clock::now() + delay, std::move(task));
+    }
+    curl_multi_wakeup(m_multi);
+}
+
+size_t miledger::net::curl_engine::active_size() const {
+    return m_active_size.load(std::memory_order_relaxed);
+}
+
+size_t miledger::net::curl_engine::queued_size() const {
+    return m_queued_size.load(std::memory_order_relaxed);
+}
+
+void miledger::net::curl_engine::run() {
+    while (m_running.load(std::memory_order_acquire)) {
+        start_pending();
+
+        int still_running = 0;
+        curl_multi_perform(m_multi, &still_running);
+
+        int msgs_left = 0;
+        CURLMsg* msg;
+        bool finished = false;
+        while ((msg = curl_multi_info_read(m_multi, &msgs_left)) != nullptr) {
+            if (msg->msg == CURLMSG_DONE) {
+                finish(msg->easy_handle, msg->data.result);
+                finished = true;
+            }
+        }
+        if (finished) {
+            // freed slots
+            dispatch();
+        }
+
+        const int wait = run_timers(1000);
+
+        // sleeps until socket activity, timeout or submit() wakeup
+        curl_multi_poll(m_multi, nullptr, 0, wait, nullptr);
+    }
+}
+
+void miledger::net::curl_engine::start_pending() {
+    std::deque<std::shared_ptr<miledger::net::http_call>> pending;
+    std::vector<std::shared_ptr<miledger::net::http_call>> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        pending.swap(m_pending);
+        cancelled.swap(m_cancelled);
+    }
+
+    for (auto& call : pending) {
+        m_queued[(size_t) call->priority].push_back(std::move(call));
+    }
+    for (const auto& call : cancelled) {
+        abort(call);
+    }
+    dispatch();
+}
+
+void miledger::net::curl_engine::abort(const std::shared_ptr<miledger::net::http_call>& call) {
+    for (auto& queue : m_queued) {
+        auto it = std::find(queue.begin(), queue.end(), call);
+        if (it != queue.end()) {
+            queue.erase(it);
+            call->resp.cancelled = true;
+            call->resp.error_code = (int) CURLE_ABORTED_BY_CALLBACK;
+            call->resp.error_message = "Cancelled";
+            if (call->on_done) {
+                call->on_done(call);
+            }
+            return;
+        }
+    }
+
+    CURL* handle = nullptr;
+    for (const auto& it : m_active) {
+        if (it.second->call == call) {
+            handle = it.first;
+            break;
+        }
+    }
+    if (handle) {
+        call->resp.cancelled = true;
+        finish(handle, CURLE_ABORTED_BY_CALLBACK);
+    }
+    // otherwise already finished
+}
+
+void miledger::net::curl_engine::dispatch() {
+    const auto now = std::chrono::steady_clock::now();
+    size_t queued = 0;
+
+    for (auto& queue : m_queued) {
+        auto it = queue.begin();
+        while (it != queue.end()) {
+            std::string key = session_pool::key_for((*it)->req);
+            auto& host = m_hosts[key];
+            if (!can_start(host, (*it)->priority, now)) {
+                // keep order, but let calls to other hosts go
+                ++it;
+                continue;
+            }
+
+            auto call = std::move(*it);
+            it = queue.erase(it);
+            if (!call->begin(now)) {
+                call->resp.error_code = (int) CURLE_OPERATION_TIMEDOUT;
+                call->resp.error_message = "Call budget is spent in queue";
+                if (call->on_done) {
+                    call->on_done(call);
+                }
+                continue;
+            }
+            host.active++;
+            start(std::move(call), std::move(key));
+        }
+        queued += queue.size();
+    }
+
+    m_queued_size = queued;
+}
+
+bool miledger::net::curl_engine::can_start(const host_state& host, request_priority priority, std::chrono::steady_clock::time_point now) const {
+    switch (priority) {
+    case request_priority::interactive:
+        return host.active < m_host_limit + interactive_reserve;
+    case request_priority::normal:
+        return host.active < m_host_limit;
+    case request_priority::background:
+        return host.paused_until <= now && host.active < std::max<size_t>(1, m_host_limit / 2);
+    }
+    return true;
+}
+
+void miledger::net::curl_engine::update_backoff(host_state& host, const miledger::net::response& resp) {
+    if (resp.status_code != 429) {
+        if (!resp.is_network_error() && resp.status_code < 400) {
+            host.backoff = std::chrono::milliseconds(0);
+        }
+        return;
+    }
+
+    // Retry-After in seconds if server set it, otherwise exponential from 1s up to 1 minute
+    std::chrono::milliseconds delay(0);
+    const std::string retry_after = resp.get_header("retry-after");
+    if (!retry_after.empty() && std::isdigit((unsigned char) retry_after[0])) {
+        delay = std::chrono::seconds(std::strtol(retry_after.c_str(), nullptr, 10));
+    }
+    if (delay.count() <= 0) {
+        host.backoff = host.backoff.count() == 0
+                           ? std::chrono::milliseconds(1000)
+                           : std::min(host.backoff * 2, std::chrono::milliseconds(60000));
+        delay = host.backoff;
+    }
+
+    host.paused_until = std::chrono::steady_clock::now() + delay;
+    // wake up loop when pause ends, paused calls will be dispatched on that iteration
+    schedule(delay, []() {});
+}
+
+int miledger::net::curl_engine::run_timers(int max_wait) {
+    std::vector<std::function<void()>> due;
+    int wait = max_wait;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        const auto now = std::chrono::steady_clock::now();
+        auto it = m_timers.begin();
+        while (it != m_timers.end() && it->first <= now) {
+            due.push_back(std::move(it->second));
+            it = m_timers.erase(it);
+        }
+        if (it != m_timers.end()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(it->first - now).count() + 1;
+            wait = (int) std::min<long long>(wait, left);
+        }
+    }
+
+    for (auto& task : due) {
+        task();
+    }
+    // task may submit new call, don't sleep then
+    return due.empty() ? wait : 0;
+}
+
+void miledger::net::curl_engine::start(std::shared_ptr<miledger::net::http_call> call, std::string host_key) {
+    auto t = std::make_unique<transfer>(call, session_pool::get().acquire(host_key));
+    t->host_key = std::move(host_key);
+    CURL* handle = t->session.handle();
+
+    t->url = call->req.get_url_utf8();
+    // headers are stored in UTF-8, no conversion here
+    std::string line;
+    for (const auto& h : call->req.get_headers()) {
+        line.clear();
+        line.reserve(h.key.size() + h.value.size() + 2);
+        line += h.key;
+        line += ": ";
+        line += h.value;
+        t->headers = curl_slist_append(t->headers, line.c_str());
+    }
+
+    if (!call->req.get_headers().find("accept-encoding")) {
+        line = std::string("Accept-Encoding: ") + decoding_sink::accept_encoding();
+        t->headers = curl_slist_append(t->headers, line.c_str());
+    }
+
+    auto& fx = fixtures::get();
+    if (fx.get_mode() == fixtures::mode::replay) {
+        line = std::string(fixtures::url_header) + ": " + fixtures::fixture_url(call->req);
+        t->headers = curl_slist_append(t->headers, line.c_str());
+        t->url = fx.replay_url(call->req);
+    } else if (fx.get_mode() == fixtures::mode::record) {
+        t->record = true;
+    }
+
+    t->output = std::make_shared<decoding_sink>(
+        std::make_shared<recording_sink>(call->sink, t->record ? &t->recorded : nullptr),
+        &call->resp);
+
+    curl_easy_setopt(handle, CURLOPT_URL, t->url.c_str());
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, t.get());
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, t->headers);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curl_engine::write_callback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, t.get());
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, &curl_engine::header_callback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, t.get());
+    // handle may come from the pool, so reset everything what previous request could set
+    curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, nullptr);
+    curl_easy_setopt(handle, CURLOPT_NOBODY, 0L);
+    // body is decoded by decoding_sink while streaming, curl must pass it as is
+    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, nullptr);
+    curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
+    curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, (long) m_dns_ttl.count());
+    curl_easy_setopt(handle, CURLOPT_SSL_SESSIONID_CACHE, 1L);
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, (long) call->connect_timeout.count());
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, (long) call->total_timeout.count());
+
+#ifdef _MSC_VER
+    //@todo: use force winssl
+    call->verify_ssl = false;
+#endif
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, call->verify_ssl ? 1L : 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, call->verify_ssl ? 2L : 0L);
+
+    switch (call->req.get_method()) {
+    case miledger::net::request::method::get:
+        curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+        break;
+    case miledger::net::request::method::head:
+        curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+        break;
+    case miledger::net::request::method::post:
+    case miledger::net::request::method::put:
+    case miledger::net::request::method::delete_:
+        curl_easy_setopt(handle, CURLOPT_POST, 1L);
+        if (call->req.has_body_stream()) {
+            t->body_reader = call->req.get_body_stream();
+            // without postfields curl pulls body through read callback, unknown size - chunked encoding
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDS, nullptr);
+            curl_easy_setopt(handle, CURLOPT_READFUNCTION, &curl_engine::read_callback);
+            curl_easy_setopt(handle, CURLOPT_READDATA, t.get());
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) call->req.get_body_stream_size());
+        } else {
+            t->body = call->req.share_body();
+            const std::string& body = call->req.get_body_bytes();
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDS, body.data());
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) body.size());
+        }
+        if (call->req.get_method() != miledger::net::request::method::post) {
+            curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, call->req.get_method_str().toStdString().c_str());
+        }
+        break;
+    }
+
+    CURLMcode res = curl_multi_add_handle(m_multi, handle);
+    if (res != CURLM_OK) {
+        call->resp.error_code = (int) CURLE_FAILED_INIT;
+        call->resp.error_message = curl_multi_strerror(res);
+        t->session.discard();
+        m_hosts[t->host_key].active--;
+        t.reset();
+        if (call->on_done) {
+            call->on_done(call);
+        }
+        return;
+    }
+
+    m_active[handle] = std::move(t);
+    m_active_size = m_active.size();
+}
+
+void miledger::net::curl_engine::finish(CURL* handle, CURLcode code) {
+    auto it = m_active.find(handle);
+    if (it == m_active.end()) {
+        curl_multi_remove_handle(m_multi, handle);
+        return;
+    }
+
+    std::unique_ptr<transfer> t = std::move(it->second);
+    m_active.erase(it);
+    m_active_size = m_active.size();
+    curl_multi_remove_handle(m_multi, handle);
+
+    auto call = t->call;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &call->resp.status_code);
+    if (code != CURLE_OK) {
+        call->resp.error_code = (int) code;
+        call->resp.error_message = curl_easy_strerror(code);
+        // connection may be broken, don't give it to the next request
+        t->session.discard();
+    } else if (t->record) {
+        fixtures::get().record(call->req, call->resp, std::move(t->recorded));
+    }
+
+    auto& host = m_hosts[t->host_key];
+    host.active--;
+    if (call->priority == request_priority::background) {
+        update_backoff(host, call->resp);
+    }
+
+    // release session before callback, so the next request to the same host could take it
+    t.reset();
+
+    if (call->on_done) {
+        call->on_done(call);
+    }
+}
+
+size_t miledger::net::curl_engine::write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* t = static_cast<transfer*>(userdata);
+    const size_t len = size * nmemb;
+    t->call->resp.bytes_in += len;
+    if (!t->output->write(ptr, len)) {
+        // returning less than passed aborts transfer with CURLE_WRITE_ERROR
+        return 0;
+    }
+    return len;
+}
+
+size_t miledger::net::curl_engine::read_callback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* t = static_cast<transfer*>(userdata);
+    if (!t->body_reader) {
+        return 0;
+    }
+    return t->body_reader(buffer, size * nitems);
+}
+
+size_t miledger::net::curl_engine::header_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* t = static_cast<transfer*>(userdata);
+    const size_t len = size * nmemb;
+    std::string line(ptr, len);
+
+    if (line.rfind("HTTP/", 0) == 0) {
+        // new status line: redirect or 100-continue, drop headers of previous response
+        t->call->resp.headers.clear();
+        // status is needed by sinks before the body, curl reports it only when transfer is done
+        auto sp = line.find(' ');
+        if (sp != std::string::npos) {
+            t->call->resp.status_code = std::strtol(line.c_str() + sp + 1, nullptr, 10);
+        }
+        return len;
+    }
+
+    auto sep = line.find(':');
+    if (sep == std::string::npos) {
+        return len;
+    }
+
+    std::string name = line.substr(0, sep);
+    std::string value = line.substr(sep + 1);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+
+    const auto not_space = [](unsigned char c) { return !std::isspace(c); };
+    value.erase(value.begin(), std::find_if(value.begin(), value.end(), not_space));
+    value.erase(std::find_if(value.rbegin(), value.rend(), not_space).base(), value.end());
+
+    t->call->resp.headers.emplace_back(std::move(name), std::move(value));
+    return len;
+}
@@ -0,0 +1,266 @@
+/*!
+ * miledger.
+ * endpoint_pool.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/endpoint_pool.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <limits>
+
+void miledger::net::endpoint_pool::set_options(const options& opts) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_opts = opts;
+}
+
+void miledger::net::endpoint_pool::set_override(const std::string& group, std::vector<std::string> urls) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_overrides[group] = std::move(urls);
+}
+
+void miledger::net::endpoint_pool::add_group(const std::string& group, const std::string& primary, const std::vector<std::string>& urls) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (const auto& g : m_groups) {
+        if (g.name == group) {
+            return;
+        }
+    }
+
+    endpoint_pool::group g;
+    g.name = group;
+    g.primary = make_endpoint(primary);
+
+    auto ov = m_overrides.find(group);
+    const std::vector<std::string>& list = ov != m_overrides.end() ? ov->second : urls;
+    for (const auto& url : list) {
+        g.endpoints.push_back(make_endpoint(url));
+    }
+    if (g.endpoints.empty()) {
+        g.endpoints.push_back(g.primary);
+    }
+    m_groups.push_back(std::move(g));
+}
+
+void miledger::net::endpoint_pool::route(miledger::net::request& req, const miledger::net::request* busy) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    const auto now = clock_t::now();
+
+    for (auto& g : m_groups) {
+        const endpoint* from = nullptr;
+        if (matches(g.primary, req)) {
+            from = &g.primary;
+        } else {
+            for (const auto& ep : g.endpoints) {
+                if (matches(ep, req)) {
+                    from = &ep;
+                    break;
+                }
+            }
+        }
+        if (!from) {
+            continue;
+        }
+
+        const endpoint* busy_ep = nullptr;
+        if (busy) {
+            for (const auto& ep : g.endpoints) {
+                if (matches(ep, *busy)) {
+                    busy_ep = &ep;
+                    break;
+                }
+            }
+        }
+
+        endpoint& to = g.endpoints[select(g, now, busy_ep)];
+        if (needs_probe(to, now)) {
+            to.probing = true;
+            to.probe_started = now;
+        }
+        if (to.url != from->url) {
+            rebase(req, *from, to);
+        }
+        return;
+    }
+}
+
+void miledger::net::endpoint_pool::report(const miledger::net::request& req, std::chrono::microseconds latency, bool ok) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    const auto now = clock_t::now();
+
+    for (auto& g : m_groups) {
+        for (auto& ep : g.endpoints) {
+            if (!matches(ep, req)) {
+                continue;
+            }
+
+            ep.requests++;
+            ep.probing = false;
+            if (ok) {
+                const double sample = (double) latency.count();
+                ep.latency_us = ep.measured ? m_opts.alpha * sample + (1.0 - m_opts.alpha) * ep.latency_us : sample;
+                ep.measured = true;
+                ep.last_sample = now;
+                ep.failures = 0;
+                ep.eject_for = std::chrono::seconds(0);
+                return;
+            }
+
+            ep.errors++;
+            ep.failures++;
+            if (ep.failures >= m_opts.eject_after) {
+                // first ejection or failed probe after it
+                ep.eject_for = ep.eject_for.count() == 0 ? m_opts.eject_base : std::min(ep.eject_for * 2, m_opts.eject_max);
+                ep.ejected_until = now + ep.eject_for;
+            }
+            return;
+        }
+    }
+}
+
+std::string miledger::net::endpoint_pool::primary_url(const miledger::net::request& req) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (const auto& g : m_groups) {
+        if (matches(g.primary, req)) {
+            return req.get_url_utf8();
+        }
+        for (const auto& ep : g.endpoints) {
+            if (matches(ep, req)) {
+                miledger::net::request copy = req;
+                rebase(copy, ep, g.primary);
+                return copy.get_url_utf8();
+            }
+        }
+    }
+    return req.get_url_utf8();
+}
+
+std::vector<miledger::net::endpoint_pool::endpoint_stats> miledger::net::endpoint_pool::snapshot() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<endpoint_stats> out;
+    for (const auto& g : m_groups) {
+        for (const auto& ep : g.endpoints) {
+            endpoint_stats s;
+            s.group = g.name;
+            s.url = ep.url;
+            s.requests = ep.requests;
+            s.errors = ep.errors;
+            s.latency_ms = ep.latency_us / 1000.0;
+            s.ejected = is_ejected(ep);
+            out.push_back(std::move(s));
+        }
+    }
+    return out;
+}
+
+std::string miledger::net::endpoint_pool::dump() const {
+    std::string out = fmt::format("{:<10} {:<50} {:>7} {:>6} {:>9} {:>8}\n",
+                                  "group", "url", "reqs", "errs", "avg ms", "state");
+    for (const auto& s : snapshot()) {
+        out += fmt::format("{:<10} {:<50} {:>7} {:>6} {:>9.1f} {:>8}\n",
+                           s.group, s.url, s.requests, s.errors, s.latency_ms, s.ejected ? "ejected" : "ok");
+    }
+    return out;
+}
+
+miledger::net::endpoint_pool::endpoint miledger::net::endpoint_pool::make_endpoint(const std::string& url) {
+    const miledger::net::request parsed(QString::fromStdString(url));
+    endpoint ep;
+    ep.url = url;
+    ep.proto = parsed.get_proto_name();
+    ep.host = parsed.get_host();
+    ep.port = parsed.get_port();
+    ep.path = parsed.get_path();
+    while (ep.path.endsWith('/')) {
+        ep.path.chop(1);
+    }
+    return ep;
+}
+
+bool miledger::net::endpoint_pool::matches(const endpoint& ep, const miledger::net::request& req) {
+    if (req.get_port() != ep.port || QString::compare(req.get_host(), ep.host, Qt::CaseInsensitive) != 0) {
+        return false;
+    }
+    const QString path = req.get_path();
+    // whole path segments only: /api/v2 is not a prefix of /api/v20
+    return path.startsWith(ep.path) && (path.length() == ep.path.length() || path[ep.path.length()] == '/');
+}
+
+void miledger::net::endpoint_pool::rebase(miledger::net::request& req, const endpoint& from, const endpoint& to) {
+    const QString tail = req.get_path().mid(from.path.length());
+    req.set_proto_name(to.proto);
+    req.set_host(to.host);
+    req.set_port(to.port);
+    req.set_path(to.path + tail);
+}
+
+bool miledger::net::endpoint_pool::is_ejected(const endpoint& ep) const {
+    return ep.failures >= m_opts.eject_after;
+}
+
+bool miledger::net::endpoint_pool::needs_probe(const endpoint& ep, clock_t::time_point now) const {
+    if (is_ejected(ep)) {
+        return now >= ep.ejected_until;
+    }
+    return !ep.measured || now - ep.last_sample > m_opts.stale_after;
+}
+
+bool miledger::net::endpoint_pool::is_probing(const endpoint& ep, clock_t::time_point now) const {
+    return ep.probing && now - ep.probe_started < m_opts.probe_timeout;
+}
+
+size_t miledger::net::endpoint_pool::select(const group& g, clock_t::time_point now, const endpoint* busy) const {
+    // endpoint which needs probe gets one request
+    for (size_t i = 0; i < g.endpoints.size(); i++) {
+        const auto& ep = g.endpoints[i];
+        if (&ep != busy && needs_probe(ep, now) && !is_probing(ep, now)) {
+            return i;
+        }
+    }
+
+    size_t best = g.endpoints.size();
+    double best_latency = std::numeric_limits<double>::max();
+    size_t busy_idx = g.endpoints.size();
+    size_t soonest = 0;
+    for (size_t i = 0; i < g.endpoints.size(); i++) {
+        const auto& ep = g.endpoints[i];
+        if (is_ejected(ep)) {
+            if (ep.ejected_until < g.endpoints[soonest].ejected_until || !is_ejected(g.endpoints[soonest])) {
+                soonest = i;
+            }
+            continue;
+        }
+        if (&ep == busy) {
+            busy_idx = i;
+            continue;
+        }
+        // probe is in flight, nothing to compare yet
+        if (!ep.measured) {
+            continue;
+        }
+        // a failure or two before ejection make endpoint less attractive
+        const double latency = ep.latency_us * (1 + ep.failures);
+        if (latency < best_latency) {
+            best_latency = latency;
+            best = i;
+        }
+    }
+
+    if (best < g.endpoints.size()) {
+        return best;
+    }
+    if (busy_idx < g.endpoints.size()) {
+        return busy_idx;
+    }
+    // nothing healthy: never fail closed, use endpoint which is about to be re-admitted
+    for (size_t i = 0; i < g.endpoints.size(); i++) {
+        if (!is_ejected(g.endpoints[i])) {
+            return i;
+        }
+    }
+    return soonest;
+}
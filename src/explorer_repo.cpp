@@ -10,35 +10,70 @@
 #include "include/net/explorer_repo.h"
 
 #include "include/miledger-config.h"
+#include "include/settings.h"
 
 using namespace miledger::repo;
 namespace net = miledger::net;
 
+namespace {
+namespace routes {
+const net::route get_balance("get_balance", "addresses/{address}", {"withSum"});
+const net::route get_address_transactions("get_transactions", "addresses/{address}/transactions", {"page", "limit", "send_type"});
+const net::route get_transactions("get_transactions", "transactions", {"page", "start_block", "end_block", "addresses[]"});
+const net::route get_transaction("get_transaction", "transactions/{hash}");
+const net::route get_block_transaction("get_transaction", "addresses/{address}/transactions", {"start_block", "end_block"});
+const net::route get_delegated("get_delegated", "addresses/{address}/delegations");
+const net::route get_rewards("get_rewards", "addresses/{address}/statistics/rewards", {"scale", "startTime", "endTime"});
+const net::route get_validators("get_validators", "validators");
+const net::route get_validator("get_validator", "validators/{pubkey}");
+const net::route get_validator_transactions("get_validator_transactions", "validators/{pubkey}/transactions", {"page", "start_block", "end_block"});
+const net::route get_status("get_status", "status");
+const net::route get_status_page("get_status_page", "status-page");
+const net::route pools_list("pools_list", "pools", {"page"});
+const net::route get_pool_route("get_pool_route", "pools/coins/{coin0}/{coin1}/route", {"amount", "type"});
+const net::route get_pool_estimate("get_pool_estimate", "pools/coins/{coin0}/{coin1}/estimate", {"amount", "type"});
+const net::route get_pool("get_pool", "pools/coins/{coin0}/{coin1}");
+const net::route get_pool_providers("get_pool_providers", "pools/coins/{coin0}/{coin1}/providers");
+const net::route get_pool_provider("get_pool_provider", "pools/coins/{coin0}/{coin1}/providers/{address}");
+const net::route get_address_pool_providers("get_pool_providers", "pools/providers/{address}");
+const net::route get_coins("get_coins", "coins");
+const net::route search_coins("search_coins", "coins", {"symbol"});
+const net::route get_coin_by_id("get_coin_by_id", "coins/id/{id}");
+} // namespace routes
+} // namespace
+
 explorer_repo::explorer_repo() {
+    // answers for what user is typing right now
+    net::request_policy interactive;
+    interactive.priority = net::request_priority::interactive;
+    set_policy("get_pool_estimate", interactive);
+    set_policy("get_pool_route", interactive);
+    set_policy("search_coins", interactive);
+
+    // large lists, loaded in background and must not delay anything else
+    net::request_policy background;
+    background.priority = net::request_priority::background;
+    set_policy("get_coins", background);
+    set_policy("get_validators", background);
 }
 
 explorer_repo::~explorer_repo() {
 }
 
-TASK_RES(balance_items)
+TASK_STORED_RES(balance_items)
 explorer_repo::get_balance(const minter::address_t& address, bool withSum) const {
-    auto req = create_request();
-    req.add_path("addresses");
-    req.add_path(QString::fromStdString(address.to_string()));
+    auto req = create_request(routes::get_balance, {QString::fromStdString(address.to_string())});
 
     if (withSum) {
         req.add_query(net::kv{"withSum", "true"});
     }
 
-    return MAKE_TASK(balance_items, req);
+    return MAKE_STORED_TASK(balance_items, req);
 }
 
 TASK_RES(tx_list_t)
 explorer_repo::get_transactions(const minter::address_t& address, uint32_t page, uint32_t limit, explorer_repo::tx_send_type send_type) const {
-    auto req = create_request();
-    req.add_path("addresses");
-    req.add_path(QString::fromStdString(address.to_string()));
-    req.add_path("transactions");
+    auto req = create_request(routes::get_address_transactions, {QString::fromStdString(address.to_string())});
 
     req.add_query(net::kvd{"page", page});
     req.add_query(net::kvd{"limit", limit});
@@ -54,8 +89,18 @@ explorer_repo::get_transactions(const minter::address_t& address, uint32_t page,
 
 TASK_RES(tx_list_t)
 explorer_repo::get_transactions(const get_transactions_opt& opts) const {
-    auto req = create_request();
-    req.add_path("transactions");
+    auto req = create_transactions_request(opts);
+    return MAKE_TASK(tx_list_t, req);
+}
+
+TASK_RES_ROOT(nlohmann::json)
+explorer_repo::get_transactions_json(const get_transactions_opt& opts) const {
+    auto req = create_transactions_request(opts);
+    return MAKE_TASK_ROOT(nlohmann::json, req);
+}
+
+net::request explorer_repo::create_transactions_request(const get_transactions_opt& opts) const {
+    auto req = create_request(routes::get_transactions);
     if (opts.page) {
         req.add_query(net::kvd("page", opts.page));
     }
@@ -70,25 +115,19 @@ explorer_repo::get_transactions(const get_transactions_opt& opts) const {
             req.add_query(net::kv("addresses[]", QString::fromStdString(addr.to_string())));
         }
     }
-
-    return MAKE_TASK(tx_list_t, req);
+    return req;
 }
 
 TASK_RES(transaction_item)
 explorer_repo::get_transaction(const minter::hash_t& hash) const {
-    auto req = create_request();
-    req.add_path("transactions");
-    req.add_path(QString::fromStdString(hash.to_string()));
+    auto req = create_request(routes::get_transaction, {QString::fromStdString(hash.to_string())});
 
     return MAKE_TASK(transaction_item, req);
 }
 
 TASK_RES(transaction_item)
 explorer_repo::get_transaction(const minter::address_t& address, dev::bigint block_number) const {
-    auto req = create_request();
-    req.add_path("addresses");
-    req.add_path(QString::fromStdString(address.to_string()));
-    req.add_path("transactions");
+    auto req = create_request(routes::get_block_transaction, {QString::fromStdString(address.to_string())});
 
     req.add_query(net::kvd("start_block", block_number));
     req.add_query(net::kvd("end_block", block_number));
@@ -110,10 +149,7 @@ explorer_repo::get_transaction(const minter::address_t& address, dev::bigint blo
 
 TASK_RES(delegations_result_t)
 explorer_repo::get_delegated(const std::string& address) const {
-    auto req = create_request();
-    req.add_path("addresses");
-    req.add_path(QString::fromStdString(address));
-    req.add_path("delegations");
+    auto req = create_request(routes::get_delegated, {QString::fromStdString(address)});
 
     return MAKE_TASK(delegations_result_t, req);
 }
@@ -123,10 +159,24 @@ explorer_repo::get_rewards(const minter::address_t& address,
                            explorer_repo::reward_period period,
                            const std::string& start_time,
                            const std::string& end_time) {
-    auto req = create_request();
-    req.add_path("addresses");
-    req.add_path(QString::fromStdString(address.to_string()));
-    req.add_path("statistics/rewards");
+    auto req = create_rewards_request(address, period, start_time, end_time);
+    return MAKE_TASK(reward_list_t, req);
+}
+
+TASK_RES_ROOT(nlohmann::json)
+explorer_repo::get_rewards_json(const minter::address_t& address,
+                                explorer_repo::reward_period period,
+                                const std::string& start_time,
+                                const std::string& end_time) {
+    auto req = create_rewards_request(address, period, start_time, end_time);
+    return MAKE_TASK_ROOT(nlohmann::json, req);
+}
+
+net::request explorer_repo::create_rewards_request(const minter::address_t& address,
+                                                   explorer_repo::reward_period period,
+                                                   const std::string& start_time,
+                                                   const std::string& end_time) {
+    auto req = create_request(routes::get_rewards, {QString::fromStdString(address.to_string())});
 
     if (period != none) {
         req.add_query({"scale", m_reward_scales[period]});
@@ -137,33 +187,26 @@ explorer_repo::get_rewards(const minter::address_t& address,
     if (!end_time.empty()) {
         req.add_query({"endTime", QString::fromStdString(end_time)});
     }
-
-    return MAKE_TASK(reward_list_t, req);
+    return req;
 }
 
 TASK_RES(validator_list_t)
 explorer_repo::get_validators() const {
-    auto req = create_request();
-    req.add_path("validators");
+    auto req = create_request(routes::get_validators);
 
     return MAKE_TASK(validator_list_t, req);
 }
 
 TASK_RES(validator_detailed_item)
 explorer_repo::get_validator(const minter::pubkey_t& pubkey) const {
-    auto req = create_request();
-    req.add_path("validators");
-    req.add_path(QString::fromStdString(pubkey.to_string()));
+    auto req = create_request(routes::get_validator, {QString::fromStdString(pubkey.to_string())});
 
     return MAKE_TASK(validator_detailed_item, req);
 }
 
 TASK_RES(tx_list_t)
 explorer_repo::get_validator_transactions(const minter::pubkey_t& pubkey, const minter::explorer::get_transactions_opt& opts) const {
-    auto req = create_request();
-    req.add_path("validators");
-    req.add_path(QString::fromStdString(pubkey.to_string()));
-    req.add_path("transactions");
+    auto req = create_request(routes::get_validator_transactions, {QString::fromStdString(pubkey.to_string())});
 
     if (opts.page) {
         req.add_query(net::kvd("page", opts.page));
@@ -180,24 +223,21 @@ explorer_repo::get_validator_transactions(const minter::pubkey_t& pubkey, const
 
 TASK_RES(net_status)
 explorer_repo::get_status() const {
-    auto req = create_request();
-    req.add_path("status");
+    auto req = create_request(routes::get_status);
 
     return MAKE_TASK(net_status, req);
 }
 
 TASK_RES(net_status_page)
 explorer_repo::get_status_page() const {
-    auto req = create_request();
-    req.add_path("status-page");
+    auto req = create_request(routes::get_status_page);
 
     return MAKE_TASK(net_status_page, req);
 }
 
 TASK_RES(std::vector<pool>)
 explorer_repo::pools_list(uint32_t page) const {
-    auto req = create_request();
-    req.add_path("pools");
+    auto req = create_request(routes::pools_list);
     if (page > 0) {
         req.add_query(net::kvd("page", page));
     }
@@ -205,6 +245,16 @@ explorer_repo::pools_list(uint32_t page) const {
     return MAKE_TASK(std::vector<minter::explorer::pool>, req);
 }
 
+TASK_RES_ROOT(nlohmann::json)
+explorer_repo::pools_list_json(uint32_t page) const {
+    auto req = create_request(routes::pools_list);
+    if (page > 0) {
+        req.add_query(net::kvd("page", page));
+    }
+
+    return MAKE_TASK_ROOT(nlohmann::json, req);
+}
+
 TASK_RES_ROOT(pool_route)
 explorer_repo::get_pool_route(
     const coin_item_base& coin0,
@@ -212,11 +262,9 @@ explorer_repo::get_pool_route(
     const dev::bigdec18& amount,
     pool_swap_type swap_type) const {
 
-    auto req = create_request();
-    req.add_path("pools/coins");
-    req.add_path(QString::fromStdString(minter::utils::to_string(coin0.id)));
-    req.add_path(QString::fromStdString(minter::utils::to_string(coin1.id)));
-    req.add_path("route");
+    auto req = create_request(routes::get_pool_route,
+                              {QString::fromStdString(minter::utils::to_string(coin0.id)),
+                               QString::fromStdString(minter::utils::to_string(coin1.id))});
 
     req.add_query(net::kv("amount", QString::fromStdString(minter::utils::normalize_value(amount).str())));
 
@@ -235,11 +283,9 @@ explorer_repo::get_pool_estimate(
     const dev::bigdec18& amount,
     pool_swap_type swap_type) const {
 
-    auto req = create_request();
-    req.add_path("pools/coins");
-    req.add_path(QString::fromStdString(minter::utils::to_string(coin0.id)));
-    req.add_path(QString::fromStdString(minter::utils::to_string(coin1.id)));
-    req.add_path("estimate");
+    auto req = create_request(routes::get_pool_estimate,
+                              {QString::fromStdString(minter::utils::to_string(coin0.id)),
+                               QString::fromStdString(minter::utils::to_string(coin1.id))});
 
     req.add_query(net::kv("amount", QString::fromStdString(minter::utils::normalize_value(amount).str())));
 
@@ -254,67 +300,51 @@ explorer_repo::get_pool_estimate(
 
 TASK_RES(pool)
 explorer_repo::get_pool(const std::string& coin0, const std::string& coin1) const {
-    auto req = create_request();
-    req.add_path("pools/coins");
-    req.add_path(QString::fromStdString(coin0));
-    req.add_path(QString::fromStdString(coin1));
+    auto req = create_request(routes::get_pool, {QString::fromStdString(coin0), QString::fromStdString(coin1)});
 
     return MAKE_TASK(pool, req);
 }
 
 TASK_RES(pool)
 explorer_repo::get_pool(const minter::explorer::coin_item_base& coin0, const minter::explorer::coin_item_base& coin1) const {
-    auto req = create_request();
-    req.add_path("pools/coins");
-    req.add_path(QString::fromStdString(coin0.symbol));
-    req.add_path(QString::fromStdString(coin1.symbol));
+    auto req = create_request(routes::get_pool, {QString::fromStdString(coin0.symbol), QString::fromStdString(coin1.symbol)});
 
     return MAKE_TASK(pool, req);
 }
 
 TASK_RES(pool_providers)
 explorer_repo::get_pool_providers(const std::string& coin0, const std::string& coin1) const {
-    auto req = create_request();
-    req.add_path("pools/coins");
-    req.add_path(QString::fromStdString(coin0));
-    req.add_path(QString::fromStdString(coin1));
-    req.add_path("providers");
+    auto req = create_request(routes::get_pool_providers, {QString::fromStdString(coin0), QString::fromStdString(coin1)});
 
     return MAKE_TASK(pool_providers, req);
 }
 TASK_RES(pool_provider)
 explorer_repo::get_pool_provider(const std::string& coin0, const std::string& coin1, const minter::address_t& address) const {
-    auto req = create_request();
-    req.add_path("pools/coins");
-    req.add_path(QString::fromStdString(coin0));
-    req.add_path(QString::fromStdString(coin1));
-    req.add_path("providers");
-    req.add_path(QString::fromStdString(address.to_string()));
+    auto req = create_request(routes::get_pool_provider,
+                              {QString::fromStdString(coin0),
+                               QString::fromStdString(coin1),
+                               QString::fromStdString(address.to_string())});
 
     return MAKE_TASK(pool_provider, req);
 }
 
 TASK_RES(pool_providers)
 explorer_repo::get_pool_providers(const minter::address_t& address) const {
-    auto req = create_request();
-    req.add_path("pools/providers");
-    req.add_path(QString::fromStdString(address.to_string()));
+    auto req = create_request(routes::get_address_pool_providers, {QString::fromStdString(address.to_string())});
 
     return MAKE_TASK(pool_providers, req);
 }
 
-TASK_RES(std::vector<coin_item>)
+TASK_STORED_RES(std::vector<coin_item>)
 explorer_repo::get_coins() const {
-    auto req = create_request();
-    req.add_path("coins");
+    auto req = create_request(routes::get_coins);
 
-    return MAKE_TASK(std::vector<coin_item>, req);
+    return MAKE_STORED_TASK(std::vector<coin_item>, req);
 }
 
 TASK_RES(std::vector<coin_item>)
 explorer_repo::search_coins(const QString& symbol) const {
-    auto req = create_request();
-    req.add_path("coins");
+    auto req = create_request(routes::search_coins);
 
     req.add_query(net::kv("symbol", symbol));
 
@@ -323,21 +353,25 @@ explorer_repo::search_coins(const QString& symbol) const {
 
 TASK_RES(coin_item)
 explorer_repo::get_coin_by_id(dev::bigint coin_id) const {
-    auto req = create_request();
-    req.add_path("coins/id");
-    req.add_path(QString::fromStdString(minter::utils::to_string(coin_id)));
+    auto req = create_request(routes::get_coin_by_id, {QString::fromStdString(minter::utils::to_string(coin_id))});
 
     return MAKE_TASK(coin_item, req);
 }
 
 TASK_RES(coin_item)
 explorer_repo::get_coin_by_id(const QString& coin_id) const {
-    auto req = create_request();
-    req.add_path("coins/id");
-    req.add_path(coin_id);
+    auto req = create_request(routes::get_coin_by_id, {coin_id});
 
     return MAKE_TASK(coin_item, req);
 }
 QUrl explorer_repo::get_base_url() const {
     return QUrl(QString(MINTER_EXPLORER_API));
 }
+
+QStringList explorer_repo::get_base_urls() const {
+    return Settings::get().getString(Settings::KEY_NET_EXPLORER_URLS, QString(MINTER_EXPLORER_API)).split(',', Qt::SkipEmptyParts);
+}
+
+QString explorer_repo::get_name() const {
+    return "explorer";
+}
@@ -0,0 +1,316 @@
+/*!
+ * miledger.
+ * fixtures.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/fixtures.h"
+
+#include "include/net/endpoint_pool.h"
+
+#include <QDebug>
+#include <QDir>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <restinio/all.hpp>
+#include <sstream>
+
+namespace io = restinio::asio_ns;
+
+namespace {
+
+using replay_traits_t = restinio::traits_t<
+    restinio::asio_timer_manager_t,
+    restinio::null_logger_t>;
+using replay_server_t = restinio::http_server_t<replay_traits_t>;
+using replay_settings_t = restinio::server_settings_t<replay_traits_t>;
+using chunked_response_t = restinio::response_builder_t<restinio::chunked_output_t>;
+
+/// \brief Headers describing original transfer, stand-in sends it's own
+bool is_transfer_header(const std::string& name) {
+    return name == "content-length" ||
+           name == "transfer-encoding" ||
+           name == "connection" ||
+           name == "keep-alive" ||
+           name == "content-encoding";
+}
+
+} // namespace
+
+// FIXTURE STORE
+miledger::net::fixture_store::fixture_store(std::string dir)
+    : m_dir(std::move(dir)) {
+    QDir().mkpath(QString::fromStdString(m_dir));
+}
+
+std::string miledger::net::fixture_store::key_for(const std::string& method, const std::string& url, const std::string& body) {
+    // FNV-1a: stable between runs and platforms, unlike std::hash
+    uint64_t hash = 14695981039346656037ULL;
+    const auto feed = [&hash](const std::string& s) {
+        for (unsigned char c : s) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= '\n';
+        hash *= 1099511628211ULL;
+    };
+    feed(method);
+    feed(url);
+    feed(body);
+    return fmt::format("{:016x}", hash);
+}
+
+bool miledger::net::fixture_store::save(const fixture& fx) const {
+    const std::string path = m_dir + "/" + key_for(fx.method, fx.url, fx.request_body);
+
+    nlohmann::json meta;
+    meta["method"] = fx.method;
+    meta["url"] = fx.url;
+    meta["request_body"] = fx.request_body;
+    meta["status_code"] = fx.status_code;
+    meta["headers"] = fx.headers;
+
+    std::ofstream body_out(path + ".body", std::ios::binary | std::ios::trunc);
+    body_out.write(fx.body.data(), (std::streamsize) fx.body.size());
+    if (!body_out.good()) {
+        return false;
+    }
+
+    // metadata is written last: it's presence means fixture is complete
+    std::ofstream meta_out(path + ".json", std::ios::trunc);
+    meta_out << meta.dump(2);
+    return meta_out.good();
+}
+
+bool miledger::net::fixture_store::load(const std::string& method, const std::string& url, const std::string& body, fixture& out) const {
+    const std::string path = m_dir + "/" + key_for(method, url, body);
+
+    std::ifstream meta_in(path + ".json");
+    std::ifstream body_in(path + ".body", std::ios::binary);
+    if (!meta_in.is_open() || !body_in.is_open()) {
+        return false;
+    }
+
+    try {
+        nlohmann::json meta = nlohmann::json::parse(meta_in);
+        out.method = meta.at("method").get<std::string>();
+        out.url = meta.at("url").get<std::string>();
+        out.request_body = meta.at("request_body").get<std::string>();
+        out.status_code = meta.at("status_code").get<long>();
+        out.headers = meta.at("headers").get<std::vector<std::pair<std::string, std::string>>>();
+    } catch (const std::exception& e) {
+        qDebug() << "Broken fixture" << QString::fromStdString(path) << ":" << e.what();
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << body_in.rdbuf();
+    out.body = ss.str();
+    return true;
+}
+
+// STAND-IN SERVER
+class miledger::net::fixtures::server {
+public:
+    server(const fixture_store& store, const options& opts)
+        : m_store(store)
+        , m_opts(opts)
+        , m_work(io::make_work_guard(m_ctx)) {
+    }
+
+    ~server() {
+        if (m_server) {
+            try {
+                m_server->close_sync();
+            } catch (const std::exception& e) {
+                qDebug() << "Unable to stop fixtures server:" << e.what();
+            }
+        }
+        m_work.reset();
+        m_ctx.stop();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    bool start() {
+        m_thread = std::thread([this]() {
+            io::error_code ec;
+            m_ctx.run(ec);
+        });
+
+        m_server = std::make_unique<replay_server_t>(
+            restinio::external_io_context(m_ctx),
+            replay_settings_t{}
+                .port(m_opts.port)
+                .address("127.0.0.1")
+                .request_handler([this](restinio::request_handle_t req) {
+                    return handle(std::move(req));
+                }));
+
+        try {
+            m_server->open_sync();
+        } catch (const std::exception& e) {
+            qDebug() << "Unable to start fixtures server:" << e.what();
+            m_server.reset();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct stream_state {
+        stream_state(chunked_response_t&& resp, std::shared_ptr<fixture> fx, io::io_context& ctx)
+            : resp(std::move(resp))
+            , fx(std::move(fx))
+            , timer(ctx) {
+        }
+
+        chunked_response_t resp;
+        std::shared_ptr<fixture> fx;
+        size_t offset = 0;
+        io::steady_timer timer;
+    };
+
+    restinio::request_handling_status_t handle(restinio::request_handle_t req) {
+        const std::string url = req->header().get_field_or(fixtures::url_header, "");
+
+        auto fx = std::make_shared<fixture>();
+        if (!m_store.load(req->header().method().c_str(), url, req->body(), *fx)) {
+            nlohmann::json err;
+            err["error"]["code"] = "fixture_not_found";
+            err["error"]["message"] = fmt::format("No recorded response for {0} {1}", req->header().method().c_str(), url);
+            return req->create_response(restinio::status_not_found())
+                .append_header(restinio::http_field::content_type, "application/json")
+                .set_body(err.dump())
+                .done();
+        }
+
+        if (m_opts.latency.count() <= 0) {
+            respond(req, fx);
+            return restinio::request_accepted();
+        }
+
+        auto timer = std::make_shared<io::steady_timer>(m_ctx, m_opts.latency);
+        timer->async_wait([this, req, fx, timer](const io::error_code& ec) {
+            if (!ec) {
+                respond(req, fx);
+            }
+        });
+        return restinio::request_accepted();
+    }
+
+    void respond(const restinio::request_handle_t& req, const std::shared_ptr<fixture>& fx) {
+        const auto status = restinio::status_line_from_code(restinio::http_status_code_t{(std::uint16_t) fx->status_code});
+
+        if (m_opts.bandwidth == 0) {
+            auto resp = req->create_response(status);
+            for (const auto& h : fx->headers) {
+                if (!is_transfer_header(h.first)) {
+                    resp.append_header(h.first, h.second);
+                }
+            }
+            resp.set_body(fx->body).done();
+            return;
+        }
+
+        auto resp = req->create_response<restinio::chunked_output_t>(status);
+        for (const auto& h : fx->headers) {
+            if (!is_transfer_header(h.first)) {
+                resp.append_header(h.first, h.second);
+            }
+        }
+        auto state = std::make_shared<stream_state>(std::move(resp), fx, m_ctx);
+        send_next(state);
+    }
+
+    void send_next(const std::shared_ptr<stream_state>& state) {
+        // bandwidth is spent in 50ms slices
+        constexpr auto tick = std::chrono::milliseconds(50);
+        const size_t slice = std::max<size_t>(1, (size_t) (m_opts.bandwidth * tick.count() / 1000));
+
+        const std::string& body = state->fx->body;
+        const size_t n = std::min(slice, body.size() - state->offset);
+        if (n > 0) {
+            state->resp.append_chunk(body.substr(state->offset, n));
+            state->resp.flush();
+            state->offset += n;
+        }
+
+        if (state->offset >= body.size()) {
+            state->resp.done();
+            return;
+        }
+
+        state->timer.expires_after(tick);
+        state->timer.async_wait([this, state](const io::error_code& ec) {
+            if (!ec) {
+                send_next(state);
+            }
+        });
+    }
+
+    const fixture_store& m_store;
+    options m_opts;
+    io::io_context m_ctx;
+    io::executor_work_guard<io::io_context::executor_type> m_work;
+    std::unique_ptr<replay_server_t> m_server;
+    std::thread m_thread;
+};
+
+// FIXTURES
+miledger::net::fixtures::~fixtures() = default;
+
+bool miledger::net::fixtures::setup(const options& opts) {
+    m_opts = opts;
+    m_server.reset();
+    m_store.reset();
+    if (m_opts.net_mode == mode::live) {
+        return true;
+    }
+
+    m_store = std::make_unique<fixture_store>(m_opts.dir);
+    if (m_opts.net_mode == mode::replay) {
+        m_server = std::make_unique<server>(*m_store, m_opts);
+        if (!m_server->start()) {
+            m_server.reset();
+            m_opts.net_mode = mode::live;
+            return false;
+        }
+        qDebug().noquote() << QString("Replaying network from %1 on 127.0.0.1:%2").arg(QString::fromStdString(m_opts.dir)).arg(m_opts.port);
+    } else {
+        qDebug().noquote() << QString("Recording network to %1").arg(QString::fromStdString(m_opts.dir));
+    }
+    return true;
+}
+
+void miledger::net::fixtures::record(const miledger::net::request& req, const miledger::net::response& resp, std::string&& body) {
+    // 304 has no body to replay, 0 - no answer at all
+    if (!m_store || resp.status_code == 0 || resp.status_code == 304) {
+        return;
+    }
+
+    fixture fx;
+    fx.method = req.get_method_str().toStdString();
+    fx.url = fixture_url(req);
+    fx.request_body = req.get_body_bytes();
+    fx.status_code = resp.status_code;
+    fx.headers = resp.headers;
+    fx.body = std::move(body);
+
+    if (!m_store->save(fx)) {
+        qDebug() << "Unable to save fixture of" << QString::fromStdString(fx.url);
+    }
+}
+
+std::string miledger::net::fixtures::fixture_url(const miledger::net::request& req) {
+    return endpoint_pool::get().primary_url(req);
+}
+
+std::string miledger::net::fixtures::replay_url(const miledger::net::request& req) const {
+    return fmt::format("http://127.0.0.1:{0}{1}", m_opts.port, req.get_path_with_query().toStdString());
+}
@@ -10,6 +10,7 @@
 #include "include/net/gate_repo.h"
 
 #include "include/miledger-config.h"
+#include "include/settings.h"
 #include "include/utils.h"
 
 #include <minter/api/gate/gate_results.h>
@@ -174,39 +175,78 @@ QString miledger::repo::tx_init_data::calc_fee_swap_text(minter::tx_type_val tx_
     }
 }
 
+namespace {
+namespace routes {
+using miledger::net::route;
+const route get_min_gas("get_min_gas", "min_gas_price");
+const route get_tx_count("get_tx_count", "nonce/{address}");
+const route get_price_commissions("get_price_commissions", "price_commissions");
+const route get_tx_commission_value("get_tx_commission_value", "estimate_tx_commission/{tx}");
+const route get_exchange_buy_currency("get_exchange_buy_currency", "estimate_coin_buy", {"coin_id_to_sell", "value_to_buy", "coin_id_to_buy"});
+const route get_exchange_sell_currency("get_exchange_sell_currency", "estimate_coin_sell", {"coin_id_to_sell", "value_to_sell", "coin_id_to_buy"});
+const route send_tx("send_tx", "send_transaction");
+} // namespace routes
+} // namespace
+
 miledger::repo::gate_repo::gate_repo() {
+    // sign-and-send path: every call must answer in bounded time, stalled connection is replaced by hedged one
+    miledger::net::request_policy policy;
+    policy.connect_timeout = std::chrono::milliseconds(3000);
+    policy.attempt_timeout = std::chrono::milliseconds(8000);
+    policy.budget = std::chrono::milliseconds(15000);
+    policy.max_retries = 2;
+    policy.hedge = true;
+    policy.priority = miledger::net::request_priority::interactive;
+    set_policy("", policy);
+
+    // not idempotent: never retried or hedged, give node enough time to accept transaction
+    miledger::net::request_policy send_policy;
+    send_policy.connect_timeout = std::chrono::milliseconds(3000);
+    send_policy.attempt_timeout = std::chrono::milliseconds(20000);
+    send_policy.budget = std::chrono::milliseconds(20000);
+    send_policy.max_retries = 0;
+    send_policy.priority = miledger::net::request_priority::interactive;
+    set_policy("send_tx", send_policy);
 }
 
 TASK_RES_ROOT(gas_value)
 miledger::repo::gate_repo::get_min_gas() {
-    auto req = create_request();
-    req.add_path("min_gas_price");
+    auto req = create_request(routes::get_min_gas);
 
     return MAKE_TASK_ROOT(gas_value, req);
 }
 
 TASK_RES_ROOT(tx_count_value)
 miledger::repo::gate_repo::get_tx_count(const minter::address_t& address) {
-    auto req = create_request();
-    req.add_path("nonce");
-    req.add_path(QString::fromStdString(address.to_string()));
+    auto req = create_request(routes::get_tx_count, {QString::fromStdString(address.to_string())});
 
     return MAKE_TASK_ROOT(tx_count_value, req);
 }
 
 TASK_RES_ROOT(minter::gate::price_commissions)
 miledger::repo::gate_repo::get_price_commissions() {
-    auto req = create_request();
-    req.add_path("price_commissions");
+    auto req = create_request(routes::get_price_commissions);
 
     return MAKE_TASK_ROOT(price_commissions, req);
 }
 
+TASK_STORED_RES_ROOT(gas_value)
+miledger::repo::gate_repo::get_stored_min_gas() {
+    auto req = create_request(routes::get_min_gas);
+
+    return MAKE_STORED_TASK_ROOT(gas_value, req);
+}
+
+TASK_STORED_RES_ROOT(minter::gate::price_commissions)
+miledger::repo::gate_repo::get_stored_price_commissions() {
+    auto req = create_request(routes::get_price_commissions);
+
+    return MAKE_STORED_TASK_ROOT(price_commissions, req);
+}
+
 TASK_RES_ROOT(commission_value)
 miledger::repo::gate_repo::get_tx_commission_value(const dev::bytes_data& tx_sign) {
-    auto req = create_request();
-    req.add_path("estimate_tx_commission");
-    req.add_path(QString::fromStdString(tx_sign.to_hex()));
+    auto req = create_request(routes::get_tx_commission_value, {QString::fromStdString(tx_sign.to_hex())});
 
     return MAKE_TASK_ROOT(commission_value, req);
 }
@@ -233,8 +273,7 @@ TASK_RES_ROOT(exchange_buy_value)
 miledger::repo::gate_repo::get_exchange_buy_currency(const std::string& coin_to_sell,
                                                      const dev::bigdec18& value_to_buy,
                                                      const std::string& coin_to_buy) {
-    auto req = create_request();
-    req.add_path("estimate_coin_buy");
+    auto req = create_request(routes::get_exchange_buy_currency);
     req.add_query({"coin_id_to_sell", QString::fromStdString(coin_to_sell)});
     req.add_query({"value_to_buy", QString::fromStdString(
                                        minter::utils::to_string(minter::utils::normalize_value(value_to_buy)))});
@@ -247,8 +286,7 @@ TASK_RES_ROOT(exchange_sell_value)
 miledger::repo::gate_repo::get_exchange_sell_currency(const std::string& coin_to_sell,
                                                       const dev::bigdec18& value_to_sell,
                                                       const std::string& coin_to_buy) {
-    auto req = create_request();
-    req.add_path("estimate_coin_sell");
+    auto req = create_request(routes::get_exchange_sell_currency);
     req.add_query({"coin_id_to_sell", QString::fromStdString(coin_to_sell)});
     req.add_query({"value_to_sell", QString::fromStdString(
                                         minter::utils::to_string(minter::utils::normalize_value(value_to_sell)))});
@@ -259,16 +297,13 @@ miledger::repo::gate_repo::get_exchange_sell_currency(const std::string& coin_to
 
 TASK_RES_ROOT(tx_send_result)
 miledger::repo::gate_repo::send_tx(const dev::bytes_data& tx_sign) {
-    auto req = create_request();
+    auto req = create_request(routes::send_tx);
     req.set_header({"content-type", "application/json; charset=UTF-8"});
     req.set_method(miledger::net::request::method::post);
-    req.add_path("send_transaction");
     {
         nlohmann::json j;
         j["tx"] = tx_sign.to_hex();
-        std::stringstream ss;
-        ss << j;
-        req.set_body(QString::fromStdString(ss.str()));
+        req.set_body_bytes(j.dump());
     }
 
     return MAKE_TASK_ROOT(tx_send_result, req);
@@ -301,3 +336,11 @@ miledger::repo::gate_repo::get_tx_init_data(const minter::address_t& address) {
 QUrl miledger::repo::gate_repo::gate_repo::get_base_url() const {
     return QUrl(QString(MINTER_GATE_API));
 }
+
+QStringList miledger::repo::gate_repo::get_base_urls() const {
+    return Settings::get().getString(Settings::KEY_NET_GATE_URLS, QString(MINTER_GATE_API)).split(',', Qt::SkipEmptyParts);
+}
+
+QString miledger::repo::gate_repo::get_name() const {
+    return "gate";
+}
@@ -0,0 +1,332 @@
+/*!
+ * miledger.
+ * http_client.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/http_client.h"
+
+#include "include/net/transport.h"
+#include "include/net/endpoint_pool.h"
+#include "include/net/metrics.h"
+
+#include <algorithm>
+#include <curl/curl.h>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+/// \brief Passes body to the inner sink until attempt lost the race to the hedged one.
+/// Body of server error is dropped: it's usually HTML page of gateway, parsing sink would fail on it
+/// with write error and hide HTTP status from retry logic and caller.
+class abortable_sink : public miledger::net::response_sink {
+public:
+    explicit abortable_sink(std::shared_ptr<miledger::net::response_sink> inner)
+        : m_inner(std::move(inner)) {
+    }
+
+    bool write(const char* data, size_t len) override {
+        if (aborted) {
+            return false;
+        }
+        // transport sets status before the first body chunk
+        if (resp && resp->status_code >= 500) {
+            return true;
+        }
+        return m_inner->write(data, len);
+    }
+
+    bool aborted = false;
+    const miledger::net::response* resp = nullptr;
+
+private:
+    std::shared_ptr<miledger::net::response_sink> m_inner;
+};
+
+} // namespace
+
+struct miledger::net::http_client::attempt {
+    std::shared_ptr<response_sink> sink;
+    std::shared_ptr<abortable_sink> guard;
+    std::shared_ptr<cache_sink> teed;
+    std::shared_ptr<http_call> call;
+};
+
+struct miledger::net::http_client::exchange {
+    miledger::net::request req;
+    std::string endpoint;
+    request_policy policy;
+    sink_factory_t make_sink;
+    done_callback_t on_done;
+
+    bool use_cache = false;
+    std::string url;
+    response_cache::entry_ptr cached;
+
+    clock_type::time_point begin;
+    clock_type::time_point deadline;
+    uint64_t bytes_out = 0;
+    // all attempts, including aborted
+    uint64_t bytes_in = 0;
+    uint64_t bytes_decoded = 0;
+    std::chrono::microseconds decode_time{0};
+    std::mutex lock;
+    unsigned started = 0;
+    unsigned retries = 0;
+    unsigned running = 0;
+    bool finished = false;
+    // running attempts
+    std::vector<std::shared_ptr<attempt>> attempts;
+};
+
+miledger::net::http_client::cancel_t miledger::net::http_client::execute(miledger::net::request req, sink_factory_t make_sink, done_callback_t on_done) {
+    auto ex = std::make_shared<exchange>();
+    ex->endpoint = req.get_endpoint().toStdString();
+    ex->policy = policy_registry::get().find(ex->endpoint);
+    ex->make_sink = std::move(make_sink);
+    ex->on_done = std::move(on_done);
+    ex->begin = clock_type::now();
+    ex->deadline = ex->begin + ex->policy.budget;
+    ex->bytes_out = (uint64_t) req.get_body_size();
+    ex->use_cache = req.get_method() == miledger::net::request::method::get;
+
+    if (ex->use_cache) {
+        auto& cache = response_cache::get();
+        ex->url = req.get_url_utf8();
+        ex->cached = cache.find(ex->url);
+        if (ex->cached && ex->cached->is_fresh(response_cache::clock_t::now())) {
+            cache.hit(ex->cached);
+            metrics_registry::call_sample sample;
+            sample.cache_hit = true;
+            metrics_registry::get().record(ex->endpoint, sample);
+            http_result res;
+            res.sink = ex->make_sink();
+            res.resp.status_code = 200;
+            res.replay = ex->cached;
+            ex->on_done(std::move(res));
+            return []() {};
+        }
+        if (ex->cached) {
+            response_cache::add_validators(req, *ex->cached);
+        }
+    }
+    ex->req = std::move(req);
+
+    std::chrono::milliseconds hedge_after(0);
+    if (ex->policy.hedge && is_idempotent(ex->req)) {
+        hedge_after = ex->policy.hedge_after.count() > 0 ? ex->policy.hedge_after : get_p95(ex->endpoint);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(ex->lock);
+        start_attempt(ex);
+
+        if (hedge_after.count() > 0 && clock_type::now() + hedge_after < ex->deadline) {
+            transport::get().schedule(hedge_after, [this, ex]() {
+                std::lock_guard<std::mutex> lock(ex->lock);
+                // only if the first attempt is still waiting for answer
+                if (!ex->finished && ex->started == 1 && ex->running == 1) {
+                    start_attempt(ex);
+                }
+            });
+        }
+    }
+
+    // exchange lives while any of it's attempts or timers do, canceller must not prolong it
+    std::weak_ptr<exchange> weak_ex = ex;
+    return [this, weak_ex]() {
+        if (auto locked = weak_ex.lock()) {
+            cancel(locked);
+        }
+    };
+}
+
+void miledger::net::http_client::cancel(const std::shared_ptr<exchange>& ex) {
+    std::unique_lock<std::mutex> lock(ex->lock);
+    if (ex->finished) {
+        return;
+    }
+    ex->finished = true;
+    for (auto& at : ex->attempts) {
+        at->guard->aborted = true;
+        transport::get().cancel(at->call);
+    }
+
+    metrics_registry::call_sample sample;
+    sample.latency = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - ex->begin);
+    sample.bytes_in = ex->bytes_in;
+    sample.bytes_out = ex->bytes_out * ex->started;
+    sample.cancelled = true;
+    metrics_registry::get().record(ex->endpoint, sample);
+
+    // release subscriber captured by callback
+    auto on_done = std::move(ex->on_done);
+    lock.unlock();
+}
+
+std::chrono::milliseconds miledger::net::http_client::get_p95(const std::string& endpoint) const {
+    // hedging on a few samples would fire too early or too late.
+    // Single attempt time: whole call time includes retries and backoff, hedge would wait for them
+    return metrics_registry::get().get_attempt_quantile(endpoint, 0.95, 20);
+}
+
+void miledger::net::http_client::start_attempt(const std::shared_ptr<exchange>& ex) {
+    auto at = std::make_shared<attempt>();
+    at->sink = ex->make_sink();
+    at->guard = std::make_shared<abortable_sink>(at->sink);
+    at->call = std::make_shared<http_call>(ex->req, at->guard);
+    at->guard->resp = &at->call->resp;
+    if (ex->use_cache) {
+        at->teed = std::make_shared<cache_sink>(at->guard, &at->call->resp, response_cache::get().get_budget());
+        at->call->sink = at->teed;
+    }
+    at->call->priority = ex->policy.priority;
+    // hedged attempt goes to another mirror than the running one, retry - to the best one after failure was reported
+    endpoint_pool::get().route(at->call->req, ex->attempts.empty() ? nullptr : &ex->attempts.back()->call->req);
+    // attempt never outlives call budget: transport clamps timeouts to it when attempt leaves the queue
+    at->call->connect_timeout = ex->policy.connect_timeout;
+    at->call->total_timeout = ex->policy.attempt_timeout;
+    at->call->deadline = ex->deadline;
+
+    std::weak_ptr<attempt> weak_at = at;
+    at->call->on_done = [this, ex, weak_at](const std::shared_ptr<http_call>&) {
+        if (auto locked = weak_at.lock()) {
+            on_attempt_done(ex, locked);
+        }
+    };
+
+    ex->started++;
+    ex->running++;
+    ex->attempts.push_back(at);
+    transport::get().submit(at->call);
+}
+
+void miledger::net::http_client::on_attempt_done(const std::shared_ptr<exchange>& ex, const std::shared_ptr<attempt>& at) {
+    std::unique_lock<std::mutex> lock(ex->lock);
+    ex->running--;
+    ex->bytes_in += at->call->resp.bytes_in;
+    ex->bytes_decoded += at->call->resp.bytes_decoded;
+    ex->decode_time += at->call->resp.decode_time;
+    ex->attempts.erase(std::remove(ex->attempts.begin(), ex->attempts.end(), at), ex->attempts.end());
+    // attempt which lost the race or was cancelled tells nothing about it's endpoint, nor one which never left the queue
+    if (!at->guard->aborted && !at->call->resp.cancelled && at->call->started_at != clock_type::time_point{}) {
+        const auto& resp = at->call->resp;
+        const bool ok = !resp.is_network_error() && resp.status_code < 500 && resp.status_code != 429;
+        const auto took = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - at->call->started_at);
+        endpoint_pool::get().report(at->call->req, took, ok);
+        // fast failures like refused connection would pull hedge delay down
+        if (resp.status_code > 0 || resp.error_code == (int) CURLE_OPERATION_TIMEDOUT) {
+            metrics_registry::get().record_attempt(ex->endpoint, took);
+        }
+    }
+    if (ex->finished) {
+        // lost the race
+        return;
+    }
+
+    if (!is_retriable(at->call->resp)) {
+        complete(lock, ex, at);
+        return;
+    }
+    if (ex->running > 0) {
+        // hedged attempt is still running, it may succeed
+        return;
+    }
+
+    if (is_idempotent(ex->req) && ex->retries < ex->policy.max_retries) {
+        const auto delay = backoff(ex->policy, ex->retries);
+        if (clock_type::now() + delay < ex->deadline) {
+            ex->retries++;
+            std::shared_ptr<attempt> failed = at;
+            transport::get().schedule(delay, [this, ex, failed]() {
+                std::unique_lock<std::mutex> lock(ex->lock);
+                if (ex->finished) {
+                    return;
+                }
+                if (clock_type::now() >= ex->deadline) {
+                    complete(lock, ex, failed);
+                    return;
+                }
+                start_attempt(ex);
+            });
+            return;
+        }
+    }
+
+    complete(lock, ex, at);
+}
+
+void miledger::net::http_client::complete(std::unique_lock<std::mutex>& lock, const std::shared_ptr<exchange>& ex, const std::shared_ptr<attempt>& at) {
+    ex->finished = true;
+    // losing hedge is stopped now, not on it's next chunk: it still holds a connection slot
+    for (auto& other : ex->attempts) {
+        other->guard->aborted = true;
+        transport::get().cancel(other->call);
+    }
+
+    const auto& resp = at->call->resp;
+    http_result res;
+    res.sink = at->sink;
+    res.resp = resp;
+    res.attempts = ex->started;
+
+    if (ex->use_cache) {
+        auto& cache = response_cache::get();
+        if (resp.status_code == 304 && ex->cached) {
+            res.replay = cache.revalidate(ex->url, ex->cached, resp);
+        } else {
+            cache.miss();
+            if (!resp.is_network_error() && at->teed->is_complete()) {
+                cache.store(ex->url, resp, std::move(at->teed->data()));
+            }
+        }
+    }
+
+    metrics_registry::call_sample sample;
+    sample.latency = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - ex->begin);
+    sample.bytes_in = ex->bytes_in;
+    sample.bytes_out = ex->bytes_out * ex->started;
+    sample.bytes_decoded = ex->bytes_decoded;
+    sample.decode_time = ex->decode_time;
+    sample.error = resp.is_network_error() || resp.status_code >= 400;
+    metrics_registry::get().record(ex->endpoint, sample);
+
+    auto on_done = std::move(ex->on_done);
+    lock.unlock();
+    on_done(std::move(res));
+}
+
+std::chrono::milliseconds miledger::net::http_client::backoff(const request_policy& policy, unsigned retry) {
+    long long cap = policy.backoff_base.count() << std::min(retry, 16u);
+    cap = std::min(cap, (long long) policy.backoff_max.count());
+
+    // full jitter: spread retries of many clients over the whole window
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::uniform_int_distribution<long long> dist(0, std::max(0LL, cap));
+    return std::chrono::milliseconds(dist(m_rnd));
+}
+
+bool miledger::net::http_client::is_idempotent(const miledger::net::request& req) {
+    if (req.has_body_stream()) {
+        // streamed body is consumed by the first attempt
+        return false;
+    }
+    return req.get_method() == miledger::net::request::method::get || req.get_method() == miledger::net::request::method::head;
+}
+
+bool miledger::net::http_client::is_retriable(const miledger::net::response& resp) {
+    // server error first: it may come together with transport error
+    if (resp.status_code >= 500) {
+        return true;
+    }
+    if (resp.is_network_error()) {
+        // body consumer refused successful answer: it's broken, repeating won't help
+        return resp.error_code != (int) CURLE_WRITE_ERROR;
+    }
+    return false;
+}
@@ -9,7 +9,7 @@
 
 #include "include/net/io_container.h"
 
-#include <QTextStream>
+#include <algorithm>
 
 // BASE IO
 miledger::net::io_container::io_container()
@@ -17,82 +17,69 @@ miledger::net::io_container::io_container()
 }
 
 void miledger::net::io_container::set_body(const QString& data) {
-    m_body = data;
-    set_header({"Content-Length", miledger::net::to_string(m_body.length())});
+    set_body_bytes(data.toStdString());
 }
 void miledger::net::io_container::set_body(QString&& data) {
+    set_body_bytes(data.toStdString());
+}
+void miledger::net::io_container::set_body_bytes(std::string&& data) {
+    set_body_bytes(std::make_shared<const std::string>(std::move(data)));
+}
+void miledger::net::io_container::set_body_bytes(miledger::net::body_buffer_t data) {
     m_body = std::move(data);
-    set_header({"Content-Length", miledger::net::to_string(m_body.length())});
+    m_body_stream = nullptr;
+    m_body_stream_size = -1;
+    // length in bytes, not in UTF-16 chars
+    set_header({"Content-Length", miledger::net::to_string(get_body_size())});
+}
+void miledger::net::io_container::set_body_stream(miledger::net::body_reader_t reader, int64_t size) {
+    m_body.reset();
+    m_body_stream = std::move(reader);
+    m_body_stream_size = size;
+    if (size >= 0) {
+        set_header({"Content-Length", miledger::net::to_string((size_t) size)});
+    } else {
+        remove_header("Content-Length");
+    }
 }
 void miledger::net::io_container::set_header(miledger::net::kv&& key_value) {
-    bool found = false;
-    for (auto& kv : m_headers) {
-        if (QString::compare(kv.first, key_value.first, Qt::CaseInsensitive)) {
-            kv.second = key_value.second;
-            found = true;
-        }
-    }
-
-    if (!found) {
-        return add_header(std::move(key_value));
-    }
+    add_header(key_value.first, key_value.second);
 }
 bool miledger::net::io_container::has_header(const QString& name) const {
-    for (auto& h : m_headers) {
-        if (QString::compare(h.first, name, Qt::CaseInsensitive)) {
-            return true;
-        }
-    }
-
-    return false;
+    return m_headers.find(name.toStdString()) != nullptr;
 }
 
 optns::optional<miledger::net::kv> miledger::net::io_container::find_header_pair(const QString& name) const {
     optns::optional<miledger::net::kv> out;
-    for (auto& h : m_headers) {
-        if (QString::compare(h.first, name, Qt::CaseInsensitive)) {
-            out = h;
-            break;
-        }
+    if (const auto* h = m_headers.find(name.toStdString())) {
+        out = miledger::net::kv(QString::fromStdString(h->key), QString::fromStdString(h->value));
     }
 
     return out;
 }
 QString miledger::net::io_container::get_header_value(const QString& headerName) const {
-    for (auto& h : m_headers) {
-        if (QString::compare(h.first, headerName, Qt::CaseInsensitive)) {
-            return h.second;
-        }
+    if (const auto* h = m_headers.find(headerName.toStdString())) {
+        return QString::fromStdString(h->value);
     }
 
     return {};
 }
 bool miledger::net::io_container::cmp_header_value(const QString& header_name, const QString& comparable) const {
-    if (!has_header(header_name))
-        return false;
-    return get_header_value(header_name) == comparable;
+    const auto* h = m_headers.find(header_name.toStdString());
+    return h && h->value == comparable.toStdString();
 }
 void miledger::net::io_container::add_header(const QString& name, const QString& value) {
-
-    for (auto& h : m_headers) {
-        if (QString::compare(h.first, name, Qt::CaseInsensitive)) {
-            h.second = value;
-            return;
-        }
+    std::string key = name.toStdString();
+    std::string val = value.toStdString();
+    if (m_headers.replace(key, val) == 0) {
+        m_headers.add(std::move(key), std::move(val));
     }
-    m_headers.emplace_back(name.toLower(), value);
 }
 void miledger::net::io_container::add_header(const miledger::net::kv& kv) {
     add_header(kv.first, kv.second);
 }
 void miledger::net::io_container::add_header(miledger::net::kv&& kv) {
-    for (auto& h : m_headers) {
-        if (QString::compare(h.first, kv.first, Qt::CaseInsensitive)) {
-            h.second = std::move(kv.second);
-            return;
-        }
-    }
-    m_headers.push_back(std::move(kv));
+    add_header(kv.first, kv.second);
 }
 void miledger::net::io_container::add_headers(const miledger::net::kv_vector& values) {
     m_headers.reserve(m_headers.size() + values.size());
@@ -102,21 +89,7 @@ void miledger::net::io_container::add_headers(const miledger::net::kv_vector& va
 }
 
 bool miledger::net::io_container::remove_header(const QString& name, bool icase) {
-    bool removed = false;
-    size_t i = 0;
-    for (auto& h : m_headers) {
-        if (icase && QString::compare(h.first, name, Qt::CaseInsensitive)) {
-            m_headers.erase(m_headers.begin() + i);
-            removed = true;
-        } else if (h.first == name) {
-            m_headers.erase(m_headers.begin() + i);
-            removed = true;
-        }
-
-        i++;
-    }
-
-    return removed;
+    return m_headers.remove(name.toStdString(), icase) > 0;
 }
 
 void miledger::net::io_container::clear_headers() {
@@ -139,38 +112,133 @@ void miledger::net::io_container::set_headers(const miledger::net::icase_multima
     }
 }
 QString miledger::net::io_container::get_body() const {
+    return QString::fromStdString(get_body_bytes());
+}
+const std::string& miledger::net::io_container::get_body_bytes() const {
+    static const std::string empty;
+    return m_body ? *m_body : empty;
+}
+miledger::net::body_buffer_t miledger::net::io_container::share_body() const {
     return m_body;
 }
+bool miledger::net::io_container::has_body_stream() const {
+    return (bool) m_body_stream;
+}
+const miledger::net::body_reader_t& miledger::net::io_container::get_body_stream() const {
+    return m_body_stream;
+}
+int64_t miledger::net::io_container::get_body_stream_size() const {
+    return m_body_stream_size;
+}
 std::size_t miledger::net::io_container::get_body_size() const {
-    return m_body.length();
+    if (m_body_stream) {
+        return m_body_stream_size > 0 ? (size_t) m_body_stream_size : 0;
+    }
+    return m_body ? m_body->size() : 0;
 }
 
 void miledger::net::io_container::clear_body() {
-    m_body.clear();
+    m_body.reset();
+    m_body_stream = nullptr;
+    m_body_stream_size = -1;
 }
 
 bool miledger::net::io_container::has_body() const {
-    return !m_body.isEmpty();
+    return m_body_stream || (m_body && !m_body->empty());
 }
 bool miledger::net::io_container::has_headers() const {
     return !m_headers.empty();
 }
-const miledger::net::kv_vector& miledger::net::io_container::get_headers() const {
+const miledger::net::kv_store& miledger::net::io_container::get_headers() const {
     return m_headers;
 }
 std::vector<QString> miledger::net::io_container::get_headers_glued() const {
-    std::vector<QString> out(m_headers.size());
-
-    QString tmp;
-    QTextStream ss(&tmp);
-    int i = 0;
+    std::vector<QString> out;
+    out.reserve(m_headers.size());
     for (const auto& h : m_headers) {
-        ss << h.first << ": " << h.second;
-        out[i] = ss.readAll();
-        tmp.clear();
-        ss.reset();
-        i++;
+        out.push_back(QString::fromStdString(h.key + ": " + h.value));
     }
 
     return out;
 }
+
+// KV STORE
+std::string miledger::net::kv_store::fold(const std::string& key) {
+    std::string out = key;
+    for (char& c : out) {
+        if (c >= 'A' && c <= 'Z') {
+            c = (char) (c + ('a' - 'A'));
+        }
+    }
+    return out;
+}
+
+uint32_t miledger::net::kv_store::hash_of(const std::string& folded) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : folded) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void miledger::net::kv_store::add(std::string key, std::string value) {
+    entry e;
+    e.folded = fold(key);
+    e.hash = hash_of(e.folded);
+    e.key = std::move(key);
+    e.value = std::move(value);
+    m_entries.push_back(std::move(e));
+}
+
+size_t miledger::net::kv_store::replace(const std::string& key, const std::string& value, bool icase) {
+    const std::string folded = fold(key);
+    const uint32_t hash = hash_of(folded);
+    size_t replaced = 0;
+    for (auto& e : m_entries) {
+        if (matches(e, hash, folded, key, icase)) {
+            e.value = value;
+            replaced++;
+        }
+    }
+    return replaced;
+}
+
+const miledger::net::kv_store::entry* miledger::net::kv_store::find(const std::string& key, bool icase) const {
+    const std::string folded = fold(key);
+    const uint32_t hash = hash_of(folded);
+    for (const auto& e : m_entries) {
+        if (matches(e, hash, folded, key, icase)) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+size_t miledger::net::kv_store::remove(const std::string& key, bool icase) {
+    const std::string folded = fold(key);
+    const uint32_t hash = hash_of(folded);
+    const size_t before = m_entries.size();
+    m_entries.erase(
+        std::remove_if(m_entries.begin(), m_entries.end(), [&](const entry& e) {
+            return matches(e, hash, folded, key, icase);
+        }),
+        m_entries.end());
+    return before - m_entries.size();
+}
+
+bool miledger::net::kv_store::remove_nth(const std::string& key, size_t index, bool icase) {
+    const std::string folded = fold(key);
+    const uint32_t hash = hash_of(folded);
+    size_t found = 0;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (matches(*it, hash, folded, key, icase)) {
+            if (found == index) {
+                m_entries.erase(it);
+                return true;
+            }
+            found++;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,710 @@
+/*!
+ * miledger.
+ * json_stream.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/json_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <clocale>
+#include <cstddef>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <new>
+
+namespace {
+
+std::atomic<bool> alloc_tracking{false};
+std::atomic<long long> alloc_current{0};
+std::atomic<long long> alloc_peak{0};
+// block size is kept before the block, header keeps alignment of malloc
+constexpr size_t alloc_header = alignof(std::max_align_t);
+
+/// \brief Measures peak of heap bytes allocated by operator new since it's creation or last take_peak().
+/// Single-threaded: meant for benchmark only, allocations of other threads are counted too
+class alloc_probe {
+public:
+    alloc_probe() {
+        reset();
+        alloc_tracking.store(true, std::memory_order_relaxed);
+    }
+    ~alloc_probe() {
+        alloc_tracking.store(false, std::memory_order_relaxed);
+    }
+
+    size_t take_peak() {
+        const auto peak = alloc_peak.load(std::memory_order_relaxed);
+        reset();
+        return (size_t) std::max(0LL, peak);
+    }
+
+private:
+    static void reset() {
+        alloc_current.store(0, std::memory_order_relaxed);
+        alloc_peak.store(0, std::memory_order_relaxed);
+    }
+};
+
+} // namespace
+
+// replaced globally, but counts only while alloc_probe is alive: other time it costs one relaxed load
+void* operator new(std::size_t size) {
+    void* block = std::malloc(size + alloc_header);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<std::size_t*>(block) = size;
+    if (alloc_tracking.load(std::memory_order_relaxed)) {
+        const auto current = alloc_current.fetch_add((long long) size, std::memory_order_relaxed) + (long long) size;
+        auto peak = alloc_peak.load(std::memory_order_relaxed);
+        while (current > peak && !alloc_peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+    return static_cast<char*>(block) + alloc_header;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    char* block = static_cast<char*>(ptr) - alloc_header;
+    if (alloc_tracking.load(std::memory_order_relaxed)) {
+        alloc_current.fetch_sub((long long) *reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+    }
+    std::free(block);
+}
+
+miledger::net::json_push_parser::json_push_parser(sax_t* handler)
+    : m_handler(handler) {
+}
+
+std::string miledger::net::json_push_parser::benchmark(size_t iterations) {
+    using clock_type = std::chrono::steady_clock;
+    using json = nlohmann::json;
+    using coins_t = minter::explorer::result<std::vector<minter::explorer::coin_item>>;
+
+    // coin list as explorer returns it: the largest answer app loads
+    json page;
+    page["data"] = json::array();
+    for (size_t i = 0; i < 3000; i++) {
+        json coin;
+        coin["id"] = i;
+        coin["crr"] = i % 4 == 0 ? 100 : 10 + i % 90;
+        coin["volume"] = fmt::format("{}.123456789012345678", 1000000 + 37 * i);
+        coin["reserve_balance"] = fmt::format("{}.987654321098765432", 20000 + 11 * i);
+        coin["max_supply"] = "1000000000000000.000000000000000000";
+        coin["name"] = fmt::format("Coin number {}", i);
+        coin["symbol"] = fmt::format("COIN{}", i);
+        coin["owner_address"] = "Mx7633980c000139dd3bd24a3f54e06474fa941e16";
+        coin["burnable"] = i % 2 == 0;
+        coin["mintable"] = i % 3 == 0;
+        coin["type"] = i % 5 == 0 ? "pool_token" : "coin";
+        coin["trading_volume_24h"] = fmt::format("{}.000000000000000000", 13 * i);
+        coin["trading_volume_1m"] = fmt::format("{}.000000000000000000", 390 * i);
+        coin["price_usd"] = fmt::format("0.{:018}", 7919 * i);
+        page["data"].push_back(std::move(coin));
+    }
+    const std::string body = page.dump();
+    page = json();
+    // curl delivers body by up to 16 KiB
+    const size_t chunk = 16384;
+
+    const auto parse_dom = [&body]() {
+        return json::parse(body).get<coins_t>();
+    };
+    const auto parse_stream = [&body, chunk]() {
+        json_stream_sink<coins_t> sink;
+        for (size_t pos = 0; pos < body.size(); pos += chunk) {
+            sink.write(body.data() + pos, std::min(chunk, body.size() - pos));
+        }
+        return sink.take();
+    };
+
+    // count of parsed items keeps compiler from dropping the work
+    size_t sink = 0;
+
+    // peak is taken from a separate run: result is alive while it's measured, as it is in app
+    alloc_probe probe;
+    sink += parse_dom().data.size();
+    const size_t dom_peak = probe.take_peak();
+    sink += parse_stream().data.size();
+    const size_t stream_peak = probe.take_peak();
+
+    auto begin = clock_type::now();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += parse_dom().data.size();
+    }
+    const auto dom_time = clock_type::now() - begin;
+
+    begin = clock_type::now();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += parse_stream().data.size();
+    }
+    const auto stream_time = clock_type::now() - begin;
+
+    const auto per_parse = [iterations](clock_type::duration d) {
+        return (double) std::chrono::duration_cast<std::chrono::microseconds>(d).count() / (double) std::max<size_t>(1, iterations);
+    };
+    const auto throughput = [iterations, &body](clock_type::duration d) {
+        const double seconds = std::max(1e-9, std::chrono::duration<double>(d).count());
+        return (double) body.size() * (double) iterations / seconds / (1024.0 * 1024.0);
+    };
+    const auto kib = [](size_t bytes) {
+        return (double) bytes / 1024.0;
+    };
+
+    return fmt::format(
+        "coin list parsing to result<vector<coin_item>>, {} payloads of {} bytes (checksum {}):\n"
+        "  json::parse + get<T> (DOM):     {:>10.0f} us/payload {:>8.1f} MiB/s {:>10.0f} KiB peak heap\n"
+        "  json_stream_sink<T>, streamed:  {:>10.0f} us/payload {:>8.1f} MiB/s {:>10.0f} KiB peak heap\n",
+        iterations, body.size(), sink,
+        per_parse(dom_time), throughput(dom_time), kib(dom_peak),
+        per_parse(stream_time), throughput(stream_time), kib(stream_peak));
+}
+
+bool miledger::net::json_push_parser::feed(const char* data, size_t len) {
+    if (m_failed) {
+        return false;
+    }
+
+    size_t i = 0;
+    while (i < len) {
+        if (m_mode == mode::string && m_high_surrogate == 0) {
+            // most of the body is string content, copy plain characters at once
+            size_t j = i;
+            while (j < len) {
+                auto c = (unsigned char) data[j];
+                if (c == '"' || c == '\\' || c < 0x20) {
+                    break;
+                }
+                ++j;
+            }
+            if (j > i) {
+                m_token.append(data + i, j - i);
+                m_pos += j - i;
+                i = j;
+                if (i == len) {
+                    break;
+                }
+            }
+        }
+
+        if (!process(data[i])) {
+            return false;
+        }
+        ++i;
+        ++m_pos;
+    }
+    return true;
+}
+
+bool miledger::net::json_push_parser::finish() {
+    if (m_failed) {
+        return false;
+    }
+    if (m_mode == mode::number && !finish_number()) {
+        return false;
+    }
+    if (m_mode == mode::literal && !finish_literal()) {
+        return false;
+    }
+    if (!completed()) {
+        return fail("unexpected end of input");
+    }
+    return true;
+}
+
+bool miledger::net::json_push_parser::process(char c) {
+    switch (m_mode) {
+    case mode::string:
+        if (m_high_surrogate != 0 && c != '\\') {
+            return fail("expected low surrogate");
+        }
+        if (c == '"') {
+            return finish_string();
+        }
+        if (c == '\\') {
+            m_mode = mode::string_escape;
+            return true;
+        }
+        if ((unsigned char) c < 0x20) {
+            return fail("control character in string");
+        }
+        m_token.push_back(c);
+        return true;
+
+    case mode::string_escape:
+        if (m_high_surrogate != 0 && c != 'u') {
+            return fail("expected low surrogate");
+        }
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            m_token.push_back(c);
+            break;
+        case 'b':
+            m_token.push_back('\b');
+            break;
+        case 'f':
+            m_token.push_back('\f');
+            break;
+        case 'n':
+            m_token.push_back('\n');
+            break;
+        case 'r':
+            m_token.push_back('\r');
+            break;
+        case 't':
+            m_token.push_back('\t');
+            break;
+        case 'u':
+            m_unicode.clear();
+            m_mode = mode::string_unicode;
+            return true;
+        default:
+            return fail("invalid escape sequence");
+        }
+        m_mode = mode::string;
+        return true;
+
+    case mode::string_unicode:
+        if (!std::isxdigit((unsigned char) c)) {
+            return fail("invalid unicode escape");
+        }
+        m_unicode.push_back(c);
+        if (m_unicode.size() == 4) {
+            return on_unicode_escape();
+        }
+        return true;
+
+    case mode::number:
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            m_token.push_back(c);
+            return true;
+        }
+        // number has no terminator, current char belongs to the next token
+        if (!finish_number()) {
+            return false;
+        }
+        return process(c);
+
+    case mode::literal:
+        if (c >= 'a' && c <= 'z') {
+            m_token.push_back(c);
+            if (m_token.size() > 5) {
+                return fail("invalid literal");
+            }
+            return true;
+        }
+        if (!finish_literal()) {
+            return false;
+        }
+        return process(c);
+
+    case mode::none:
+        break;
+    }
+
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        return true;
+    }
+
+    switch (m_expect) {
+    case expect::value:
+        return begin_value(c);
+
+    case expect::first_value_or_end:
+        if (c == ']') {
+            return end_container(false);
+        }
+        return begin_value(c);
+
+    case expect::key:
+    case expect::first_key_or_end:
+        if (c == '"') {
+            m_token.clear();
+            m_string_is_key = true;
+            m_mode = mode::string;
+            return true;
+        }
+        if (c == '}' && m_expect == expect::first_key_or_end) {
+            return end_container(true);
+        }
+        return fail("expected object key");
+
+    case expect::colon:
+        if (c == ':') {
+            m_expect = expect::value;
+            return true;
+        }
+        return fail("expected ':'");
+
+    case expect::comma_or_end:
+        if (c == ',') {
+            m_expect = m_stack.back() ? expect::key : expect::value;
+            return true;
+        }
+        if (c == '}' || c == ']') {
+            return end_container(c == '}');
+        }
+        return fail("expected ',' or end of container");
+
+    case expect::eof:
+        return fail("unexpected data after end of document");
+    }
+
+    return fail("invalid state");
+}
+
+bool miledger::net::json_push_parser::begin_value(char c) {
+    if (c == '{') {
+        if (!check(m_handler->start_object(std::size_t(-1)))) {
+            return false;
+        }
+        m_stack.push_back(true);
+        m_expect = expect::first_key_or_end;
+        return true;
+    }
+    if (c == '[') {
+        if (!check(m_handler->start_array(std::size_t(-1)))) {
+            return false;
+        }
+        m_stack.push_back(false);
+        m_expect = expect::first_value_or_end;
+        return true;
+    }
+    if (c == '"') {
+        m_token.clear();
+        m_string_is_key = false;
+        m_mode = mode::string;
+        return true;
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        m_token.assign(1, c);
+        m_mode = mode::number;
+        return true;
+    }
+    if (c >= 'a' && c <= 'z') {
+        m_token.assign(1, c);
+        m_mode = mode::literal;
+        return true;
+    }
+    return fail("unexpected character");
+}
+
+bool miledger::net::json_push_parser::end_container(bool object) {
+    if (m_stack.empty() || m_stack.back() != object) {
+        return fail("mismatched bracket");
+    }
+    if (!check(object ? m_handler->end_object() : m_handler->end_array())) {
+        return false;
+    }
+    m_stack.pop_back();
+    value_done();
+    return true;
+}
+
+bool miledger::net::json_push_parser::finish_string() {
+    m_mode = mode::none;
+    if (m_string_is_key) {
+        if (!check(m_handler->key(m_token))) {
+            return false;
+        }
+        m_expect = expect::colon;
+        return true;
+    }
+
+    if (!check(m_handler->string(m_token))) {
+        return false;
+    }
+    value_done();
+    return true;
+}
+
+bool miledger::net::json_push_parser::finish_number() {
+    m_mode = mode::none;
+
+    // strict RFC 8259 grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    const std::string& s = m_token;
+    size_t i = 0;
+    bool is_float = false;
+    const auto digits = [&s, &i]() {
+        size_t start = i;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+            ++i;
+        }
+        return i - start;
+    };
+
+    if (i < s.size() && s[i] == '-') {
+        ++i;
+    }
+    if (i < s.size() && s[i] == '0') {
+        ++i;
+    } else if (digits() == 0) {
+        return fail("invalid number");
+    }
+    if (i < s.size() && s[i] == '.') {
+        ++i;
+        is_float = true;
+        if (digits() == 0) {
+            return fail("invalid number");
+        }
+    }
+    if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        is_float = true;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
+            ++i;
+        }
+        if (digits() == 0) {
+            return fail("invalid number");
+        }
+    }
+    if (i != s.size()) {
+        return fail("invalid number");
+    }
+
+    if (!is_float) {
+        errno = 0;
+        if (s[0] == '-') {
+            long long val = std::strtoll(s.c_str(), nullptr, 10);
+            if (errno != ERANGE) {
+                if (!check(m_handler->number_integer(val))) {
+                    return false;
+                }
+                value_done();
+                return true;
+            }
+        } else {
+            unsigned long long val = std::strtoull(s.c_str(), nullptr, 10);
+            if (errno != ERANGE) {
+                if (!check(m_handler->number_unsigned(val))) {
+                    return false;
+                }
+                value_done();
+                return true;
+            }
+        }
+        // doesn't fit 64 bits, fallback to float as nlohmann does
+    }
+
+    // Qt sets system locale on startup, so strtod may expect other decimal separator
+    std::string tmp = s;
+    const char decimal_point = *std::localeconv()->decimal_point;
+    if (decimal_point != '.') {
+        auto dot = tmp.find('.');
+        if (dot != std::string::npos) {
+            tmp[dot] = decimal_point;
+        }
+    }
+    double val = std::strtod(tmp.c_str(), nullptr);
+    if (!check(m_handler->number_float(val, s))) {
+        return false;
+    }
+    value_done();
+    return true;
+}
+
+bool miledger::net::json_push_parser::finish_literal() {
+    m_mode = mode::none;
+
+    bool res;
+    if (m_token == "true") {
+        res = m_handler->boolean(true);
+    } else if (m_token == "false") {
+        res = m_handler->boolean(false);
+    } else if (m_token == "null") {
+        res = m_handler->null();
+    } else {
+        return fail("invalid literal");
+    }
+
+    if (!check(res)) {
+        return false;
+    }
+    value_done();
+    return true;
+}
+
+bool miledger::net::json_push_parser::on_unicode_escape() {
+    m_mode = mode::string;
+    auto cp = (uint32_t) std::strtoul(m_unicode.c_str(), nullptr, 16);
+
+    if (m_high_surrogate != 0) {
+        if (cp < 0xDC00 || cp > 0xDFFF) {
+            return fail("expected low surrogate");
+        }
+        append_utf8(m_token, 0x10000 + ((m_high_surrogate - 0xD800) << 10) + (cp - 0xDC00));
+        m_high_surrogate = 0;
+        return true;
+    }
+
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        m_high_surrogate = cp;
+        return true;
+    }
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return fail("unexpected low surrogate");
+    }
+
+    append_utf8(m_token, cp);
+    return true;
+}
+
+void miledger::net::json_push_parser::value_done() {
+    m_expect = m_stack.empty() ? expect::eof : expect::comma_or_end;
+}
+
+bool miledger::net::json_push_parser::fail(const std::string& message) {
+    m_failed = true;
+    m_error = "JSON parse error at byte " + std::to_string(m_pos) + ": " + message;
+    m_handler->parse_error((std::size_t) m_pos, m_token, nlohmann::detail::parse_error::create(101, (std::size_t) m_pos, message));
+    return false;
+}
+
+bool miledger::net::json_push_parser::check(bool handler_result) {
+    if (!handler_result) {
+        m_failed = true;
+        m_error = "JSON parsing stopped by handler at byte " + std::to_string(m_pos);
+    }
+    return handler_result;
+}
+
+void miledger::net::json_push_parser::append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back((char) cp);
+    } else if (cp < 0x800) {
+        out.push_back((char) (0xC0 | (cp >> 6)));
+        out.push_back((char) (0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back((char) (0xE0 | (cp >> 12)));
+        out.push_back((char) (0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char) (0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back((char) (0xF0 | (cp >> 18)));
+        out.push_back((char) (0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back((char) (0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char) (0x80 | (cp & 0x3F)));
+    }
+}
+
+void miledger::net::json_dom_sax::stream_items(std::string field, item_callback_t cb) {
+    m_items_field = std::move(field);
+    m_item_cb = std::move(cb);
+}
+
+bool miledger::net::json_dom_sax::null() {
+    handle_value(json(nullptr));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::boolean(bool val) {
+    handle_value(json(val));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::number_integer(number_integer_t val) {
+    handle_value(json(val));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::number_unsigned(number_unsigned_t val) {
+    handle_value(json(val));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::number_float(number_float_t val, const string_t&) {
+    handle_value(json(val));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::string(string_t& val) {
+    handle_value(json(std::move(val)));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::binary(binary_t& val) {
+    handle_value(json::binary(val));
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::start_object(std::size_t) {
+    m_ref_stack.push_back(handle_value(json(json::value_t::object)));
+    return true;
+}
+
+bool miledger::net::json_dom_sax::key(string_t& val) {
+    if (m_ref_stack.size() == 1) {
+        m_root_key = val;
+    }
+    m_object_element = &(*m_ref_stack.back())[val];
+    return true;
+}
+
+bool miledger::net::json_dom_sax::end_object() {
+    m_ref_stack.pop_back();
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::start_array(std::size_t) {
+    json* arr = handle_value(json(json::value_t::array));
+    m_ref_stack.push_back(arr);
+
+    if (m_item_cb && !m_items_array && m_ref_stack.size() == 2 && m_root.is_object() && m_root_key == m_items_field) {
+        m_items_array = arr;
+    }
+    return true;
+}
+
+bool miledger::net::json_dom_sax::end_array() {
+    m_ref_stack.pop_back();
+    return item_completed();
+}
+
+bool miledger::net::json_dom_sax::parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+    return false;
+}
+
+nlohmann::json* miledger::net::json_dom_sax::handle_value(json&& val) {
+    if (m_ref_stack.empty()) {
+        m_root = std::move(val);
+        return &m_root;
+    }
+
+    json* parent = m_ref_stack.back();
+    if (parent->is_array()) {
+        parent->emplace_back(std::move(val));
+        return &parent->back();
+    }
+
+    *m_object_element = std::move(val);
+    return m_object_element;
+}
+
+bool miledger::net::json_dom_sax::item_completed() {
+    if (!m_items_array || m_ref_stack.empty() || m_ref_stack.back() != m_items_array) {
+        return true;
+    }
+
+    // array keeps only element which is being parsed right now
+    auto& items = m_items_array->get_ref<json::array_t&>();
+    json item = std::move(items.back());
+    items.pop_back();
+
+    try {
+        m_item_cb(std::move(item));
+    } catch (...) {
+        m_exception = std::current_exception();
+        return false;
+    }
+    return true;
+}
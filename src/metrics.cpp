@@ -0,0 +1,208 @@
+/*!
+ * miledger.
+ * metrics.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+
+size_t miledger::net::latency_histogram::index_of(uint64_t value) {
+    if (value < sub_buckets) {
+        return (size_t) value;
+    }
+
+    size_t msb = 63;
+    while (((value >> msb) & 1u) == 0) {
+        msb--;
+    }
+    const size_t shift = msb - 3;
+    const size_t sub = (size_t) (value >> shift) & (sub_buckets - 1);
+    return std::min((msb - 2) * sub_buckets + sub, buckets_count - 1);
+}
+
+uint64_t miledger::net::latency_histogram::lower_of(size_t index) {
+    if (index < sub_buckets) {
+        return index;
+    }
+    const size_t msb = index / sub_buckets + 2;
+    const size_t sub = index % sub_buckets;
+    return (uint64_t) (sub_buckets + sub) << (msb - 3);
+}
+
+uint64_t miledger::net::latency_histogram::upper_of(size_t index) {
+    if (index < sub_buckets) {
+        return index;
+    }
+    const size_t msb = index / sub_buckets + 2;
+    return lower_of(index) + ((uint64_t) 1 << (msb - 3)) - 1;
+}
+
+void miledger::net::latency_histogram::add(uint64_t micros) {
+    m_buckets[index_of(micros)]++;
+    m_count++;
+}
+
+uint64_t miledger::net::latency_histogram::quantile(double q) const {
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const auto rank = std::max<uint64_t>(1, (uint64_t) std::ceil(q * (double) m_count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_count; i++) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return (lower_of(i) + upper_of(i)) / 2;
+        }
+    }
+    return upper_of(buckets_count - 1);
+}
+
+void miledger::net::metrics_registry::record(const std::string& endpoint, const call_sample& sample) {
+    const auto us = (uint64_t) std::max<long long>(0, sample.latency.count());
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto& e = m_entries[endpoint];
+    e.stats.requests++;
+    if (sample.cache_hit) {
+        // would drag quantiles to zero and make hedging fire on every call
+        e.stats.cache_hits++;
+        return;
+    }
+    if (sample.error) {
+        e.stats.errors++;
+    }
+    e.stats.bytes_in += sample.bytes_in;
+    e.stats.bytes_out += sample.bytes_out;
+    e.stats.bytes_decoded += sample.bytes_decoded;
+    e.stats.decode_us += (uint64_t) std::max<long long>(0, sample.decode_time.count());
+    if (sample.cancelled) {
+        // time until caller gave up says nothing about endpoint latency
+        e.stats.cancelled++;
+        return;
+    }
+    e.stats.total_us += us;
+    e.stats.max_us = std::max(e.stats.max_us, us);
+    e.histogram.add(us);
+}
+
+void miledger::net::metrics_registry::record_attempt(const std::string& endpoint, std::chrono::microseconds latency) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto& e = m_entries[endpoint];
+    e.stats.attempts++;
+    e.attempts.add((uint64_t) std::max<long long>(0, latency.count()));
+}
+
+void miledger::net::metrics_registry::record_timing(const std::string& name, std::chrono::microseconds latency) {
+    call_sample sample;
+    sample.latency = latency;
+    record(name, sample);
+}
+
+miledger::net::metrics_registry::endpoint_stats miledger::net::metrics_registry::get_stats(const std::string& endpoint) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(endpoint);
+    if (it == m_entries.end()) {
+        endpoint_stats out;
+        out.name = endpoint;
+        return out;
+    }
+    auto out = make_stats(it->second);
+    out.name = endpoint;
+    return out;
+}
+
+std::chrono::milliseconds miledger::net::metrics_registry::get_quantile(const std::string& endpoint, double q, uint64_t min_samples) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(endpoint);
+    if (it == m_entries.end() || it->second.histogram.count() < min_samples) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(it->second.histogram.quantile(q) / 1000);
+}
+
+std::chrono::milliseconds miledger::net::metrics_registry::get_attempt_quantile(const std::string& endpoint, double q, uint64_t min_samples) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(endpoint);
+    if (it == m_entries.end() || it->second.attempts.count() < min_samples) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(it->second.attempts.quantile(q) / 1000);
+}
+
+std::vector<miledger::net::metrics_registry::endpoint_stats> miledger::net::metrics_registry::snapshot() const {
+    std::vector<endpoint_stats> out;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        out.reserve(m_entries.size());
+        for (const auto& it : m_entries) {
+            out.push_back(make_stats(it.second));
+            out.back().name = it.first;
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const endpoint_stats& lhs, const endpoint_stats& rhs) {
+        return lhs.total_us > rhs.total_us;
+    });
+    return out;
+}
+
+std::string miledger::net::metrics_registry::dump() const {
+    std::string out = fmt::format("{:<40} {:>7} {:>6} {:>6} {:>6} {:>10} {:>10} {:>10} {:>9} {:>9} {:>9} {:>9} {:>9} {:>10} {:>9}\n",
+                                  "endpoint", "reqs", "errs", "cancel", "hits", "in KiB", "dec KiB", "out KiB", "dec ms", "p50 ms", "p95 ms", "p99 ms", "max ms", "total ms", "att p95");
+    for (const auto& s : snapshot()) {
+        out += fmt::format("{:<40} {:>7} {:>6} {:>6} {:>6} {:>10.1f} {:>10.1f} {:>10.1f} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f} {:>10.1f} {:>9.1f}\n",
+                           s.name, s.requests, s.errors, s.cancelled, s.cache_hits,
+                           s.bytes_in / 1024.0, s.bytes_decoded / 1024.0, s.bytes_out / 1024.0, s.decode_us / 1000.0,
+                           s.p50_us / 1000.0, s.p95_us / 1000.0, s.p99_us / 1000.0, s.max_us / 1000.0,
+                           s.total_us / 1000.0, s.attempt_p95_us / 1000.0);
+    }
+    return out;
+}
+
+nlohmann::json miledger::net::metrics_registry::dump_json() const {
+    nlohmann::json out = nlohmann::json::array();
+    for (const auto& s : snapshot()) {
+        nlohmann::json j;
+        j["endpoint"] = s.name;
+        j["requests"] = s.requests;
+        j["errors"] = s.errors;
+        j["cancelled"] = s.cancelled;
+        j["cache_hits"] = s.cache_hits;
+        j["bytes_in"] = s.bytes_in;
+        j["bytes_out"] = s.bytes_out;
+        j["bytes_decoded"] = s.bytes_decoded;
+        j["decode_us"] = s.decode_us;
+        j["p50_us"] = s.p50_us;
+        j["p95_us"] = s.p95_us;
+        j["p99_us"] = s.p99_us;
+        j["max_us"] = s.max_us;
+        j["total_us"] = s.total_us;
+        j["attempts"] = s.attempts;
+        j["attempt_p95_us"] = s.attempt_p95_us;
+        out.push_back(std::move(j));
+    }
+    return out;
+}
+
+void miledger::net::metrics_registry::reset() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_entries.clear();
+}
+
+miledger::net::metrics_registry::endpoint_stats miledger::net::metrics_registry::make_stats(const entry& e) {
+    endpoint_stats out = e.stats;
+    // bucket midpoint may be above the real maximum
+    out.p50_us = std::min(e.histogram.quantile(0.50), out.max_us);
+    out.p95_us = std::min(e.histogram.quantile(0.95), out.max_us);
+    out.p99_us = std::min(e.histogram.quantile(0.99), out.max_us);
+    out.attempt_p95_us = e.attempts.quantile(0.95);
+    return out;
+}
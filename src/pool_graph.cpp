@@ -0,0 +1,319 @@
+/*!
+ * miledger.
+ * pool_graph.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/pool_graph.h"
+
+#include <algorithm>
+#include <minter/tx/utils.h>
+#include <stdexcept>
+#include <string>
+
+namespace {
+uint64_t json_coin_id(const nlohmann::json& value) {
+    if (value.is_string()) {
+        return std::stoull(value.get<std::string>());
+    }
+    return value.get<uint64_t>();
+}
+
+dev::bigint ceil_div(const dev::bigint& num, const dev::bigint& den) {
+    return (num + den - 1) / den;
+}
+} // namespace
+
+const size_t miledger::repo::pool_graph::max_route_coins;
+const unsigned miledger::repo::pool_graph::commission;
+
+miledger::repo::pool_graph::pool_graph(const miledger::repo::explorer_repo& repo)
+    : m_repo(repo) {
+}
+
+rxcpp::observable<size_t> miledger::repo::pool_graph::refresh() {
+    return fetch_page(1)
+        .flat_map([this](const nlohmann::json& first) {
+            uint32_t last_page = 1;
+            if (first.contains("meta") && first.at("meta").contains("last_page")) {
+                last_page = first.at("meta").at("last_page").get<uint32_t>();
+            }
+            auto out = rxcpp::observable<>::just(first).as_dynamic();
+            if (last_page <= 1) {
+                return out;
+            }
+            auto rest = rxcpp::observable<>::range<uint32_t>(2, last_page)
+                            .concat_map([this](uint32_t page) {
+                                return fetch_page(page);
+                            });
+            return out.concat(rest).as_dynamic();
+        })
+        .reduce(
+            std::make_shared<graph>(),
+            [](std::shared_ptr<graph> g, const nlohmann::json& page) {
+                add_page(*g, page);
+                return g;
+            })
+        .map([this](std::shared_ptr<graph> g) {
+            g->loaded_at = std::chrono::steady_clock::now();
+            const size_t count = g->pools.size();
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_graph = std::move(g);
+            return count;
+        })
+        .as_dynamic();
+}
+
+optns::optional<miledger::repo::pool_graph::route>
+miledger::repo::pool_graph::find_route(const dev::bigint& coin_from, const dev::bigint& coin_to, const dev::bigint& amount, pool_swap_type type) const {
+    std::shared_ptr<const graph> g;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        g = m_graph;
+    }
+    if (!g || amount <= 0) {
+        return {};
+    }
+
+    auto from = g->nodes.find(to_id(coin_from));
+    auto to = g->nodes.find(to_id(coin_to));
+    if (from == g->nodes.end() || to == g->nodes.end() || from->second == to->second) {
+        return {};
+    }
+
+    optns::optional<step> found;
+    if (type == pool_swap_type::buy) {
+        found = find_buy(*g, from->second, to->second, amount);
+    } else {
+        found = find_sell(*g, from->second, to->second, amount);
+    }
+    if (!found) {
+        return {};
+    }
+
+    route out;
+    for (uint32_t node : found->path) {
+        out.coins.push_back(g->coins[node]);
+    }
+    if (type == pool_swap_type::buy) {
+        out.amount_in = found->amount;
+        out.amount_out = amount;
+    } else {
+        out.amount_in = amount;
+        out.amount_out = found->amount;
+    }
+    return out;
+}
+
+std::vector<miledger::repo::pool_graph::pool_info> miledger::repo::pool_graph::pools() const {
+    std::shared_ptr<const graph> g;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        g = m_graph;
+    }
+    std::vector<pool_info> out;
+    if (!g) {
+        return out;
+    }
+    out.reserve(g->pools.size());
+    for (const auto& pool : g->pools) {
+        out.push_back(pool_info{g->coins[pool.coin0], g->coins[pool.coin1], pool.token});
+    }
+    return out;
+}
+
+bool miledger::repo::pool_graph::empty() const {
+    return size() == 0;
+}
+
+size_t miledger::repo::pool_graph::size() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_graph ? m_graph->pools.size() : 0;
+}
+
+std::chrono::steady_clock::duration miledger::repo::pool_graph::age() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_graph) {
+        return std::chrono::steady_clock::duration::max();
+    }
+    return std::chrono::steady_clock::now() - m_graph->loaded_at;
+}
+
+dev::bigint miledger::repo::pool_graph::get_amount_out(const dev::bigint& amount_in, const dev::bigint& reserve_in, const dev::bigint& reserve_out) {
+    if (amount_in <= 0 || reserve_in <= 0 || reserve_out <= 0) {
+        return dev::bigint("0");
+    }
+    // k stays the same with commission taken from amount in; chain rounds result one pip down
+    const dev::bigint balance_in = reserve_in * 1000 + amount_in * (1000 - commission);
+    dev::bigint out = reserve_out - (reserve_in * reserve_out * 1000) / balance_in - 1;
+    if (out <= 0) {
+        return dev::bigint("0");
+    }
+    return out;
+}
+
+dev::bigint miledger::repo::pool_graph::get_amount_in(const dev::bigint& amount_out, const dev::bigint& reserve_in, const dev::bigint& reserve_out) {
+    if (amount_out <= 0 || reserve_in <= 0 || amount_out >= reserve_out) {
+        return dev::bigint("0");
+    }
+    const dev::bigint balance_in = ceil_div(reserve_in * reserve_out * 1000, reserve_out - amount_out);
+    return ceil_div(balance_in - reserve_in * 1000, dev::bigint(1000 - commission)) + 1;
+}
+
+uint32_t miledger::repo::pool_graph::graph::node_of(const nlohmann::json& coin) {
+    const uint64_t id = json_coin_id(coin.at("id"));
+    auto it = nodes.find(id);
+    if (it != nodes.end()) {
+        return it->second;
+    }
+
+    minter::explorer::coin_item_base item;
+    item.id = dev::bigint(std::to_string(id));
+    item.symbol = coin.value("symbol", std::string());
+    const auto node = (uint32_t) coins.size();
+    coins.push_back(std::move(item));
+    adjacent.emplace_back();
+    nodes.emplace(id, node);
+    return node;
+}
+
+std::pair<const dev::bigint&, const dev::bigint&> miledger::repo::pool_graph::graph::reserves(const edge& e, uint32_t from) const {
+    const auto& pool = pools[e.pool];
+    if (pool.coin0 == from) {
+        return {pool.reserve0, pool.reserve1};
+    }
+    return {pool.reserve1, pool.reserve0};
+}
+
+optns::optional<miledger::repo::pool_graph::step>
+miledger::repo::pool_graph::find_sell(const graph& g, uint32_t from, uint32_t to, const dev::bigint& amount) {
+    // amount of each coin reachable with current number of hops, the most one
+    std::unordered_map<uint32_t, step> layer;
+    layer.emplace(from, step{amount, {from}});
+    optns::optional<step> best;
+
+    for (size_t hop = 1; hop < max_route_coins && !layer.empty(); hop++) {
+        std::unordered_map<uint32_t, step> next;
+        for (const auto& item : layer) {
+            const step& current = item.second;
+            for (const auto& e : g.adjacent[item.first]) {
+                if (std::find(current.path.begin(), current.path.end(), e.coin) != current.path.end()) {
+                    continue;
+                }
+                const auto res = g.reserves(e, item.first);
+                dev::bigint out = get_amount_out(current.amount, res.first, res.second);
+                if (out <= 0) {
+                    continue;
+                }
+                auto it = next.find(e.coin);
+                if (it == next.end() || it->second.amount < out) {
+                    step value{std::move(out), current.path};
+                    value.path.push_back(e.coin);
+                    next[e.coin] = std::move(value);
+                }
+            }
+        }
+
+        auto target = next.find(to);
+        if (target != next.end()) {
+            if (!best || best->amount < target->second.amount) {
+                best = target->second;
+            }
+            // route ends at target
+            next.erase(target);
+        }
+        layer = std::move(next);
+    }
+    return best;
+}
+
+optns::optional<miledger::repo::pool_graph::step>
+miledger::repo::pool_graph::find_buy(const graph& g, uint32_t from, uint32_t to, const dev::bigint& amount) {
+    // backwards from target: amount of each coin needed to get amount of target, the least one; path is reversed
+    std::unordered_map<uint32_t, step> layer;
+    layer.emplace(to, step{amount, {to}});
+    optns::optional<step> best;
+
+    for (size_t hop = 1; hop < max_route_coins && !layer.empty(); hop++) {
+        std::unordered_map<uint32_t, step> next;
+        for (const auto& item : layer) {
+            const step& current = item.second;
+            for (const auto& e : g.adjacent[item.first]) {
+                if (std::find(current.path.begin(), current.path.end(), e.coin) != current.path.end()) {
+                    continue;
+                }
+                const auto res = g.reserves(e, e.coin);
+                dev::bigint in = get_amount_in(current.amount, res.first, res.second);
+                if (in <= 0) {
+                    continue;
+                }
+                auto it = next.find(e.coin);
+                if (it == next.end() || in < it->second.amount) {
+                    step value{std::move(in), current.path};
+                    value.path.push_back(e.coin);
+                    next[e.coin] = std::move(value);
+                }
+            }
+        }
+
+        auto source = next.find(from);
+        if (source != next.end()) {
+            if (!best || source->second.amount < best->amount) {
+                best = source->second;
+            }
+            next.erase(source);
+        }
+        layer = std::move(next);
+    }
+
+    if (best) {
+        std::reverse(best->path.begin(), best->path.end());
+    }
+    return best;
+}
+
+void miledger::repo::pool_graph::add_page(graph& g, const nlohmann::json& answer) {
+    if (!answer.contains("data") || !answer.at("data").is_array()) {
+        return;
+    }
+    for (const auto& item : answer.at("data")) {
+        if (!item.contains("coin0") || !item.contains("coin1")) {
+            continue;
+        }
+        pool_entry pool;
+        pool.coin0 = g.node_of(item.at("coin0"));
+        pool.coin1 = g.node_of(item.at("coin1"));
+        // explorer gives reserves in coins, route math is in pips
+        pool.reserve0 = minter::utils::normalize_value(dev::bigdec18(item.value("amount0", std::string("0"))));
+        pool.reserve1 = minter::utils::normalize_value(dev::bigdec18(item.value("amount1", std::string("0"))));
+        if (pool.reserve0 <= 0 || pool.reserve1 <= 0) {
+            continue;
+        }
+        if (item.contains("token") && item.at("token").is_object()) {
+            pool.token = item.at("token").value("symbol", std::string());
+        }
+
+        const auto index = (uint32_t) g.pools.size();
+        g.adjacent[pool.coin0].push_back(edge{pool.coin1, index});
+        g.adjacent[pool.coin1].push_back(edge{pool.coin0, index});
+        g.pools.push_back(std::move(pool));
+    }
+}
+
+uint64_t miledger::repo::pool_graph::to_id(const dev::bigint& id) {
+    return std::stoull(minter::utils::to_string(id));
+}
+
+rxcpp::observable<nlohmann::json> miledger::repo::pool_graph::fetch_page(uint32_t page) const {
+    return m_repo.pools_list_json(page)
+        .map([](nlohmann::json answer) {
+            if (answer.contains("error") && answer.at("error").is_object()) {
+                throw std::runtime_error(answer.at("error").value("message", std::string("Unknown explorer error")));
+            }
+            return answer;
+        })
+        .as_dynamic();
+}
@@ -0,0 +1,371 @@
+/*!
+ * miledger.
+ * qt_transport.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/qt_transport.h"
+
+#include "include/net/content_decoder.h"
+#include "include/net/fixtures.h"
+
+#include <QIODevice>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QThread>
+#include <QTimer>
+#include <curl/curl.h>
+
+namespace {
+
+/// \brief Upload device which pulls streamed request body from it's reader
+class body_stream_device : public QIODevice {
+public:
+    explicit body_stream_device(miledger::net::body_reader_t reader)
+        : m_reader(std::move(reader)) {
+        open(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override {
+        return true;
+    }
+
+    bool atEnd() const override {
+        return m_eof && QIODevice::atEnd();
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override {
+        if (m_eof || maxlen <= 0) {
+            return m_eof ? -1 : 0;
+        }
+        const size_t n = m_reader(data, (size_t) maxlen);
+        if (n == 0) {
+            m_eof = true;
+            return -1;
+        }
+        return (qint64) n;
+    }
+
+    qint64 writeData(const char*, qint64) override {
+        return -1;
+    }
+
+private:
+    miledger::net::body_reader_t m_reader;
+    bool m_eof = false;
+};
+
+QNetworkRequest::Priority to_qt_priority(miledger::net::request_priority priority) {
+    switch (priority) {
+    case miledger::net::request_priority::interactive:
+        return QNetworkRequest::HighPriority;
+    case miledger::net::request_priority::normal:
+        return QNetworkRequest::NormalPriority;
+    case miledger::net::request_priority::background:
+        return QNetworkRequest::LowPriority;
+    }
+    return QNetworkRequest::NormalPriority;
+}
+
+/// \brief Qt also reports HTTP statuses as errors, only errors without server answer are transport ones
+bool is_transport_error(QNetworkReply::NetworkError err) {
+    return err != QNetworkReply::NoError && err < QNetworkReply::ContentAccessDenied;
+}
+
+CURLcode to_curl_code(QNetworkReply::NetworkError err) {
+    switch (err) {
+    case QNetworkReply::HostNotFoundError:
+        return CURLE_COULDNT_RESOLVE_HOST;
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyNotFoundError:
+        return CURLE_COULDNT_CONNECT;
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+        return CURLE_GOT_NOTHING;
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::ProxyTimeoutError:
+    // own aborts are flagged in transfer, so this one is transfer timeout
+    case QNetworkReply::OperationCanceledError:
+        return CURLE_OPERATION_TIMEDOUT;
+    case QNetworkReply::SslHandshakeFailedError:
+        return CURLE_SSL_CONNECT_ERROR;
+    case QNetworkReply::TooManyRedirectsError:
+        return CURLE_TOO_MANY_REDIRECTS;
+    default:
+        return CURLE_RECV_ERROR;
+    }
+}
+
+} // namespace
+
+struct miledger::net::qt_transport::transfer {
+    std::shared_ptr<miledger::net::http_call> call;
+    QNetworkReply* reply = nullptr;
+    QTimer* timeout = nullptr;
+    /// \brief Decompresses body and passes it to the call sink
+    std::shared_ptr<response_sink> output;
+    /// \brief Record mode: copy of decompressed response body
+    bool record = false;
+    std::string recorded;
+    bool write_failed = false;
+    bool timed_out = false;
+    bool cancelled = false;
+};
+
+miledger::net::qt_transport::qt_transport()
+    : m_thread(new QThread())
+    , m_context(new QObject())
+    , m_manager(nullptr)
+    , m_active_size(0) {
+    m_thread->setObjectName("qt_transport");
+    m_context->moveToThread(m_thread);
+    m_thread->start();
+
+    // manager must be created in the thread which uses it
+    QMetaObject::invokeMethod(
+        m_context, [this]() {
+            m_manager = new QNetworkAccessManager(m_context);
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+miledger::net::qt_transport::~qt_transport() {
+    QMetaObject::invokeMethod(
+        m_context, [this]() {
+            m_active.clear();
+            // deletes manager and it's replies
+            delete m_context;
+        },
+        Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+}
+
+void miledger::net::qt_transport::submit(std::shared_ptr<miledger::net::http_call> call) {
+    QMetaObject::invokeMethod(
+        m_context, [this, call]() {
+            start(call);
+        },
+        Qt::QueuedConnection);
+}
+
+void miledger::net::qt_transport::cancel(std::shared_ptr<miledger::net::http_call> call) {
+    // queued after submit of the same call, so call is either running or already finished here
+    QMetaObject::invokeMethod(
+        m_context, [this, call]() {
+            abort(call);
+        },
+        Qt::QueuedConnection);
+}
+
+void miledger::net::qt_transport::schedule(std::chrono::milliseconds delay, std::function<void()> task) {
+    // timer must be started in the thread which runs it
+    QMetaObject::invokeMethod(
+        m_context, [this, delay, task]() {
+            QTimer::singleShot(delay, m_context, task);
+        },
+        Qt::QueuedConnection);
+}
+
+size_t miledger::net::qt_transport::active_size() const {
+    return m_active_size.load(std::memory_order_relaxed);
+}
+
+void miledger::net::qt_transport::start(std::shared_ptr<miledger::net::http_call> call) {
+    if (!call->begin(std::chrono::steady_clock::now())) {
+        call->resp.error_code = (int) CURLE_OPERATION_TIMEDOUT;
+        call->resp.error_message = "Call budget is spent in queue";
+        if (call->on_done) {
+            call->on_done(call);
+        }
+        return;
+    }
+
+    auto t = std::make_unique<transfer>();
+    t->call = call;
+
+    QNetworkRequest qreq = call->req.to_qt_request();
+    if (!call->req.get_headers().find("accept-encoding")) {
+        // explicit header turns off decompression of Qt, body is decoded by decoding_sink as in curl transport
+        qreq.setRawHeader("Accept-Encoding", decoding_sink::accept_encoding());
+    }
+
+    auto& fx = fixtures::get();
+    if (fx.get_mode() == fixtures::mode::replay) {
+        qreq.setRawHeader(fixtures::url_header, QByteArray::fromStdString(fixtures::fixture_url(call->req)));
+        qreq.setUrl(QUrl(QString::fromStdString(fx.replay_url(call->req))));
+    } else if (fx.get_mode() == fixtures::mode::record) {
+        t->record = true;
+    }
+
+    qreq.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    qreq.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    qreq.setPriority(to_qt_priority(call->priority));
+    if (call->connect_timeout.count() > 0) {
+        // closest to connect timeout what Qt has: abort if nothing was transferred for this time
+        qreq.setTransferTimeout((int) call->connect_timeout.count());
+    }
+
+    t->output = std::make_shared<decoding_sink>(
+        std::make_shared<recording_sink>(call->sink, t->record ? &t->recorded : nullptr),
+        &call->resp);
+
+    QNetworkReply* reply = nullptr;
+    switch (call->req.get_method()) {
+    case miledger::net::request::method::get:
+        reply = m_manager->get(qreq);
+        break;
+    case miledger::net::request::method::head:
+        reply = m_manager->head(qreq);
+        break;
+    case miledger::net::request::method::post:
+    case miledger::net::request::method::put:
+    case miledger::net::request::method::delete_: {
+        const QByteArray verb = call->req.get_method_str().toUtf8();
+        if (call->req.has_body_stream()) {
+            auto* device = new body_stream_device(call->req.get_body_stream());
+            reply = m_manager->sendCustomRequest(qreq, verb, device);
+            device->setParent(reply);
+        } else {
+            // no copy: Qt reads body in place, buffer is released with reply
+            body_buffer_t body = call->req.share_body();
+            QByteArray data = body ? QByteArray::fromRawData(body->data(), (qsizetype) body->size()) : QByteArray();
+            reply = m_manager->sendCustomRequest(qreq, verb, data);
+            QObject::connect(reply, &QObject::destroyed, [body]() {});
+        }
+        break;
+    }
+    }
+
+    t->reply = reply;
+    transfer* raw = t.get();
+
+    if (!call->verify_ssl) {
+        QObject::connect(reply, &QNetworkReply::sslErrors, reply, [reply]() {
+            reply->ignoreSslErrors();
+        });
+    }
+    if (call->total_timeout.count() > 0) {
+        raw->timeout = new QTimer(reply);
+        raw->timeout->setSingleShot(true);
+        QObject::connect(raw->timeout, &QTimer::timeout, reply, [raw]() {
+            raw->timed_out = true;
+            raw->reply->abort();
+        });
+        raw->timeout->start(call->total_timeout);
+    }
+
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, m_context, [raw]() {
+        read_headers(raw);
+    });
+    QObject::connect(reply, &QNetworkReply::readyRead, m_context, [raw]() {
+        read_body(raw);
+    });
+    QObject::connect(reply, &QNetworkReply::finished, m_context, [this, raw]() {
+        finish(raw);
+    });
+
+    m_active[call.get()] = std::move(t);
+    m_active_size = m_active.size();
+}
+
+void miledger::net::qt_transport::abort(const std::shared_ptr<miledger::net::http_call>& call) {
+    auto it = m_active.find(call.get());
+    if (it == m_active.end()) {
+        // already finished
+        return;
+    }
+    it->second->cancelled = true;
+    // emits finished right away
+    it->second->reply->abort();
+}
+
+void miledger::net::qt_transport::read_headers(transfer* t) {
+    auto& resp = t->call->resp;
+    // status is needed by sinks before the body
+    resp.status_code = t->reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    resp.headers.clear();
+    for (const auto& h : t->reply->rawHeaderPairs()) {
+        resp.headers.emplace_back(h.first.toLower().toStdString(), h.second.trimmed().toStdString());
+    }
+}
+
+void miledger::net::qt_transport::read_body(transfer* t) {
+    if (t->write_failed || t->cancelled || t->timed_out) {
+        return;
+    }
+    const QByteArray chunk = t->reply->readAll();
+    if (chunk.isEmpty()) {
+        return;
+    }
+    t->call->resp.bytes_in += (uint64_t) chunk.size();
+    if (!t->output->write(chunk.constData(), (size_t) chunk.size())) {
+        t->write_failed = true;
+        t->reply->abort();
+    }
+}
+
+void miledger::net::qt_transport::finish(transfer* raw) {
+    auto it = m_active.find(raw->call.get());
+    if (it == m_active.end()) {
+        return;
+    }
+
+    std::unique_ptr<transfer> t = std::move(it->second);
+    m_active.erase(it);
+    m_active_size = m_active.size();
+
+    // reply is deleted later, transfer right now: nothing may refer to it after this point
+    QObject::disconnect(t->reply, nullptr, m_context, nullptr);
+    if (t->timeout) {
+        t->timeout->stop();
+    }
+
+    // tail of body which came together with finish
+    read_body(t.get());
+
+    auto call = t->call;
+    QNetworkReply* reply = t->reply;
+    if (call->resp.status_code == 0) {
+        call->resp.status_code = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    }
+
+    CURLcode code = CURLE_OK;
+    if (t->cancelled) {
+        call->resp.cancelled = true;
+        code = CURLE_ABORTED_BY_CALLBACK;
+    } else if (t->write_failed) {
+        code = CURLE_WRITE_ERROR;
+    } else if (t->timed_out) {
+        code = CURLE_OPERATION_TIMEDOUT;
+    } else if (is_transport_error(reply->error())) {
+        code = to_curl_code(reply->error());
+    }
+
+    if (code != CURLE_OK) {
+        call->resp.error_code = (int) code;
+        if (t->cancelled) {
+            call->resp.error_message = "Cancelled";
+        } else if (t->write_failed || t->timed_out) {
+            call->resp.error_message = curl_easy_strerror(code);
+        } else {
+            call->resp.error_message = reply->errorString().toStdString();
+        }
+    } else if (t->record) {
+        fixtures::get().record(call->req, call->resp, std::move(t->recorded));
+    }
+
+    reply->deleteLater();
+    t.reset();
+
+    if (call->on_done) {
+        call->on_done(call);
+    }
+}
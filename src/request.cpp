@@ -9,9 +9,7 @@
 
 #include "include/net/request.h"
 
-#include <iomanip>
-#include <toolbox/strings.hpp>
-#include <toolbox/strings/regex.h>
+#include <cstring>
 
 // REQUEST
 miledger::net::base_request::base_request()
@@ -70,25 +68,48 @@ miledger::net::base_request::base_request(const QString& url, miledger::net::bas
 }
 
 void miledger::net::base_request::parse_url(const QString& url) {
-    QString urlParseRegex =
-        R"(([a-zA-Z]+)\:\/\/([a-zA-Z0-9\.\-_]+)?\:?([0-9]{1,5})?(\/[a-zA-Z0-9\/\+\-\.\%\/_]*)?\??([a-zA-Z0-9\-_\+\=\&\%\.]*))";
-
-    if (!toolbox::strings::matches_pattern(urlParseRegex.toStdString(), url.toStdString())) {
+    // scheme://host[:port][/path][?query][#fragment]
+    const int scheme_end = url.indexOf(QLatin1String("://"));
+    if (scheme_end <= 0) {
         return;
     }
+    for (int i = 0; i < scheme_end; i++) {
+        const QChar c = url[i];
+        if (!(c.isLetter() && c.unicode() < 0x80)) {
+            return;
+        }
+    }
+
+    const int host_begin = scheme_end + 3;
+    int fragment_begin = url.indexOf('#', host_begin);
+    if (fragment_begin < 0) {
+        fragment_begin = url.length();
+    }
+    int query_begin = url.indexOf('?', host_begin);
+    if (query_begin < 0 || query_begin > fragment_begin) {
+        query_begin = fragment_begin;
+    }
+    int path_begin = url.indexOf('/', host_begin);
+    if (path_begin < 0 || path_begin > query_begin) {
+        path_begin = query_begin;
+    }
 
-    auto res = toolbox::strings::find_pattern(rxns::regex(urlParseRegex.toStdString()), url.toStdString());
+    QString authority = url.mid(host_begin, path_begin - host_begin);
+    QString port;
+    const int port_sep = authority.lastIndexOf(':');
+    if (port_sep >= 0) {
+        port = authority.mid(port_sep + 1);
+        authority.truncate(port_sep);
+    }
 
-    m_proto = QString::fromStdString(res[1]);
-    m_host = QString::fromStdString(res[2]);
-    QString port = QString::fromStdString(res[3]);
-    m_path = QString::fromStdString(res[4]);
-    QString paramsString = QString::fromStdString(res[5]);
+    m_proto = url.left(scheme_end);
+    m_host = authority;
+    m_path = url.mid(path_begin, query_begin - path_begin);
 
-    if (toolbox::strings::equals_icase(m_proto.toStdString(), "https")) {
+    if (m_proto.compare(QLatin1String("https"), Qt::CaseInsensitive) == 0) {
         m_port = "443";
         m_ssl = true;
-    } else if (toolbox::strings::equals_icase(m_proto.toStdString(), "ftp")) {
+    } else if (m_proto.compare(QLatin1String("ftp"), Qt::CaseInsensitive) == 0) {
         m_port = "20";
         m_ssl = false;
     }
@@ -97,40 +118,122 @@ void miledger::net::base_request::parse_url(const QString& url) {
         m_port = port;
     }
 
-    if (!paramsString.isEmpty()) {
-        auto kvs = toolbox::strings::split(paramsString.toStdString(), '&');
-        for (auto& item : kvs) {
-            auto kv = toolbox::strings::split_pair(item, '=');
-            m_params.push_back({QString::fromStdString(kv.first), QString::fromStdString(kv.second)});
-        }
+    if (query_begin + 1 < fragment_begin) {
+        parse_query(url.mid(query_begin + 1, fragment_begin - query_begin - 1));
     }
 }
 
 void miledger::net::base_request::parse_query(const QString& query_string) {
-    QString query = query_string;
-    if (query[0] == '?') {
-        query = query.chopped(1);
+    const std::string query = query_string.toStdString();
+    size_t pos = (!query.empty() && query[0] == '?') ? 1 : 0;
+
+    while (pos < query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        if (end > pos) {
+            const size_t eq = query.find('=', pos);
+            // stored decoded: get_url_string() encodes them back
+            if (eq == std::string::npos || eq > end) {
+                m_params.add(decode_percent(query.data() + pos, end - pos), std::string());
+            } else {
+                m_params.add(decode_percent(query.data() + pos, eq - pos), decode_percent(query.data() + eq + 1, end - eq - 1));
+            }
+        }
+        pos = end + 1;
+    }
+}
+
+void miledger::net::base_request::append_encoded(QString& out, const QString& value, const char* keep) {
+    static const char hex[] = "0123456789ABCDEF";
+    const auto append_byte = [&out](unsigned char b) {
+        out += '%';
+        out += QLatin1Char(hex[b >> 4]);
+        out += QLatin1Char(hex[b & 0x0F]);
+    };
+
+    for (int i = 0; i < value.length(); i++) {
+        const QChar c = value[i];
+        const ushort u = c.unicode();
+        if (u < 0x80) {
+            const bool unreserved = (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '-' || u == '.' || u == '_' || u == '~';
+            if (unreserved || (keep && u != 0 && std::strchr(keep, (char) u))) {
+                out += c;
+            } else {
+                append_byte((unsigned char) u);
+            }
+            continue;
+        }
+
+        // non-ascii: utf-8 bytes of the code point, surrogate pair is one code point
+        const int len = (c.isHighSurrogate() && i + 1 < value.length()) ? 2 : 1;
+        const QByteArray utf8 = value.mid(i, len).toUtf8();
+        for (char b : utf8) {
+            append_byte((unsigned char) b);
+        }
+        i += len - 1;
+    }
+}
+
+void miledger::net::base_request::append_encoded(std::string& out, const std::string& value, const char* keep) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (unsigned char u : value) {
+        const bool unreserved = (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '-' || u == '.' || u == '_' || u == '~';
+        if (unreserved || (keep && u != 0 && u < 0x80 && std::strchr(keep, (char) u))) {
+            out += (char) u;
+        } else {
+            out += '%';
+            out += hex[u >> 4];
+            out += hex[u & 0x0F];
+        }
     }
+}
 
-    std::vector<std::string> pairs = toolbox::strings::split(query.toStdString(), "&");
+std::string miledger::net::base_request::decode_percent(const char* data, size_t len) {
+    const auto hex_value = [](char c) -> int {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    };
 
-    for (const auto& param : pairs) {
-        auto res = toolbox::strings::split_pair(param, "=");
-        add_query(QPair<QString, QString>(
-            QString::fromStdString(res.first),
-            QString::fromStdString(res.second)));
+    std::string out;
+    out.reserve(len);
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '%' && i + 2 < len) {
+            const int hi = hex_value(data[i + 1]);
+            const int lo = hex_value(data[i + 2]);
+            if (hi >= 0 && lo >= 0) {
+                out += (char) ((hi << 4) | lo);
+                i += 2;
+                continue;
+            }
+        } else if (data[i] == '+') {
+            // form encoding of space
+            out += ' ';
+            continue;
+        }
+        out += data[i];
     }
+    return out;
 }
 
 miledger::net::base_request::method miledger::net::base_request::method_from_string(const QString& method_name) {
 
-    if (QString::compare(method_name, "POST", Qt::CaseInsensitive)) {
+    if (QString::compare(method_name, "POST", Qt::CaseInsensitive) == 0) {
         return miledger::net::base_request::method::post;
-    } else if (QString::compare(method_name, "PUT", Qt::CaseInsensitive)) {
+    } else if (QString::compare(method_name, "PUT", Qt::CaseInsensitive) == 0) {
         return method::put;
-    } else if (QString::compare(method_name, "DELETE", Qt::CaseInsensitive)) {
+    } else if (QString::compare(method_name, "DELETE", Qt::CaseInsensitive) == 0) {
         return method::delete_;
-    } else if (QString::compare(method_name, "HEAD", Qt::CaseInsensitive)) {
+    } else if (QString::compare(method_name, "HEAD", Qt::CaseInsensitive) == 0) {
         return method::head;
     }
 
@@ -169,7 +272,7 @@ void miledger::net::base_request::set_method(miledger::net::base_request::method
 }
 
 void miledger::net::base_request::add_query(miledger::net::kv&& keyValue) {
-    m_params.push_back(std::move(keyValue));
+    m_params.add(keyValue.first.toStdString(), keyValue.second.toStdString());
 }
 
 void miledger::net::base_request::add_query(kvd&& keyValue) {
@@ -193,25 +296,34 @@ void miledger::net::base_request::use_ssl(bool use) {
 }
 
 QString miledger::net::base_request::get_url_string() const {
-    std::stringstream ss;
+    return QString::fromStdString(get_url_utf8());
+}
 
-    ss << m_proto.toStdString() << "://";
-    ss << m_host.toStdString();
-    if (m_port != "80" && m_port != "443") {
-        ss << ":" << m_port.toStdString();
-    }
+std::string miledger::net::base_request::get_url_utf8() const {
+    const bool default_port = m_port == QLatin1String("80") || m_port == QLatin1String("443");
+    const QByteArray proto = m_proto.toUtf8();
+    const QByteArray host = m_host.toUtf8();
+    const QByteArray path = m_path.isEmpty() ? QByteArray("/") : m_path.toUtf8();
 
-    if (!m_path.isEmpty()) {
-        ss << m_path.toStdString();
-    } else {
-        ss << "/";
+    size_t size = (size_t) (proto.size() + host.size() + path.size()) + 10;
+    for (const auto& p : m_params) {
+        size += p.key.size() + p.value.size() + 2;
     }
 
-    if (has_query()) {
-        ss << get_query_string().toStdString();
+    // one buffer for the whole url: query is already UTF-8, only encoded on append
+    std::string out;
+    out.reserve(size);
+    out.append(proto.constData(), (size_t) proto.size());
+    out += "://";
+    out.append(host.constData(), (size_t) host.size());
+    if (!default_port) {
+        out += ':';
+        out += m_port.toStdString();
     }
+    out.append(path.constData(), (size_t) path.size());
 
-    return QString::fromStdString(ss.str());
+    append_query(out);
+    return out;
 }
 
 QUrl miledger::net::base_request::get_url() const {
@@ -231,27 +343,12 @@ bool miledger::net::base_request::has_query() const {
 }
 
 bool miledger::net::base_request::has_query(const QString& key, bool icase) const {
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-
-    for (const auto& param : m_params) {
-        if (cmp(param.first, key)) {
-            return true;
-        }
-    }
-
-    return false;
+    return m_params.find(key.toStdString(), icase) != nullptr;
 }
 
 QString miledger::net::base_request::get_query_value(const QString& key, bool icase) const {
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-    for (const auto& param : m_params) {
-        if (cmp(param.first, key)) {
-            return param.second;
-        }
+    if (const auto* p = m_params.find(key.toStdString(), icase)) {
+        return QString::fromStdString(p->value);
     }
 
     return QString();
@@ -259,28 +356,15 @@ QString miledger::net::base_request::get_query_value(const QString& key, bool ic
 
 optns::optional<miledger::net::kv> miledger::net::base_request::find_query(const QString& key, bool icase) const {
     optns::optional<miledger::net::kv> out;
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-    for (const auto& param : m_params) {
-        if (cmp(param.first, key)) {
-            out = param;
-            break;
-        }
+    if (const auto* p = m_params.find(key.toStdString(), icase)) {
+        out = miledger::net::kv(QString::fromStdString(p->key), QString::fromStdString(p->value));
     }
 
     return out;
 }
 
 void miledger::net::base_request::set_query(const QString& key, const QString& value, bool icase) {
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-    for (auto& param : m_params) {
-        if (cmp(param.first, key)) {
-            param.second = value;
-        }
-    }
+    m_params.replace(key.toStdString(), value.toStdString(), icase);
 }
 
 void miledger::net::base_request::set_query(const miledger::net::kv& kv, bool icase) {
@@ -288,49 +372,11 @@ void miledger::net::base_request::set_query(const miledger::net::kv& kv, bool ic
 }
 
 bool miledger::net::base_request::remove_query_array(const QString& key, size_t index, bool icase) {
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-
-    size_t foundCount = 0;
-    size_t erasedItems = 0;
-
-    auto it = m_params.begin();
-    while (it != m_params.end()) {
-        if (cmp(it->first, key)) {
-            if (foundCount == index) {
-                it = m_params.erase(it);
-                erasedItems++;
-            } else {
-                ++it;
-            }
-            foundCount++;
-        } else {
-            ++it;
-        }
-    }
-
-    return erasedItems > 0;
+    return m_params.remove_nth(key.toStdString(), index, icase);
 }
 
 bool miledger::net::base_request::remove_query(const QString& key, bool icase) {
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-
-    int foundCount = 0;
-
-    auto it = m_params.begin();
-    while (it != m_params.end()) {
-        if (cmp(it->first, key)) {
-            it = m_params.erase(it);
-            foundCount++;
-        } else {
-            ++it;
-        }
-    }
-
-    return foundCount > 0;
+    return m_params.remove(key.toStdString(), icase) > 0;
 }
 
 void miledger::net::base_request::clear_queries() {
@@ -344,13 +390,11 @@ size_t miledger::net::base_request::queries_size() const {
 std::vector<QString> miledger::net::base_request::get_query_array(const QString& key, bool icase) const {
     std::vector<QString> out;
 
-    const auto& cmp = [icase](const QString& lhs, const QString& rhs) {
-        return QString::compare(lhs, rhs, icase ? Qt::CaseInsensitive : Qt::CaseSensitive) == 0;
-    };
-
+    const std::string k = key.toStdString();
+    const std::string folded = miledger::net::kv_store::fold(k);
     for (const auto& param : m_params) {
-        if (cmp(param.first, key)) {
-            out.push_back(param.second);
+        if (icase ? param.folded == folded : param.key == k) {
+            out.push_back(QString::fromStdString(param.value));
         }
     }
 
@@ -358,24 +402,28 @@ std::vector<QString> miledger::net::base_request::get_query_array(const QString&
 }
 
 QString miledger::net::base_request::get_query_string() const {
-    std::string combined;
-    if (!m_params.empty()) {
-        std::stringstream ss;
-        std::vector<std::string> enc;
-        for (auto& p : m_params) {
-            ss << p.first.toStdString() << "=" << p.second.toStdString();
-            enc.push_back(ss.str());
-            ss.str("");
-            ss.clear();
-        }
-        std::string glued = toolbox::strings::glue("&", enc);
-        combined += "?" + glued;
+    std::string out;
+    append_query(out);
+    return QString::fromStdString(out);
+}
+
+void miledger::net::base_request::append_query(std::string& out) const {
+    char sep = '?';
+    for (const auto& p : m_params) {
+        out += sep;
+        // array keys like addresses[] are kept readable
+        append_encoded(out, p.key, "[]");
+        out += '=';
+        append_encoded(out, p.value);
+        sep = '&';
     }
+}
 
-    return QString::fromStdString(combined);
+void miledger::net::base_request::reserve_query(size_t size) {
+    m_params.reserve(size);
 }
 
-const miledger::net::kv_vector& miledger::net::base_request::get_query_list() const {
+const miledger::net::kv_store& miledger::net::base_request::get_query_list() const {
     return m_params;
 }
 
@@ -461,11 +509,19 @@ bool miledger::net::base_request::is_ssl() const {
     return m_ssl;
 }
 
+void miledger::net::base_request::set_endpoint(const QString& endpoint) {
+    m_endpoint = endpoint;
+}
+
+const QString& miledger::net::base_request::get_endpoint() const {
+    return m_endpoint;
+}
+
 QNetworkRequest miledger::net::request::to_qt_request() const {
     QNetworkRequest req;
     req.setUrl(get_url());
     for (const auto& h : m_headers) {
-        req.setRawHeader(h.first.toUtf8(), h.second.toUtf8());
+        req.setRawHeader(QByteArray::fromStdString(h.key), QByteArray::fromStdString(h.value));
     }
     return req;
 }
@@ -0,0 +1,224 @@
+/*!
+ * miledger.
+ * response_cache.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/response_cache.h"
+
+#include "include/settings.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+miledger::net::response_cache::response_cache() {
+    // setting is in KiB
+    m_budget = (size_t) Settings::get().getUint16(Settings::KEY_NET_CACHE_SIZE, 16384) * 1024;
+}
+
+miledger::net::response_cache::entry_ptr miledger::net::response_cache::find(const std::string& url) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto it = m_entries.find(url);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    return it->second.value;
+}
+
+void miledger::net::response_cache::add_validators(miledger::net::request& req, const entry& cached) {
+    if (!cached.etag.empty()) {
+        req.add_header("If-None-Match", QString::fromStdString(cached.etag));
+    }
+    if (!cached.last_modified.empty()) {
+        req.add_header("If-Modified-Since", QString::fromStdString(cached.last_modified));
+    }
+}
+
+bool miledger::net::response_cache::is_cacheable(const miledger::net::response& resp) {
+    std::string cc = resp.get_header("cache-control");
+    std::transform(cc.begin(), cc.end(), cc.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+    if (cc.find("no-store") != std::string::npos) {
+        return false;
+    }
+
+    return !resp.get_header("etag").empty() || !resp.get_header("last-modified").empty() || parse_max_age(resp).count() > 0;
+}
+
+void miledger::net::response_cache::store(const std::string& url, const miledger::net::response& resp, std::string&& body) {
+    if (!is_cacheable(resp)) {
+        return;
+    }
+
+    auto value = std::make_shared<entry>();
+    value->body = std::make_shared<const std::string>(std::move(body));
+    value->etag = resp.get_header("etag");
+    value->last_modified = resp.get_header("last-modified");
+    value->stored = clock_t::now();
+    value->max_age = parse_max_age(resp);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    put(url, std::move(value));
+}
+
+miledger::net::response_cache::entry_ptr miledger::net::response_cache::revalidate(
+    const std::string& url,
+    const entry_ptr& cached,
+    const miledger::net::response& resp) {
+
+    // 304 may carry updated validators and freshness, body stays the same
+    auto value = std::make_shared<entry>(*cached);
+    value->stored = clock_t::now();
+    if (!resp.get_header("cache-control").empty()) {
+        value->max_age = parse_max_age(resp);
+    }
+    std::string etag = resp.get_header("etag");
+    if (!etag.empty()) {
+        value->etag = std::move(etag);
+    }
+    std::string last_modified = resp.get_header("last-modified");
+    if (!last_modified.empty()) {
+        value->last_modified = std::move(last_modified);
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.revalidated++;
+    m_stats.bytes_saved += value->body->size();
+    put(url, value);
+    return value;
+}
+
+void miledger::net::response_cache::hit(const entry_ptr& cached) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.fresh_hits++;
+    m_stats.bytes_saved += cached->body->size();
+}
+
+void miledger::net::response_cache::miss() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_stats.misses++;
+}
+
+void miledger::net::response_cache::set_budget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_budget = bytes;
+    evict();
+}
+
+size_t miledger::net::response_cache::get_budget() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_budget;
+}
+
+size_t miledger::net::response_cache::get_size() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_size;
+}
+
+miledger::net::response_cache::stats miledger::net::response_cache::get_stats() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_stats;
+}
+
+void miledger::net::response_cache::clear() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+}
+
+size_t miledger::net::response_cache::cost_of(const std::string& url, const entry& e) {
+    // approximate bookkeeping overhead of map node, list node and entry
+    constexpr size_t overhead = 128;
+    return overhead + url.size() * 2 + e.body->size() + e.etag.size() + e.last_modified.size();
+}
+
+std::chrono::seconds miledger::net::response_cache::parse_max_age(const miledger::net::response& resp) {
+    std::string cc = resp.get_header("cache-control");
+    std::transform(cc.begin(), cc.end(), cc.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+    if (cc.find("no-cache") != std::string::npos) {
+        return std::chrono::seconds(0);
+    }
+
+    const std::string name = "max-age=";
+    auto pos = cc.find(name);
+    if (pos == std::string::npos) {
+        return std::chrono::seconds(0);
+    }
+
+    long long val = 0;
+    for (pos += name.size(); pos < cc.size() && std::isdigit((unsigned char) cc[pos]); ++pos) {
+        val = val * 10 + (cc[pos] - '0');
+        if (val > 31536000) {
+            break;
+        }
+    }
+    return std::chrono::seconds(val);
+}
+
+void miledger::net::response_cache::put(const std::string& url, entry_ptr value) {
+    const size_t cost = cost_of(url, *value);
+
+    auto it = m_entries.find(url);
+    if (it != m_entries.end()) {
+        m_size -= it->second.cost;
+        m_lru.erase(it->second.lru);
+        m_entries.erase(it);
+    }
+
+    if (cost > m_budget) {
+        return;
+    }
+
+    m_lru.push_front(url);
+    m_entries[url] = node{std::move(value), cost, m_lru.begin()};
+    m_size += cost;
+    evict();
+}
+
+void miledger::net::response_cache::evict() {
+    while (m_size > m_budget && !m_lru.empty()) {
+        auto it = m_entries.find(m_lru.back());
+        m_size -= it->second.cost;
+        m_entries.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+miledger::net::cache_sink::cache_sink(std::shared_ptr<response_sink> inner, const miledger::net::response* resp, size_t limit)
+    : m_inner(std::move(inner))
+    , m_resp(resp)
+    , m_limit(limit) {
+}
+
+bool miledger::net::cache_sink::write(const char* data, size_t len) {
+    if (!m_checked) {
+        m_checked = true;
+        m_keep = m_resp->status_code == 200 && response_cache::is_cacheable(*m_resp);
+        if (m_keep) {
+            std::string content_length = m_resp->get_header("content-length");
+            size_t expected = content_length.empty() ? 0 : (size_t) std::strtoull(content_length.c_str(), nullptr, 10);
+            if (expected > m_limit) {
+                m_keep = false;
+            } else if (expected > 0) {
+                m_data.reserve(expected);
+            }
+        }
+    }
+
+    if (m_keep) {
+        if (m_data.size() + len > m_limit) {
+            m_keep = false;
+            std::string().swap(m_data);
+        } else {
+            m_data.append(data, len);
+        }
+    }
+
+    return m_inner->write(data, len);
+}
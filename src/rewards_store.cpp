@@ -0,0 +1,295 @@
+/*!
+ * miledger.
+ * rewards_store.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/rewards_store.h"
+
+#include "include/net/api_store.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <QTimeZone>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+const char store_magic[8] = {'M', 'L', 'R', 'W', 0, 0, 0, 1};
+constexpr int64_t minute_size = 60;
+constexpr int64_t hour_size = 60 * minute_size;
+constexpr int64_t day_size = 24 * hour_size;
+
+int64_t floor_to(int64_t time, int64_t size) {
+    const int64_t rem = time % size;
+    return rem < 0 ? time - rem - size : time - rem;
+}
+} // namespace
+
+miledger::repo::rewards_store::rewards_store(miledger::repo::explorer_repo& repo, const minter::address_t& address, const std::string& dir)
+    : m_repo(repo)
+    , m_address(address) {
+    const QString base = QString::fromStdString(dir);
+    QDir().mkpath(base);
+    m_file.setFileName(QDir::toNativeSeparators(base + "/" + QString::fromStdString(address.to_string()) + ".rewards"));
+}
+
+miledger::repo::rewards_store::~rewards_store() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_file.close();
+}
+
+bool miledger::repo::rewards_store::open() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_file.close();
+    m_minutes.clear();
+    m_hours.clear();
+    m_days.clear();
+    m_records = 0;
+
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qDebug() << "Unable to open rewards store" << m_file.fileName() << ":" << m_file.errorString();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    uchar* data = size > 0 ? m_file.map(0, size) : nullptr;
+    if (!data || size < (qint64) sizeof(store_magic) || std::memcmp(data, store_magic, sizeof(store_magic)) != 0) {
+        // new or unknown file
+        if (data) {
+            m_file.unmap(data);
+        }
+        m_file.resize(0);
+        m_file.seek(0);
+        m_file.write(store_magic, sizeof(store_magic));
+        m_file.flush();
+        return true;
+    }
+
+    uint64_t pos = sizeof(store_magic);
+    while (pos + sizeof(record_header) <= (uint64_t) size) {
+        record_header hdr;
+        std::memcpy(&hdr, data + pos, sizeof(hdr));
+        const uint64_t end = pos + sizeof(hdr) + hdr.length;
+        if (end > (uint64_t) size) {
+            break;
+        }
+        const char* body = (const char*) data + pos + sizeof(hdr);
+        if (miledger::net::api_store::hash(body, hdr.length) != hdr.checksum) {
+            // torn write: everything after it is unreliable
+            break;
+        }
+        ingest(hdr.time, dev::bigdec18(std::string(body, hdr.length)));
+        m_records++;
+        pos = end;
+    }
+    m_file.unmap(data);
+
+    if (pos < (uint64_t) size) {
+        m_file.resize((qint64) pos);
+    }
+    if (m_records > m_minutes.size() * 2) {
+        compact();
+    }
+    return true;
+}
+
+rxcpp::observable<size_t> miledger::repo::rewards_store::sync() {
+    return rxcpp::observable<>::defer([this]() {
+               std::string start_time;
+               {
+                   std::lock_guard<std::mutex> lock(m_lock);
+                   if (!m_minutes.empty()) {
+                       // last stored minute may have been incomplete, so it's fetched again
+                       start_time = format_time(m_minutes.rbegin()->first);
+                   }
+               }
+               return m_repo.get_rewards_json(m_address, explorer_repo::minute, start_time)
+                   .map([this](const nlohmann::json& answer) {
+                       if (answer.contains("error") && answer.at("error").is_object()) {
+                           throw std::runtime_error(answer.at("error").value("message", std::string("Unknown explorer error")));
+                       }
+                       std::lock_guard<std::mutex> lock(m_lock);
+                       return append_page(answer);
+                   });
+           })
+        .as_dynamic();
+}
+
+std::vector<miledger::repo::rewards_store::point>
+miledger::repo::rewards_store::query(int64_t from, int64_t to, explorer_repo::reward_period scale, size_t limit) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<point> out;
+    const auto& series = series_of(scale);
+    for (auto it = series.lower_bound(from); it != series.end() && it->first <= to && (limit == 0 || out.size() < limit); ++it) {
+        out.push_back(point{it->first, it->second});
+    }
+    return out;
+}
+
+dev::bigdec18 miledger::repo::rewards_store::total(int64_t from, int64_t to) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    dev::bigdec18 out("0");
+    auto add = [&out](const series_t& series, int64_t time) {
+        auto it = series.find(time);
+        if (it != series.end()) {
+            out += it->second;
+        }
+    };
+
+    // minutes up to the first whole hour, hours up to the first whole day, then days and back down
+    int64_t time = floor_to(from, minute_size);
+    if (time < from) {
+        time += minute_size;
+    }
+    while (time <= to) {
+        if (time % day_size == 0 && time + day_size - 1 <= to) {
+            add(m_days, time);
+            time += day_size;
+        } else if (time % hour_size == 0 && time + hour_size - 1 <= to) {
+            add(m_hours, time);
+            time += hour_size;
+        } else {
+            add(m_minutes, time);
+            time += minute_size;
+        }
+    }
+    return out;
+}
+
+const minter::address_t& miledger::repo::rewards_store::address() const {
+    return m_address;
+}
+
+int64_t miledger::repo::rewards_store::last_time() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_minutes.empty() ? 0 : m_minutes.rbegin()->first;
+}
+
+int64_t miledger::repo::rewards_store::parse_time(const std::string& value) {
+    QString str = QString::fromStdString(value).trimmed();
+    // "2021-05-14 10:00:00+00" -> "2021-05-14T10:00:00+00:00"
+    if (str.size() > 10 && str[10] == ' ') {
+        str[10] = 'T';
+    }
+    if (str.size() > 3 && (str[str.size() - 3] == '+' || str[str.size() - 3] == '-') && str.indexOf('T') > 0 && str.indexOf('T') < str.size() - 3) {
+        str += ":00";
+    }
+    QDateTime time = QDateTime::fromString(str, Qt::ISODate);
+    if (!time.isValid()) {
+        return -1;
+    }
+    if (time.timeSpec() == Qt::LocalTime) {
+        // explorer times without offset are UTC
+        time.setTimeZone(QTimeZone::utc());
+    }
+    return time.toSecsSinceEpoch();
+}
+
+std::string miledger::repo::rewards_store::format_time(int64_t time) {
+    return QDateTime::fromSecsSinceEpoch(time, QTimeZone::utc()).toString("yyyy-MM-dd HH:mm:ss").toStdString();
+}
+
+void miledger::repo::rewards_store::ingest(int64_t time, const dev::bigdec18& amount) {
+    const int64_t minute = floor_to(time, minute_size);
+    dev::bigdec18 diff = amount;
+    auto it = m_minutes.find(minute);
+    if (it != m_minutes.end()) {
+        diff -= it->second;
+        it->second = amount;
+    } else {
+        m_minutes.emplace(minute, amount);
+    }
+
+    auto hour = m_hours.emplace(floor_to(minute, hour_size), dev::bigdec18("0")).first;
+    hour->second += diff;
+    auto day = m_days.emplace(floor_to(minute, day_size), dev::bigdec18("0")).first;
+    day->second += diff;
+}
+
+size_t miledger::repo::rewards_store::append_page(const nlohmann::json& answer) {
+    if (!answer.contains("data") || !answer.at("data").is_array()) {
+        return 0;
+    }
+
+    size_t added = 0;
+    m_file.seek(m_file.size());
+    for (const auto& item : answer.at("data")) {
+        const int64_t time = parse_time(item.value("time", std::string()));
+        if (time < 0) {
+            continue;
+        }
+        const std::string amount = item.value("amount", std::string("0"));
+        const int64_t minute = floor_to(time, minute_size);
+
+        auto it = m_minutes.find(minute);
+        if (it != m_minutes.end() && it->second == dev::bigdec18(amount)) {
+            continue;
+        }
+        if (!write_record(minute, amount)) {
+            throw std::runtime_error("Unable to write rewards store: " + m_file.errorString().toStdString());
+        }
+        ingest(minute, dev::bigdec18(amount));
+        added++;
+    }
+    m_file.flush();
+    return added;
+}
+
+bool miledger::repo::rewards_store::write_record(int64_t time, const std::string& amount) {
+    record_header hdr;
+    hdr.time = time;
+    hdr.length = (uint32_t) amount.size();
+    hdr.reserved = 0;
+    hdr.checksum = miledger::net::api_store::hash(amount.data(), amount.size());
+    if (m_file.write((const char*) &hdr, sizeof(hdr)) != sizeof(hdr)
+        || m_file.write(amount.data(), (qint64) amount.size()) != (qint64) amount.size()) {
+        return false;
+    }
+    m_records++;
+    return true;
+}
+
+bool miledger::repo::rewards_store::compact() {
+    QSaveFile out(m_file.fileName());
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    out.write(store_magic, sizeof(store_magic));
+    for (const auto& item : m_minutes) {
+        const std::string amount = minter::utils::to_string(item.second);
+        record_header hdr;
+        hdr.time = item.first;
+        hdr.length = (uint32_t) amount.size();
+        hdr.reserved = 0;
+        hdr.checksum = miledger::net::api_store::hash(amount.data(), amount.size());
+        out.write((const char*) &hdr, sizeof(hdr));
+        out.write(amount.data(), (qint64) amount.size());
+    }
+
+    // opened file can't be replaced on some platforms
+    m_file.close();
+    const bool ok = out.commit();
+    m_file.open(QIODevice::ReadWrite);
+    if (ok) {
+        m_records = m_minutes.size();
+    }
+    return ok;
+}
+
+const miledger::repo::rewards_store::series_t& miledger::repo::rewards_store::series_of(explorer_repo::reward_period scale) const {
+    switch (scale) {
+    case explorer_repo::minute:
+        return m_minutes;
+    case explorer_repo::hour:
+        return m_hours;
+    default:
+        return m_days;
+    }
+}
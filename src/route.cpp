@@ -0,0 +1,119 @@
+/*!
+ * miledger.
+ * route.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/route.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+
+miledger::net::route::route(QString name, const QString& path_template, std::initializer_list<QString> query_keys)
+    : m_name(std::move(name))
+    , m_query_keys(query_keys) {
+
+    QString tpl = path_template;
+    // relative to base path, which always ends with slash
+    while (tpl.startsWith('/')) {
+        tpl.remove(0, 1);
+    }
+
+    int pos = 0;
+    while (true) {
+        const int open = tpl.indexOf('{', pos);
+        const int close = open < 0 ? -1 : tpl.indexOf('}', open);
+        if (open < 0 || close < 0) {
+            m_literals.push_back(tpl.mid(pos));
+            break;
+        }
+        m_literals.push_back(tpl.mid(pos, open - pos));
+        m_params.push_back(tpl.mid(open + 1, close - open - 1));
+        pos = close + 1;
+    }
+
+    for (const auto& lit : m_literals) {
+        m_literals_size += lit.length();
+    }
+}
+
+void miledger::net::route::apply(miledger::net::base_request& req, std::initializer_list<QString> args) const {
+    req.set_path(render_path(req.get_path(), args));
+    if (!m_query_keys.empty()) {
+        req.reserve_query(m_query_keys.size());
+    }
+}
+
+QString miledger::net::route::render_path(const QString& base_path, std::initializer_list<QString> args) const {
+    Q_ASSERT(args.size() == m_params.size());
+
+    int size = base_path.length() + m_literals_size + 1;
+    for (const auto& arg : args) {
+        // the most of args are ascii: hashes, addresses, ids
+        size += arg.length();
+    }
+
+    QString out;
+    out.reserve(size);
+    out += base_path;
+    if (!out.endsWith('/')) {
+        out += '/';
+    }
+
+    auto arg = args.begin();
+    for (size_t i = 0; i < m_literals.size(); i++) {
+        out += m_literals[i];
+        if (i < m_params.size() && arg != args.end()) {
+            miledger::net::base_request::append_encoded(out, *arg);
+            ++arg;
+        }
+    }
+    return out;
+}
+
+std::string miledger::net::route::benchmark(size_t iterations) {
+    using clock_type = std::chrono::steady_clock;
+    const QString base_url = "https://explorer-api.minter.network/api/v2/";
+    const QString address = "Mx7633980c000139dd3bd24a3f54e06474fa941e16";
+    const route compiled("get_transactions", "addresses/{address}/transactions", {"page", "limit"});
+
+    // sum of lengths keeps compiler from dropping the work
+    size_t sink = 0;
+
+    auto begin = clock_type::now();
+    for (size_t i = 0; i < iterations; i++) {
+        miledger::net::request req(base_url);
+        req.add_path("addresses");
+        req.add_path(address);
+        req.add_path("transactions");
+        req.add_query(miledger::net::kvd{"page", i});
+        req.add_query(miledger::net::kvd{"limit", 50});
+        sink += req.get_url_utf8().size();
+    }
+    const auto legacy = clock_type::now() - begin;
+
+    const miledger::net::request proto(base_url);
+    begin = clock_type::now();
+    for (size_t i = 0; i < iterations; i++) {
+        miledger::net::request req = proto;
+        compiled.apply(req, {address});
+        req.add_query(miledger::net::kvd{"page", i});
+        req.add_query(miledger::net::kvd{"limit", 50});
+        sink += req.get_url_utf8().size();
+    }
+    const auto routed = clock_type::now() - begin;
+
+    const auto per_request = [iterations](clock_type::duration d) {
+        return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / (double) std::max<size_t>(1, iterations);
+    };
+
+    return fmt::format(
+        "url building, {} requests (checksum {}):\n"
+        "  parse base url + add_path: {:>10.0f} ns/request\n"
+        "  compiled route:            {:>10.0f} ns/request\n",
+        iterations, sink, per_request(legacy), per_request(routed));
+}
@@ -0,0 +1,226 @@
+/*!
+ * miledger.
+ * search_index.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/search_index.h"
+
+#include <algorithm>
+
+namespace {
+// matches less similar than this are noise, unless query is exact or prefix of field
+constexpr double MIN_SIMILARITY = 0.2;
+constexpr double EXACT_BONUS = 1.0;
+constexpr double PREFIX_BONUS = 0.5;
+// subtitle match is worth less than the same title match
+constexpr double FIELD_WEIGHT[] = {1.0, 0.8};
+} // namespace
+
+void miledger::SearchIndex::upsert(Kind kind, const std::string& key, const QString& title, const QString& subtitle) {
+    std::lock_guard<std::mutex> lock(mLock);
+    const std::string dk = docKey(kind, key);
+    auto it = mKeys.find(dk);
+    uint32_t id;
+    if (it != mKeys.end()) {
+        id = it->second;
+        if (mDocs[id].title == title && mDocs[id].subtitle == subtitle) {
+            return;
+        }
+        unindex(id);
+    } else if (!mFree.empty()) {
+        id = mFree.back();
+        mFree.pop_back();
+        mKeys.emplace(dk, id);
+    } else {
+        id = (uint32_t) mDocs.size();
+        mDocs.emplace_back();
+        mKeys.emplace(dk, id);
+    }
+
+    Doc& doc = mDocs[id];
+    doc.kind = kind;
+    doc.key = key;
+    doc.title = title;
+    doc.subtitle = subtitle;
+    doc.folded[Title] = title.toCaseFolded();
+    doc.folded[Subtitle] = subtitle.toCaseFolded();
+    doc.alive = true;
+    index(id);
+}
+
+void miledger::SearchIndex::remove(Kind kind, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mLock);
+    removeLocked(kind, key);
+}
+
+void miledger::SearchIndex::retain(Kind kind, const std::unordered_set<std::string>& keep) {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::vector<std::string> removed;
+    for (const auto& doc : mDocs) {
+        if (doc.alive && doc.kind == kind && !keep.count(doc.key)) {
+            removed.push_back(doc.key);
+        }
+    }
+    for (const auto& key : removed) {
+        removeLocked(kind, key);
+    }
+}
+
+std::vector<miledger::SearchIndex::Match> miledger::SearchIndex::search(const QString& query, size_t limit) const {
+    const QString folded = query.trimmed().toCaseFolded();
+    const std::vector<gram_t> queryGrams = makeGrams(folded);
+    if (queryGrams.empty() || limit == 0) {
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    // posting -> count of shared trigrams
+    std::unordered_map<uint32_t, uint32_t> shared;
+    for (gram_t gram : queryGrams) {
+        auto it = mPostings.find(gram);
+        if (it == mPostings.end()) {
+            continue;
+        }
+        for (uint32_t posting : it->second) {
+            shared[posting]++;
+        }
+    }
+
+    // doc id -> best score of it's fields
+    std::unordered_map<uint32_t, double> scores;
+    for (const auto& hit : shared) {
+        const uint32_t id = hit.first >> 1;
+        const uint32_t field = hit.first & 1;
+        const Doc& doc = mDocs[id];
+
+        const double total = (double) (queryGrams.size() + doc.grams[field].size() - hit.second);
+        const double similarity = (double) hit.second / total;
+        double bonus = 0;
+        if (doc.folded[field] == folded) {
+            bonus = EXACT_BONUS;
+        } else if (doc.folded[field].startsWith(folded)) {
+            bonus = PREFIX_BONUS;
+        }
+        if (similarity < MIN_SIMILARITY && bonus == 0) {
+            continue;
+        }
+
+        const double score = (similarity + bonus) * FIELD_WEIGHT[field];
+        auto& best = scores[id];
+        best = std::max(best, score);
+    }
+
+    std::vector<Match> out;
+    out.reserve(scores.size());
+    for (const auto& item : scores) {
+        const Doc& doc = mDocs[item.first];
+        out.push_back(Match{doc.kind, doc.key, doc.title, doc.subtitle, item.second});
+    }
+
+    auto cmp = [](const Match& left, const Match& right) {
+        if (left.score != right.score) {
+            return left.score > right.score;
+        }
+        // "BTC" before "BTCX" with the same similarity
+        if (left.title.size() != right.title.size()) {
+            return left.title.size() < right.title.size();
+        }
+        return left.title < right.title;
+    };
+    if (out.size() > limit) {
+        std::partial_sort(out.begin(), out.begin() + limit, out.end(), cmp);
+        out.resize(limit);
+    } else {
+        std::sort(out.begin(), out.end(), cmp);
+    }
+    return out;
+}
+
+size_t miledger::SearchIndex::size() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mKeys.size();
+}
+
+std::string miledger::SearchIndex::kindToString(Kind kind) {
+    switch (kind) {
+    case Kind::Coin:
+        return "coin";
+    case Kind::Validator:
+        return "validator";
+    case Kind::Pool:
+        return "pool";
+    }
+    return "unknown";
+}
+
+std::vector<miledger::SearchIndex::gram_t> miledger::SearchIndex::makeGrams(const QString& folded) {
+    std::vector<gram_t> out;
+    const auto words = folded.split(' ', Qt::SkipEmptyParts);
+    for (const auto& word : words) {
+        // two spaces before word and one after: word start weighs more than it's end, short words still have trigrams
+        const QString padded = QString("  %1 ").arg(word);
+        for (int i = 0; i + 2 < padded.size(); i++) {
+            out.push_back(((gram_t) padded.at(i).unicode() << 32)
+                          | ((gram_t) padded.at(i + 1).unicode() << 16)
+                          | (gram_t) padded.at(i + 2).unicode());
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+std::string miledger::SearchIndex::docKey(Kind kind, const std::string& key) {
+    return std::to_string((int) kind) + ":" + key;
+}
+
+void miledger::SearchIndex::index(uint32_t id) {
+    Doc& doc = mDocs[id];
+    for (uint32_t field = 0; field < FieldsCount; field++) {
+        doc.grams[field] = makeGrams(doc.folded[field]);
+        for (gram_t gram : doc.grams[field]) {
+            mPostings[gram].push_back(id << 1 | field);
+        }
+    }
+}
+
+void miledger::SearchIndex::unindex(uint32_t id) {
+    Doc& doc = mDocs[id];
+    for (uint32_t field = 0; field < FieldsCount; field++) {
+        const uint32_t posting = id << 1 | field;
+        for (gram_t gram : doc.grams[field]) {
+            auto it = mPostings.find(gram);
+            if (it == mPostings.end()) {
+                continue;
+            }
+            auto& list = it->second;
+            auto pos = std::find(list.begin(), list.end(), posting);
+            if (pos != list.end()) {
+                // order of postings doesn't matter
+                *pos = list.back();
+                list.pop_back();
+            }
+            if (list.empty()) {
+                mPostings.erase(it);
+            }
+        }
+        doc.grams[field].clear();
+    }
+}
+
+void miledger::SearchIndex::removeLocked(Kind kind, const std::string& key) {
+    auto it = mKeys.find(docKey(kind, key));
+    if (it == mKeys.end()) {
+        return;
+    }
+    const uint32_t id = it->second;
+    unindex(id);
+    mDocs[id] = Doc();
+    mFree.push_back(id);
+    mKeys.erase(it);
+}
@@ -0,0 +1,159 @@
+/*!
+ * miledger.
+ * session_pool.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/session_pool.h"
+
+#include "include/settings.h"
+
+miledger::net::session_pool::lease::lease(session_pool* pool, std::string key, std::unique_ptr<cpr::Session> session)
+    : m_pool(pool)
+    , m_key(std::move(key))
+    , m_session(std::move(session)) {
+}
+
+miledger::net::session_pool::lease::lease(lease&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_key(std::move(other.m_key))
+    , m_session(std::move(other.m_session)) {
+    other.m_pool = nullptr;
+}
+
+miledger::net::session_pool::lease& miledger::net::session_pool::lease::operator=(lease&& other) noexcept {
+    if (this != &other) {
+        if (m_pool && m_session) {
+            m_pool->release(m_key, std::move(m_session));
+        }
+        m_pool = other.m_pool;
+        m_key = std::move(other.m_key);
+        m_session = std::move(other.m_session);
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+miledger::net::session_pool::lease::~lease() {
+    if (m_pool && m_session) {
+        m_pool->release(m_key, std::move(m_session));
+    }
+}
+
+void miledger::net::session_pool::lease::discard() {
+    m_pool = nullptr;
+}
+
+miledger::net::session_pool::session_pool() {
+    m_opts.max_per_host = Settings::get().getUint16(Settings::KEY_NET_POOL_SIZE, (uint16_t) m_opts.max_per_host);
+    m_opts.idle_timeout = std::chrono::seconds(
+        Settings::get().getUint16(Settings::KEY_NET_POOL_IDLE_TIMEOUT, (uint16_t) m_opts.idle_timeout.count()));
+}
+
+std::string miledger::net::session_pool::key_for(const miledger::net::base_request& req) {
+    std::string key;
+    key.reserve(64);
+    key += req.get_proto_name().toLower().toStdString();
+    key += "://";
+    key += req.get_host().toLower().toStdString();
+    key += ":";
+    key += req.get_port_str().toStdString();
+    return key;
+}
+
+void miledger::net::session_pool::set_options(const options& opts) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_opts = opts;
+    evict_expired(clock_t::now());
+}
+
+miledger::net::session_pool::options miledger::net::session_pool::get_options() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_opts;
+}
+
+miledger::net::session_pool::lease miledger::net::session_pool::acquire(const miledger::net::base_request& req) {
+    return acquire(key_for(req));
+}
+
+miledger::net::session_pool::lease miledger::net::session_pool::acquire(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        evict_expired(clock_t::now());
+
+        auto it = m_idle.find(key);
+        if (it != m_idle.end() && !it->second.empty()) {
+            // most recently used session has the most chances to keep connection alive
+            std::unique_ptr<cpr::Session> session = std::move(it->second.back().session);
+            it->second.pop_back();
+            return lease(this, key, std::move(session));
+        }
+    }
+
+    return lease(this, key, create_session());
+}
+
+size_t miledger::net::session_pool::idle_size() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    size_t out = 0;
+    for (const auto& it : m_idle) {
+        out += it.second.size();
+    }
+    return out;
+}
+
+void miledger::net::session_pool::clear() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_idle.clear();
+}
+
+std::unique_ptr<cpr::Session> miledger::net::session_pool::create_session() const {
+    auto session = std::make_unique<cpr::Session>();
+    CURL* handle = session->GetCurlHolder()->handle;
+    long idle_timeout;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        idle_timeout = (long) m_opts.idle_timeout.count();
+    }
+
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, 15L);
+    // don't reuse connection that was idle longer than pool keeps session
+    curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, idle_timeout);
+
+    return session;
+}
+
+void miledger::net::session_pool::release(const std::string& key, std::unique_ptr<cpr::Session> session) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto& idle = m_idle[key];
+    if (idle.size() >= m_opts.max_per_host) {
+        // pool is full, session will be closed with it's connection
+        return;
+    }
+    idle.push_back(idle_entry{std::move(session), clock_t::now()});
+}
+
+void miledger::net::session_pool::evict_expired(clock_t::time_point now) {
+    auto it = m_idle.begin();
+    while (it != m_idle.end()) {
+        auto& idle = it->second;
+        while (!idle.empty() && (now - idle.front().since) >= m_opts.idle_timeout) {
+            idle.pop_front();
+        }
+        while (idle.size() > m_opts.max_per_host) {
+            idle.pop_front();
+        }
+
+        if (idle.empty()) {
+            it = m_idle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -12,4 +12,12 @@
 QString const Settings::KEY_MINTER_PID = "app_pid";
 QString const Settings::KEY_SERVER_PORT = "server_port";
 QString const Settings::KEY_SERVER_ADDRESS = "server_address";
-QString const Settings::KEY_SERVER_CLOSE_TRAY = "server_close_to_tray";
\ No newline at end of file
+QString const Settings::KEY_SERVER_CLOSE_TRAY = "server_close_to_tray";
+QString const Settings::KEY_NET_POOL_SIZE = "net_pool_size";
+QString const Settings::KEY_NET_POOL_IDLE_TIMEOUT = "net_pool_idle_timeout";
+QString const Settings::KEY_NET_CACHE_SIZE = "net_cache_size";
+QString const Settings::KEY_NET_DNS_TTL = "net_dns_ttl";
+QString const Settings::KEY_NET_HOST_CONCURRENCY = "net_host_concurrency";
+QString const Settings::KEY_NET_TRANSPORT = "net_transport";
+QString const Settings::KEY_NET_EXPLORER_URLS = "net_explorer_urls";
+QString const Settings::KEY_NET_GATE_URLS = "net_gate_urls";
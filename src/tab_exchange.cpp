@@ -62,11 +62,11 @@ void Ui::TabExchange::onBalanceUpdated(explorer::balance_items result) {
 void Ui::TabExchange::onInitDataUpdated(miledger::repo::tx_init_data) {
 }
 
-void Ui::TabExchange::onCoinListUpdated(std::vector<explorer::coin_item>) {
+void Ui::TabExchange::onCoinListUpdated(std::vector<explorer::coin_item> coins) {
     // buyCoinToBuy
     qDebug() << "Coins list loaded";
 
-    coinsModel.setItems(app->getCoins());
+    coinsModel.setItems(coins);
 }
 
 void Ui::TabExchange::setDeviceAvailable(bool) {
@@ -86,83 +86,126 @@ std::shared_ptr<minter::tx> createBaseTx(
     return buildTx(txBuilder);
 }
 
-std::shared_ptr<minter::tx> Ui::TabExchange::createBuyTx(miledger::repo::tx_init_data initData) {
-    return createBaseTx(initData, buyForm->gasCoin, [this, initData](std::shared_ptr<minter::tx_builder> txBuilder) {
-        if (buyForm->estimateResult.exchangeViaPools()) {
+std::shared_ptr<minter::tx> Ui::TabExchange::createBuyTx(miledger::repo::tx_init_data initData, const TxParams& params) {
+    return createBaseTx(initData, params.gasCoin, [initData, &params](std::shared_ptr<minter::tx_builder> txBuilder) {
+        if (params.estimate.exchangeViaPools()) {
             auto dataBuilder = txBuilder->tx_buy_swap_pool();
-            for (const auto& coin : buyForm->estimateResult.route.coins) {
+            for (const auto& coin : params.estimate.route.coins) {
                 dataBuilder->add_coin(coin.id);
             }
-            dataBuilder->set_max_value_to_sell(buyForm->maxValueToSell);
-            dataBuilder->set_value_to_buy(buyForm->amount);
+            dataBuilder->set_max_value_to_sell(params.limit);
+            dataBuilder->set_value_to_buy(params.amount);
             return dataBuilder->build();
         } else {
             auto dataBuilder = txBuilder->tx_buy_coin();
-            dataBuilder->set_coin_id_to_buy(buyForm->coinToBuy.id);
-            dataBuilder->set_coin_id_to_sell(buyForm->coinToSell.id);
-            dataBuilder->set_max_value_to_sell(buyForm->maxValueToSell);
-            dataBuilder->set_value_to_buy(buyForm->amount);
+            dataBuilder->set_coin_id_to_buy(params.coinToBuy);
+            dataBuilder->set_coin_id_to_sell(params.coinToSell);
+            dataBuilder->set_max_value_to_sell(params.limit);
+            dataBuilder->set_value_to_buy(params.amount);
             return dataBuilder->build();
         }
     });
 }
 
-std::shared_ptr<minter::tx> Ui::TabExchange::createSellTx(miledger::repo::tx_init_data initData) {
-    return createBaseTx(initData, sellForm->gasCoin, [this, initData](std::shared_ptr<minter::tx_builder> txBuilder) {
-        if (sellForm->estimateResult.exchangeViaPools()) {
+std::shared_ptr<minter::tx> Ui::TabExchange::createSellTx(miledger::repo::tx_init_data initData, const TxParams& params) {
+    return createBaseTx(initData, params.gasCoin, [initData, &params](std::shared_ptr<minter::tx_builder> txBuilder) {
+        if (params.estimate.exchangeViaPools()) {
             auto dataBuilder = txBuilder->tx_sell_swap_pool();
-            for (const auto& coin : sellForm->estimateResult.route.coins) {
+            for (const auto& coin : params.estimate.route.coins) {
                 dataBuilder->add_coin(coin.id);
             }
-            dataBuilder->set_min_value_to_buy(sellForm->minValueToBuy);
-            dataBuilder->set_value_to_sell(sellForm->amount);
+            dataBuilder->set_min_value_to_buy(params.limit);
+            dataBuilder->set_value_to_sell(params.amount);
             return dataBuilder->build();
         } else {
             auto dataBuilder = txBuilder->tx_sell_coin();
-            dataBuilder->set_coin_id_to_buy(sellForm->coinToBuy.id);
-            dataBuilder->set_coin_id_to_sell(sellForm->coinToSell.id);
-            dataBuilder->set_min_value_to_buy(sellForm->minValueToBuy);
-            dataBuilder->set_value_to_sell(sellForm->amount);
+            dataBuilder->set_coin_id_to_buy(params.coinToBuy);
+            dataBuilder->set_coin_id_to_sell(params.coinToSell);
+            dataBuilder->set_min_value_to_buy(params.limit);
+            dataBuilder->set_value_to_sell(params.amount);
             return dataBuilder->build();
         }
     });
 }
 
-std::shared_ptr<minter::tx> Ui::TabExchange::createSellAllTx(miledger::repo::tx_init_data initData) {
-    return createBaseTx(initData, sellAllForm->gasCoin, [this, initData](std::shared_ptr<minter::tx_builder> txBuilder) {
-        if (sellAllForm->estimateResult.exchangeViaPools()) {
+std::shared_ptr<minter::tx> Ui::TabExchange::createSellAllTx(miledger::repo::tx_init_data initData, const TxParams& params) {
+    return createBaseTx(initData, params.gasCoin, [initData, &params](std::shared_ptr<minter::tx_builder> txBuilder) {
+        if (params.estimate.exchangeViaPools()) {
             auto dataBuilder = txBuilder->tx_sell_all_swap_pool();
-            for (const auto& coin : sellAllForm->estimateResult.route.coins) {
+            for (const auto& coin : params.estimate.route.coins) {
                 dataBuilder->add_coin(coin.id);
             }
-            dataBuilder->set_min_value_to_buy(sellAllForm->minValueToBuy);
+            dataBuilder->set_min_value_to_buy(params.limit);
             return dataBuilder->build();
         } else {
             auto dataBuilder = txBuilder->tx_sell_all_coins();
-            dataBuilder->set_coin_id_to_buy(sellAllForm->coinToBuy.id);
-            dataBuilder->set_coin_id_to_sell(sellAllForm->coinToSell.id);
-            dataBuilder->set_min_value_to_buy(sellAllForm->minValueToBuy);
+            dataBuilder->set_coin_id_to_buy(params.coinToBuy);
+            dataBuilder->set_coin_id_to_sell(params.coinToSell);
+            dataBuilder->set_min_value_to_buy(params.limit);
             return dataBuilder->build();
         }
     });
 }
 
+Ui::TabExchange::TxParams Ui::TabExchange::captureTxParams(ExchangeFormBy exchangeBy) const {
+    TxParams params;
+    switch (exchangeBy) {
+    case Buy:
+        params.estimate = buyForm->estimateResult;
+        params.gasCoin = buyForm->gasCoin;
+        params.coinToBuy = buyForm->coinToBuy.id;
+        params.coinToSell = buyForm->coinToSell.id;
+        params.amount = buyForm->amount;
+        params.limit = buyForm->maxValueToSell;
+        break;
+    case Sell:
+        params.estimate = sellForm->estimateResult;
+        params.gasCoin = sellForm->gasCoin;
+        params.coinToBuy = sellForm->coinToBuy.id;
+        params.coinToSell = sellForm->coinToSell.id;
+        params.amount = sellForm->amount;
+        params.limit = sellForm->minValueToBuy;
+        break;
+    case SellAll:
+        params.estimate = sellAllForm->estimateResult;
+        params.gasCoin = sellAllForm->gasCoin;
+        params.coinToBuy = sellAllForm->coinToBuy.id;
+        params.coinToSell = sellAllForm->coinToSell.id;
+        params.limit = sellAllForm->minValueToBuy;
+        break;
+    }
+    return params;
+}
+
 rxcpp::observable<minter::gate::tx_send_result> Ui::TabExchange::createTxSender(ExchangeFormBy exchangeBy) {
-    return rxcpp::observable<>::create<gate::tx_send_result>([this, exchangeBy](rxcpp::subscriber<gate::tx_send_result> emitter) {
-        app->getInitDataUpdater()
+    // sender is subscribed on io thread, form values are taken here, on UI thread
+    const TxParams params = captureTxParams(exchangeBy);
+    auto verified = verifyEstimate(exchangeBy, params.estimate);
+    return rxcpp::observable<>::create<gate::tx_send_result>([this, exchangeBy, params, verified](rxcpp::subscriber<gate::tx_send_result> emitter) {
+        verified
+            .flat_map([this, params](miledger::EstimateResult estimate) {
+                TxParams out = params;
+                out.estimate = std::move(estimate);
+                return app->getInitDataUpdater()
+                    .map([out](miledger::repo::tx_init_data initData) {
+                        return std::make_pair(initData, out);
+                    });
+            })
             .subscribe(
-                [this, &emitter, exchangeBy](miledger::repo::tx_init_data initData) {
+                [this, &emitter, exchangeBy](std::pair<miledger::repo::tx_init_data, TxParams> data) {
+                    const auto& initData = data.first;
+                    const auto& txParams = data.second;
                     std::shared_ptr<minter::tx> tx;
                     dev::bytes_32 rawTx;
                     switch (exchangeBy) {
                     case Buy:
-                        tx = createBuyTx(initData);
+                        tx = createBuyTx(initData, txParams);
                         break;
                     case Sell:
-                        tx = createSellTx(initData);
+                        tx = createSellTx(initData, txParams);
                         break;
                     case SellAll:
-                        tx = createSellAllTx(initData);
+                        tx = createSellAllTx(initData, txParams);
                         break;
                     }
                     rawTx = tx->get_unsigned_hash();
@@ -195,6 +238,25 @@ rxcpp::observable<minter::gate::tx_send_result> Ui::TabExchange::createTxSender(
     });
 }
 
+rxcpp::observable<miledger::EstimateResult> Ui::TabExchange::verifyEstimate(ExchangeFormBy exchangeBy, const miledger::EstimateResult& estimate) {
+    const miledger::ExchangeCalculator* calculator = nullptr;
+    switch (exchangeBy) {
+    case Buy:
+        calculator = &buyForm->exchangeCalculator;
+        break;
+    case Sell:
+        calculator = &sellForm->exchangeCalculator;
+        break;
+    case SellAll:
+        calculator = &sellAllForm->exchangeCalculator;
+        break;
+    }
+
+    // transaction is built by returned estimate, so route and amount from local pool graph are replaced by remote ones.
+    // Form is not touched: it belongs to UI thread, and verification finishes on io thread
+    return calculator->verify(estimate);
+}
+
 void Ui::TabExchange::dialogSubmit(rxcpp::observable<minter::gate::tx_send_result> sender, Ui::ExchangeForm* form) {
     showProgressDialog("Sending transaction...");
 
@@ -0,0 +1,56 @@
+/*!
+ * miledger.
+ * tab_history.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/tab_history.h"
+
+#include <QDebug>
+#include <QHeaderView>
+
+Ui::TabHistory::TabHistory(miledger::ConsoleApp* app, QWidget* parent)
+    : TabBase(app, parent),
+      table(new QTableView(this)),
+      model(new TxHistoryModel(app->txPaginator, this)) {
+
+    table->setModel(model);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->setVisible(false);
+    // fixed row height: view doesn't measure every row, only visible ones are asked for data
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    table->horizontalHeader()->setStretchLastSection(true);
+    getLayout()->addWidget(table, 0, 0, 1, 1);
+
+    connect(model, &TxHistoryModel::loadFailed, this, &Ui::TabHistory::onLoadFailed);
+    connect(app, &miledger::ConsoleApp::addressResolved, this, &Ui::TabHistory::onAddressResolved);
+    // balance changes mostly because of new transaction
+    connect(app, SIGNAL(balanceUpdated(minter::explorer::balance_items)), this, SLOT(onBalanceUpdated(minter::explorer::balance_items)));
+
+    if (app->address) {
+        model->setAddress(app->address);
+    }
+}
+
+Ui::TabHistory::~TabHistory() {
+}
+
+void Ui::TabHistory::setDeviceAvailable(bool) {
+}
+
+void Ui::TabHistory::onAddressResolved(const minter::address_t& address) {
+    model->setAddress(address);
+}
+
+void Ui::TabHistory::onBalanceUpdated(minter::explorer::balance_items) {
+    model->refresh();
+}
+
+void Ui::TabHistory::onLoadFailed(QString error) {
+    qDebug() << "Unable to load transactions: " << error;
+}
@@ -0,0 +1,51 @@
+/*!
+ * miledger.
+ * transport.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/transport.h"
+
+#include "include/net/curl_engine.h"
+#include "include/net/qt_transport.h"
+
+#include <atomic>
+
+namespace {
+std::atomic<miledger::net::transport::kind> selected_kind{miledger::net::transport::kind::curl};
+std::atomic_bool created{false};
+} // namespace
+
+miledger::net::transport& miledger::net::transport::get() {
+    created = true;
+    switch (selected_kind.load()) {
+    case kind::qt:
+        return qt_transport::get();
+    case kind::curl:
+        break;
+    }
+    return curl_engine::get();
+}
+
+bool miledger::net::transport::select(const std::string& name) {
+    kind k;
+    if (name == "curl") {
+        k = kind::curl;
+    } else if (name == "qt") {
+        k = kind::qt;
+    } else {
+        return false;
+    }
+    // calls may already be running on the created backend
+    if (!created) {
+        selected_kind = k;
+    }
+    return true;
+}
+
+miledger::net::transport::kind miledger::net::transport::get_kind() {
+    return selected_kind.load();
+}
@@ -0,0 +1,182 @@
+/*!
+ * miledger.
+ * tx_history_model.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/tx_history_model.h"
+
+#include "include/rxqt_instance.hpp"
+#include "include/utils.h"
+
+TxHistoryModel::TxHistoryModel(miledger::repo::tx_paginator& paginator, QObject* parent)
+    : QAbstractTableModel(parent),
+      mPaginator(paginator) {
+}
+
+TxHistoryModel::~TxHistoryModel() {
+    if (mSubs.is_subscribed()) {
+        mSubs.unsubscribe();
+    }
+}
+
+void TxHistoryModel::setAddress(const minter::address_t& address) {
+    mAddress = address;
+    mHasAddress = true;
+    reset();
+}
+
+void TxHistoryModel::refresh() {
+    if (!mHasAddress) {
+        return;
+    }
+    const uint64_t generation = mGeneration;
+    // finished call leaves mSubs, otherwise it would grow with every refresh
+    rxcpp::composite_subscription lifetime;
+    mSubs.add(lifetime);
+    auto done = [this, lifetime]() {
+        mSubs.remove(lifetime);
+    };
+    mPaginator.refresh(mAddress)
+        .observe_on(RxQt::get().uiThread())
+        .subscribe(
+            lifetime,
+            [this, generation](bool changed) {
+                if (changed && generation == mGeneration) {
+                    reset();
+                }
+            },
+            [this, done](const std::exception_ptr& e) {
+                done();
+                emit loadFailed(miledger::utils::getError(e));
+            },
+            done);
+}
+
+int TxHistoryModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : (int) mRows.size();
+}
+
+int TxHistoryModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnsCount;
+}
+
+QVariant TxHistoryModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= (int) mRows.size()) {
+        return QVariant();
+    }
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) {
+        return QVariant();
+    }
+
+    const auto& tx = mRows[index.row()];
+    switch (index.column()) {
+    case ColumnHash:
+        return QString::fromStdString(tx.hash.to_string());
+    case ColumnHeight:
+        return QString::fromStdString(minter::utils::to_string(tx.height));
+    case ColumnTime:
+        return QString::fromStdString(tx.timestamp);
+    case ColumnType:
+        return (int) tx.type;
+    case ColumnFrom:
+        return QString::fromStdString(tx.from.to_string());
+    default:
+        return QVariant();
+    }
+}
+
+QVariant TxHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch (section) {
+    case ColumnHash:
+        return tr("Hash");
+    case ColumnHeight:
+        return tr("Block");
+    case ColumnTime:
+        return tr("Time");
+    case ColumnType:
+        return tr("Type");
+    case ColumnFrom:
+        return tr("From");
+    default:
+        return QVariant();
+    }
+}
+
+bool TxHistoryModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && mHasAddress && !mLoading && !mEnd;
+}
+
+void TxHistoryModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    mLoading = true;
+    const uint64_t generation = mGeneration;
+    rxcpp::composite_subscription lifetime;
+    mSubs.add(lifetime);
+    auto done = [this, lifetime]() {
+        mSubs.remove(lifetime);
+    };
+    mPaginator.get_page(mAddress, mNextPage)
+        .observe_on(RxQt::get().uiThread())
+        .subscribe(
+            lifetime,
+            [this, generation](miledger::repo::tx_paginator::page page) {
+                if (generation != mGeneration) {
+                    return;
+                }
+                mLoading = false;
+                appendPage(std::move(page));
+            },
+            [this, generation, done](const std::exception_ptr& e) {
+                done();
+                if (generation != mGeneration) {
+                    return;
+                }
+                // view will ask for this page again
+                mLoading = false;
+                emit loadFailed(miledger::utils::getError(e));
+            },
+            done);
+}
+
+void TxHistoryModel::reset() {
+    beginResetModel();
+    mGeneration++;
+    mRows.clear();
+    mHashes.clear();
+    mNextPage = 1;
+    mLoading = false;
+    mEnd = false;
+    endResetModel();
+}
+
+void TxHistoryModel::appendPage(miledger::repo::tx_paginator::page&& page) {
+    mNextPage = page.number + 1;
+    mEnd = page.last;
+
+    std::vector<minter::explorer::transaction_item> fresh;
+    fresh.reserve(page.items.size());
+    for (auto& tx : page.items) {
+        if (mHashes.insert(tx.hash.to_string()).second) {
+            fresh.push_back(std::move(tx));
+        }
+    }
+    if (fresh.empty()) {
+        // no rows inserted, so view won't ask for more by itself
+        fetchMore(QModelIndex());
+        return;
+    }
+
+    const int first = (int) mRows.size();
+    beginInsertRows(QModelIndex(), first, first + (int) fresh.size() - 1);
+    mRows.insert(mRows.end(), std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+    endInsertRows();
+}
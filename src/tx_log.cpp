@@ -0,0 +1,449 @@
+/*!
+ * miledger.
+ * tx_log.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/tx_log.h"
+
+#include "include/net/api_store.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+const char log_magic[8] = {'M', 'L', 'T', 'L', 0, 0, 0, 1};
+const char index_magic[8] = {'M', 'L', 'T', 'I', 0, 0, 0, 1};
+} // namespace
+
+miledger::repo::tx_log::tx_log(const miledger::repo::explorer_repo& repo, const minter::address_t& address, const std::string& dir)
+    : m_repo(repo)
+    , m_address(address)
+    , m_address_str(address.to_string()) {
+    const QString base = QString::fromStdString(dir);
+    QDir().mkpath(base);
+    m_log.setFileName(QDir::toNativeSeparators(base + "/" + QString::fromStdString(m_address_str) + ".txlog"));
+    m_index.setFileName(QDir::toNativeSeparators(base + "/" + QString::fromStdString(m_address_str) + ".txidx"));
+}
+
+miledger::repo::tx_log::~tx_log() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    unmap_files();
+    m_log.close();
+}
+
+bool miledger::repo::tx_log::open() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    unmap_files();
+    m_log.close();
+    m_pending = index_data();
+    m_pending_hashes.clear();
+
+    if (!m_log.open(QIODevice::ReadWrite)) {
+        qDebug() << "Unable to open transaction log" << m_log.fileName() << ":" << m_log.errorString();
+        return false;
+    }
+    char magic[sizeof(log_magic)] = {0};
+    if (m_log.size() < (qint64) sizeof(log_magic) || m_log.read(magic, sizeof(magic)) != sizeof(magic)
+        || std::memcmp(magic, log_magic, sizeof(log_magic)) != 0) {
+        // new or unknown file
+        m_log.resize(0);
+        m_log.seek(0);
+        m_log.write(log_magic, sizeof(log_magic));
+        m_log.flush();
+    }
+    m_log_size = (uint64_t) m_log.size();
+    map_files();
+
+    const uint64_t covered = m_header ? m_header->log_size : sizeof(log_magic);
+    m_synced_height = m_header ? m_header->synced_height : 0;
+    if (covered != m_log_size) {
+        // crash between log append and index write
+        index_data data = read_index();
+        recover(data, covered);
+        write_index(std::move(data), m_synced_height);
+    }
+    return true;
+}
+
+rxcpp::observable<size_t> miledger::repo::tx_log::sync() {
+    return rxcpp::observable<>::defer([this]() {
+               uint64_t start;
+               {
+                   std::lock_guard<std::mutex> lock(m_lock);
+                   start = m_synced_height + 1;
+               }
+               // newest block of the first page: later pages are requested up to it, so new blocks don't shift them
+               auto head = std::make_shared<uint64_t>(0);
+
+               return fetch_page(start, 0, 1)
+                   .flat_map([this, start, head](const nlohmann::json& first) {
+                       uint32_t last_page = 1;
+                       if (first.contains("meta") && first.at("meta").contains("last_page")) {
+                           last_page = first.at("meta").at("last_page").get<uint32_t>();
+                       }
+                       if (first.contains("data")) {
+                           for (const auto& tx : first.at("data")) {
+                               *head = std::max(*head, tx.value("height", (uint64_t) 0));
+                           }
+                       }
+
+                       size_t added;
+                       {
+                           std::lock_guard<std::mutex> lock(m_lock);
+                           added = append_page(first);
+                       }
+                       auto out = rxcpp::observable<>::just(added).as_dynamic();
+                       if (last_page <= 1) {
+                           return out;
+                       }
+                       auto rest = rxcpp::observable<>::range<uint32_t>(2, last_page)
+                                       .concat_map([this, start, head](uint32_t page) {
+                                           return fetch_page(start, *head, page);
+                                       })
+                                       .map([this](const nlohmann::json& page) {
+                                           std::lock_guard<std::mutex> lock(m_lock);
+                                           return append_page(page);
+                                       });
+                       return out.concat(rest).as_dynamic();
+                   })
+                   .sum()
+                   .map([this, head](size_t added) {
+                       std::lock_guard<std::mutex> lock(m_lock);
+                       index_data data = read_index();
+                       data.blocks.insert(data.blocks.end(), m_pending.blocks.begin(), m_pending.blocks.end());
+                       data.hashes.insert(data.hashes.end(), m_pending.hashes.begin(), m_pending.hashes.end());
+                       data.parties.insert(data.parties.end(), m_pending.parties.begin(), m_pending.parties.end());
+                       m_pending = index_data();
+                       m_pending_hashes.clear();
+                       write_index(std::move(data), std::max(m_synced_height, *head));
+                       return added;
+                   });
+           })
+        .as_dynamic();
+}
+
+optns::optional<minter::explorer::transaction_item> miledger::repo::tx_log::find_by_hash(const std::string& hash) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_header) {
+        return {};
+    }
+    const uint64_t fp = fingerprint(hash);
+    const hash_entry* end = m_hashes + m_header->count;
+    auto it = std::lower_bound(m_hashes, end, fp, [](const hash_entry& e, uint64_t value) {
+        return e.hash < value;
+    });
+    for (; it != end && it->hash == fp; ++it) {
+        // fingerprint may collide, compare real hash
+        const nlohmann::json tx = read_json(it->offset);
+        if (tx.value("hash", std::string()) == hash) {
+            return tx.get<minter::explorer::transaction_item>();
+        }
+    }
+    return {};
+}
+
+std::vector<minter::explorer::transaction_item> miledger::repo::tx_log::find_by_blocks(uint64_t from, uint64_t to, size_t limit) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<minter::explorer::transaction_item> out;
+    if (!m_header) {
+        return out;
+    }
+    const block_entry* end = m_blocks + m_header->count;
+    auto it = std::lower_bound(m_blocks, end, from, [](const block_entry& e, uint64_t value) {
+        return e.height < value;
+    });
+    for (; it != end && it->height <= to && (limit == 0 || out.size() < limit); ++it) {
+        out.push_back(read_json(it->offset).get<minter::explorer::transaction_item>());
+    }
+    return out;
+}
+
+std::vector<minter::explorer::transaction_item> miledger::repo::tx_log::find_by_counterparty(const std::string& address, size_t limit) const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::vector<minter::explorer::transaction_item> out;
+    if (!m_header) {
+        return out;
+    }
+    const uint64_t fp = fingerprint(address);
+    const party_entry* end = m_parties + m_header->party_count;
+    auto it = std::lower_bound(m_parties, end, fp, [](const party_entry& e, uint64_t value) {
+        return e.party < value;
+    });
+    for (; it != end && it->party == fp && (limit == 0 || out.size() < limit); ++it) {
+        out.push_back(read_json(it->offset).get<minter::explorer::transaction_item>());
+    }
+    return out;
+}
+
+const minter::address_t& miledger::repo::tx_log::address() const {
+    return m_address;
+}
+
+uint64_t miledger::repo::tx_log::synced_height() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_synced_height;
+}
+
+size_t miledger::repo::tx_log::size() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_header ? (size_t) m_header->count : 0;
+}
+
+size_t miledger::repo::tx_log::append_page(const nlohmann::json& page) {
+    if (!page.contains("data") || !page.at("data").is_array()) {
+        return 0;
+    }
+
+    size_t added = 0;
+    m_log.seek(m_log.size());
+    for (const auto& tx : page.at("data")) {
+        const uint64_t hash = fingerprint(tx.value("hash", std::string()));
+        // already stored by interrupted sync
+        if (has_hash(hash)) {
+            continue;
+        }
+
+        const std::string raw = tx.dump();
+        record_header hdr;
+        hdr.length = (uint32_t) raw.size();
+        hdr.reserved = 0;
+        hdr.height = tx.value("height", (uint64_t) 0);
+        hdr.checksum = miledger::net::api_store::hash(raw.data(), raw.size());
+
+        const uint64_t offset = m_log_size;
+        if (m_log.write((const char*) &hdr, sizeof(hdr)) != sizeof(hdr)
+            || m_log.write(raw.data(), (qint64) raw.size()) != (qint64) raw.size()) {
+            throw std::runtime_error("Unable to write transaction log: " + m_log.errorString().toStdString());
+        }
+        m_log_size += sizeof(hdr) + raw.size();
+
+        add_entries(m_pending, tx, hdr.height, offset);
+        m_pending_hashes.insert(hash);
+        added++;
+    }
+    m_log.flush();
+    return added;
+}
+
+void miledger::repo::tx_log::add_entries(index_data& out, const nlohmann::json& tx, uint64_t height, uint64_t offset) const {
+    out.blocks.push_back(block_entry{height, offset});
+    out.hashes.push_back(hash_entry{fingerprint(tx.value("hash", std::string())), offset});
+
+    // sender and recipients except the log owner
+    std::unordered_set<std::string> parties;
+    parties.insert(tx.value("from", std::string()));
+    if (tx.contains("data") && tx.at("data").is_object()) {
+        const auto& data = tx.at("data");
+        if (data.contains("to") && data.at("to").is_string()) {
+            parties.insert(data.at("to").get<std::string>());
+        }
+        if (data.contains("list") && data.at("list").is_array()) {
+            for (const auto& item : data.at("list")) {
+                if (item.is_object() && item.contains("to") && item.at("to").is_string()) {
+                    parties.insert(item.at("to").get<std::string>());
+                }
+            }
+        }
+    }
+    for (const auto& party : parties) {
+        if (party.empty() || party == m_address_str) {
+            continue;
+        }
+        out.parties.push_back(party_entry{fingerprint(party), height, offset});
+    }
+}
+
+bool miledger::repo::tx_log::write_index(index_data&& data, uint64_t synced_height) {
+    std::sort(data.blocks.begin(), data.blocks.end(), [](const block_entry& left, const block_entry& right) {
+        return left.height != right.height ? left.height < right.height : left.offset < right.offset;
+    });
+    std::sort(data.hashes.begin(), data.hashes.end(), [](const hash_entry& left, const hash_entry& right) {
+        return left.hash != right.hash ? left.hash < right.hash : left.offset < right.offset;
+    });
+    std::sort(data.parties.begin(), data.parties.end(), [](const party_entry& left, const party_entry& right) {
+        if (left.party != right.party) {
+            return left.party < right.party;
+        }
+        return left.height != right.height ? left.height < right.height : left.offset < right.offset;
+    });
+
+    index_header hdr;
+    std::memcpy(hdr.magic, index_magic, sizeof(index_magic));
+    hdr.count = data.blocks.size();
+    hdr.party_count = data.parties.size();
+    hdr.synced_height = synced_height;
+    hdr.log_size = m_log_size;
+
+    // written aside and renamed over the index: crash in the middle leaves the old one, which is recovered from log
+    QSaveFile out(m_index.fileName());
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    out.write((const char*) &hdr, sizeof(hdr));
+    out.write((const char*) data.blocks.data(), (qint64) (data.blocks.size() * sizeof(block_entry)));
+    out.write((const char*) data.hashes.data(), (qint64) (data.hashes.size() * sizeof(hash_entry)));
+    out.write((const char*) data.parties.data(), (qint64) (data.parties.size() * sizeof(party_entry)));
+
+    // mapped file can't be replaced on some platforms
+    unmap_files();
+    const bool ok = out.commit();
+    map_files();
+    if (ok) {
+        m_synced_height = synced_height;
+    }
+    return ok;
+}
+
+miledger::repo::tx_log::index_data miledger::repo::tx_log::read_index() const {
+    index_data out;
+    if (!m_header) {
+        return out;
+    }
+    out.blocks.assign(m_blocks, m_blocks + m_header->count);
+    out.hashes.assign(m_hashes, m_hashes + m_header->count);
+    out.parties.assign(m_parties, m_parties + m_header->party_count);
+    return out;
+}
+
+void miledger::repo::tx_log::map_files() {
+    if (m_log_size > 0) {
+        m_log_map = m_log.map(0, (qint64) m_log_size);
+    }
+
+    if (!m_index.exists() || !m_index.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const qint64 size = m_index.size();
+    if (size >= (qint64) sizeof(index_header)) {
+        m_index_map = m_index.map(0, size);
+    }
+    if (!m_index_map) {
+        m_index.close();
+        return;
+    }
+
+    const auto* hdr = reinterpret_cast<const index_header*>(m_index_map);
+    const uint64_t expected = sizeof(index_header)
+                              + hdr->count * (sizeof(block_entry) + sizeof(hash_entry))
+                              + hdr->party_count * sizeof(party_entry);
+    if (std::memcmp(hdr->magic, index_magic, sizeof(index_magic)) != 0 || expected != (uint64_t) size
+        || hdr->log_size > m_log_size) {
+        // unknown format or index of another log: rebuilt from log
+        m_index.unmap(const_cast<uchar*>(m_index_map));
+        m_index_map = nullptr;
+        m_index.close();
+        return;
+    }
+
+    m_header = hdr;
+    m_blocks = reinterpret_cast<const block_entry*>(m_index_map + sizeof(index_header));
+    m_hashes = reinterpret_cast<const hash_entry*>(m_blocks + hdr->count);
+    m_parties = reinterpret_cast<const party_entry*>(m_hashes + hdr->count);
+}
+
+void miledger::repo::tx_log::unmap_files() {
+    if (m_log_map) {
+        m_log.unmap(const_cast<uchar*>(m_log_map));
+        m_log_map = nullptr;
+    }
+    if (m_index_map) {
+        m_index.unmap(const_cast<uchar*>(m_index_map));
+        m_index_map = nullptr;
+    }
+    m_index.close();
+    m_header = nullptr;
+    m_blocks = nullptr;
+    m_hashes = nullptr;
+    m_parties = nullptr;
+}
+
+void miledger::repo::tx_log::recover(index_data& data, uint64_t from) {
+    uint64_t pos = std::max<uint64_t>(from, sizeof(log_magic));
+    std::unordered_set<uint64_t> known;
+    for (const auto& e : data.hashes) {
+        known.insert(e.hash);
+    }
+
+    while (m_log_map && pos + sizeof(record_header) <= m_log_size) {
+        record_header hdr;
+        std::memcpy(&hdr, m_log_map + pos, sizeof(hdr));
+        const uint64_t end = pos + sizeof(hdr) + hdr.length;
+        if (end > m_log_size) {
+            break;
+        }
+        const char* body = (const char*) m_log_map + pos + sizeof(hdr);
+        if (miledger::net::api_store::hash(body, hdr.length) != hdr.checksum) {
+            // torn write: everything after it is unreliable
+            break;
+        }
+        const auto tx = nlohmann::json::parse(body, body + hdr.length, nullptr, false);
+        if (tx.is_discarded()) {
+            break;
+        }
+        if (known.insert(fingerprint(tx.value("hash", std::string()))).second) {
+            add_entries(data, tx, hdr.height, pos);
+        }
+        pos = end;
+    }
+
+    if (pos < m_log_size) {
+        unmap_files();
+        m_log.resize((qint64) pos);
+        m_log_size = pos;
+        map_files();
+    }
+}
+
+nlohmann::json miledger::repo::tx_log::read_json(uint64_t offset) const {
+    record_header hdr;
+    std::memcpy(&hdr, m_log_map + offset, sizeof(hdr));
+    const char* body = (const char*) m_log_map + offset + sizeof(hdr);
+    return nlohmann::json::parse(body, body + hdr.length);
+}
+
+bool miledger::repo::tx_log::has_hash(uint64_t hash) const {
+    if (m_pending_hashes.count(hash)) {
+        return true;
+    }
+    if (!m_header) {
+        return false;
+    }
+    const hash_entry* end = m_hashes + m_header->count;
+    auto it = std::lower_bound(m_hashes, end, hash, [](const hash_entry& e, uint64_t value) {
+        return e.hash < value;
+    });
+    return it != end && it->hash == hash;
+}
+
+uint64_t miledger::repo::tx_log::fingerprint(const std::string& value) {
+    return miledger::net::api_store::hash(value.data(), value.size());
+}
+
+rxcpp::observable<nlohmann::json> miledger::repo::tx_log::fetch_page(uint64_t start_block, uint64_t end_block, uint32_t page) const {
+    get_transactions_opt opts;
+    opts.page = page;
+    opts.start_block = dev::bigint(start_block);
+    if (end_block > 0) {
+        opts.end_block = dev::bigint(end_block);
+    }
+    opts.addresses.push_back(m_address);
+
+    return m_repo.get_transactions_json(opts)
+        .map([](nlohmann::json answer) {
+            if (answer.contains("error") && answer.at("error").is_object()) {
+                throw std::runtime_error(answer.at("error").value("message", std::string("Unknown explorer error")));
+            }
+            return answer;
+        })
+        .as_dynamic();
+}
@@ -0,0 +1,193 @@
+/*!
+ * miledger.
+ * tx_paginator.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/tx_paginator.h"
+
+#include <iterator>
+#include <stdexcept>
+
+miledger::repo::tx_paginator::tx_paginator(const miledger::repo::explorer_repo& repo)
+    : tx_paginator(repo, options()) {
+}
+
+miledger::repo::tx_paginator::tx_paginator(const miledger::repo::explorer_repo& repo, const options& opts)
+    : m_repo(repo)
+    , m_opts(opts) {
+}
+
+miledger::repo::tx_paginator::~tx_paginator() {
+    if (m_subs.is_subscribed()) {
+        m_subs.unsubscribe();
+    }
+}
+
+rxcpp::observable<miledger::repo::tx_paginator::page>
+miledger::repo::tx_paginator::get_page(const minter::address_t& address, uint32_t number) {
+    const std::string key = address.to_string();
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto& cache = m_cache[key];
+        if (cache.last_page != 0 && number > cache.last_page) {
+            page out;
+            out.number = number;
+            out.last = true;
+            return rxcpp::observable<>::just(out).as_dynamic();
+        }
+
+        auto it = cache.pages.find(number);
+        if (it != cache.pages.end()) {
+            page out;
+            out.number = number;
+            out.items = it->second;
+            out.last = cache.last_page == number;
+            prefetch(address, number);
+            return rxcpp::observable<>::just(std::move(out)).as_dynamic();
+        }
+        generation = cache.generation;
+    }
+
+    return fetch(address, number)
+        .map([this, address, key, generation, number](tx_list_t items) {
+            store(key, generation, number, items);
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                prefetch(address, number);
+            }
+            page out;
+            out.number = number;
+            out.last = items.size() < m_opts.page_size;
+            out.items = std::move(items);
+            return out;
+        })
+        .as_dynamic();
+}
+
+rxcpp::observable<bool> miledger::repo::tx_paginator::refresh(const minter::address_t& address) {
+    const std::string key = address.to_string();
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        generation = m_cache[key].generation;
+    }
+    return fetch(address, 1)
+        .map([this, key, generation](const tx_list_t& items) {
+            return store(key, generation, 1, items);
+        })
+        .as_dynamic();
+}
+
+void miledger::repo::tx_paginator::clear() {
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (auto& item : m_cache) {
+        item.second.pages.clear();
+        item.second.head_known = false;
+        item.second.last_page = 0;
+        item.second.generation++;
+    }
+}
+
+rxcpp::observable<miledger::repo::tx_list_t>
+miledger::repo::tx_paginator::fetch(const minter::address_t& address, uint32_t number) const {
+    return m_repo.get_transactions(address, number, m_opts.page_size)
+        .map([](minter::explorer::result<tx_list_t> res) {
+            if (!res.error.message.empty()) {
+                throw std::runtime_error(res.error.message);
+            }
+            return std::move(res.data);
+        })
+        .as_dynamic();
+}
+
+bool miledger::repo::tx_paginator::store(const std::string& key, uint64_t generation, uint32_t number, const tx_list_t& items) {
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto& cache = m_cache[key];
+
+    bool changed = false;
+    if (number == 1) {
+        auto head = head_of(items);
+        if (cache.head_known && (cache.head != head.first || cache.head_hash != head.second)) {
+            // all pages shifted
+            cache.pages.clear();
+            cache.last_page = 0;
+            cache.generation++;
+            changed = true;
+        }
+        cache.head = std::move(head.first);
+        cache.head_hash = std::move(head.second);
+        cache.head_known = true;
+        // refresh is fetched by current state, whatever generation it started with
+        generation = cache.generation;
+    }
+    if (generation != cache.generation) {
+        return changed;
+    }
+
+    cache.pages[number] = items;
+    if (items.size() < m_opts.page_size) {
+        cache.last_page = number;
+    }
+
+    while (cache.pages.size() > m_opts.max_pages) {
+        auto first = cache.pages.begin();
+        auto last = std::prev(cache.pages.end());
+        // keep pages around the one just stored
+        if (number - first->first > last->first - number) {
+            cache.pages.erase(first);
+        } else {
+            cache.pages.erase(last);
+        }
+    }
+    return changed;
+}
+
+void miledger::repo::tx_paginator::prefetch(const minter::address_t& address, uint32_t after) {
+    // called under lock
+    const std::string key = address.to_string();
+    auto& cache = m_cache[key];
+    for (uint32_t number = after + 1; number <= after + m_opts.prefetch; number++) {
+        if (cache.last_page != 0 && number > cache.last_page) {
+            break;
+        }
+        if (cache.pages.count(number) || cache.loading.count(number)) {
+            continue;
+        }
+        cache.loading.insert(number);
+        const uint64_t generation = cache.generation;
+
+        // finished prefetch leaves m_subs, otherwise it would grow with every scrolled page
+        rxcpp::composite_subscription lifetime;
+        m_subs.add(lifetime);
+        auto done = [this, key, number, lifetime]() {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_cache[key].loading.erase(number);
+            }
+            m_subs.remove(lifetime);
+        };
+        fetch(address, number)
+            .subscribe(
+                lifetime,
+                [this, key, generation, number](const tx_list_t& items) {
+                    store(key, generation, number, items);
+                },
+                [done](const std::exception_ptr&) {
+                    // page is fetched again when it's requested
+                    done();
+                },
+                done);
+    }
+}
+
+std::pair<dev::bigint, std::string> miledger::repo::tx_paginator::head_of(const tx_list_t& items) {
+    if (items.empty()) {
+        return {dev::bigint("0"), std::string()};
+    }
+    return {items.front().height, items.front().hash.to_string()};
+}
@@ -7,6 +7,7 @@
 #include "include/style_helper.h"
 #include "include/tab_base.h"
 #include "include/tab_exchange.h"
+#include "include/tab_history.h"
 #include "include/tab_send.h"
 #include "include/ui/serversettingsdialog.h"
 #include "include/utils.h"
@@ -320,6 +321,10 @@ void ConsoleWindow::onAppStarted() {
                           StyleHelper::get().icon("ic_tx_exchange"),
                           tr("Swap"));
 
+    ui->tabWidget->addTab(new Ui::TabHistory(app, nullptr),
+                          StyleHelper::get().icon("ic_refresh"),
+                          tr("History"));
+
     connect(ui->tabWidget, SIGNAL(currentChanged(int)), this, SLOT(onTabChanged(int)));
 }
 
@@ -47,7 +47,7 @@ TestWindow::TestWindow(QWidget* parent)
     auto res = explorerRepo.get_coins()
                    .as_blocking();
 
-    coins = res.first().data;
+    coins = res.first().value.data;
 
     CoinItemViewDelegate* delegate = new CoinItemViewDelegate(app);
     delegate->setIconUpdatedCallback([this](const QModelIndex& index) {
@@ -0,0 +1,60 @@
+/*!
+ * miledger.
+ * warmup.cpp
+ *
+ * \date 2021
+ * \author Eduard Maximovich (edward.vstock@gmail.com)
+ * \link   https://github.com/edwardstock
+ */
+
+#include "include/net/warmup.h"
+
+#include "include/net/transport.h"
+#include "include/net/fixtures.h"
+#include "include/net/metrics.h"
+
+#include <QUrl>
+#include <set>
+
+void miledger::net::warmup::start(const std::vector<std::string>& urls) {
+    if (m_started.exchange(true)) {
+        return;
+    }
+    // replay goes to local stand-in server, record would save warm-up exchanges as fixtures
+    if (fixtures::get().get_mode() != fixtures::mode::live) {
+        return;
+    }
+
+    std::set<std::string> origins;
+    for (const auto& url : urls) {
+        QUrl parsed(QString::fromStdString(url));
+        if (!parsed.isValid() || parsed.host().isEmpty()) {
+            continue;
+        }
+        // root of host: warm-up needs only connection, response itself is ignored
+        QUrl origin;
+        origin.setScheme(parsed.scheme());
+        origin.setHost(parsed.host());
+        origin.setPort(parsed.port());
+        origin.setPath("/");
+        origins.insert(origin.toString().toStdString());
+    }
+
+    m_pending = origins.size();
+    for (const auto& origin : origins) {
+        miledger::net::request req(QString::fromStdString(origin), miledger::net::request::method::head);
+        auto call = std::make_shared<http_call>(std::move(req), nullptr);
+        call->connect_timeout = std::chrono::seconds(5);
+        call->total_timeout = std::chrono::seconds(10);
+
+        const auto begin = std::chrono::steady_clock::now();
+        const std::string name = "warmup." + call->req.get_host().toStdString();
+        call->on_done = [this, begin, name](const std::shared_ptr<http_call>&) {
+            metrics_registry::get().record_timing(
+                name,
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin));
+            m_pending--;
+        };
+        transport::get().submit(std::move(call));
+    }
+}